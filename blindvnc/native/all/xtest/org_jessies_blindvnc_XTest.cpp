@@ -0,0 +1,46 @@
+#include "org_jessies_blindvnc_XTest.h"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/XTest.h>
+
+// We use our own connection rather than sharing AWT's, so we can flush when we choose and never wait for replies.
+static Display* display = 0;
+
+jboolean org_jessies_blindvnc_XTest::open() {
+    if (display != 0) {
+        return true;
+    }
+    display = XOpenDisplay(0);
+    if (display == 0) {
+        return false;
+    }
+    int eventBase, errorBase, majorVersion, minorVersion;
+    if (!XTestQueryExtension(display, &eventBase, &errorBase, &majorVersion, &minorVersion)) {
+        XCloseDisplay(display);
+        display = 0;
+        return false;
+    }
+    // Our events shouldn't be held up because some other client has grabbed the server.
+    XTestGrabControl(display, True);
+    return true;
+}
+
+void org_jessies_blindvnc_XTest::motion(jint x, jint y) {
+    // Screen -1 means the screen the pointer is currently on.
+    XTestFakeMotionEvent(display, -1, x, y, CurrentTime);
+}
+
+void org_jessies_blindvnc_XTest::button(jint button, jboolean isPress) {
+    XTestFakeButtonEvent(display, button, isPress, CurrentTime);
+}
+
+void org_jessies_blindvnc_XTest::key(jint keysym, jboolean isPress) {
+    KeyCode keycode = XKeysymToKeycode(display, keysym);
+    if (keycode != 0) {
+        XTestFakeKeyEvent(display, keycode, isPress, CurrentTime);
+    }
+}
+
+void org_jessies_blindvnc_XTest::flush() {
+    XFlush(display);
+}
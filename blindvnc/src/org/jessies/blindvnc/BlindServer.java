@@ -21,10 +21,10 @@ public class BlindServer implements Runnable {
     private DataInputStream in;
     private DataOutputStream out;
     private Options options;
-    private KeyCodeTranslator keyCodeTranslator = new KeyCodeTranslator();
     
     public BlindServer(InputStream in, OutputStream out, Options options) throws AWTException {
-        this.in = new DataInputStream(in);
+        // Buffered, so available() tells us whether the client has sent more than we've processed.
+        this.in = new DataInputStream(new BufferedInputStream(in));
         this.out = new DataOutputStream(out);
         this.options = options;
         desktop = new Desktop();
@@ -50,6 +50,10 @@ public class BlindServer implements Runnable {
             debug("Finished initialization");
             while (true) {
                 readMessageFromClient();
+                // Events are only passed on once we've caught up with the client, so a burst of pointer motion costs one move.
+                if (in.available() == 0) {
+                    desktop.flush();
+                }
             }
         } catch (Exception ex) {
             System.err.println("Terminating connection");
@@ -91,7 +95,7 @@ public class BlindServer implements Runnable {
             boolean isDown = (readUnsignedByte() != 0);
             discardBytes(2);  // Ignore padding.
             int vncKeyCode = in.readInt();
-            desktop.fireKeyEvent(keyCodeTranslator.getJavaKeyCode(vncKeyCode), isDown);
+            desktop.fireKeyEvent(vncKeyCode, isDown);
             break;
             
         case MSG_MOUSE_EVENT:
@@ -159,7 +163,6 @@ public class BlindServer implements Runnable {
     }
     
     private void discardBytes(int count) throws IOException {
-        byte[] bytes = new byte[count];
-        in.read(bytes);
+        in.readFully(new byte[count]);
     }
 }
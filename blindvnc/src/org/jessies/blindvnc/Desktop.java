@@ -7,10 +7,17 @@ import java.util.*;
 import java.util.List;
 
 public class Desktop {
+    private static final boolean USE_XTEST = openXTest();
+    
     private Rectangle bounds;
     private List<Monitor> monitors = new ArrayList<Monitor>();
     private Monitor currentMonitor;
     private int oldButtonMask = 0;
+    private KeyCodeTranslator keyCodeTranslator = new KeyCodeTranslator();
+    
+    // The latest pointer position we've been told about but not yet passed on, or null.
+    // Motion on its own is only interesting once we've caught up with the client, so we only send the last position before a flush, button change, or key event.
+    private Point pendingMotion;
     
     public Desktop() throws AWTException {
         Point topLeft = new Point(0, 0);
@@ -29,11 +36,27 @@ public class Desktop {
         currentMonitor = monitors.get(0);
     }
     
+    private static boolean openXTest() {
+        try {
+            if (XTest.open()) {
+                return true;
+            }
+            System.err.println("Couldn't use the XTEST extension; falling back to java.awt.Robot.");
+        } catch (LinkageError ex) {
+            System.err.println("Couldn't load XTEST support (" + ex.getMessage() + "); falling back to java.awt.Robot.");
+        }
+        return false;
+    }
+    
     public Dimension getSize() {
         return bounds.getSize();
     }
     
     private void setCurrentMonitor(Point point) {
+        // The pointer usually stays on the same monitor.
+        if (currentMonitor.getDistance(point) == -1) {
+            return;
+        }
         int closest = Integer.MAX_VALUE;
         for (Monitor monitor : monitors) {
             int distance = monitor.getDistance(point);
@@ -59,41 +82,105 @@ public class Desktop {
     }
     
     public void fireMouseEvent(int x, int y, int vncButtonMask) {
-        x += bounds.x;
-        y += bounds.y;
-        setCurrentMonitor(new Point(x, y));
-        Robot robot = currentMonitor.getRobot();
-        Point point = currentMonitor.getConfinedPoint(new Point(x, y));
-        robot.mouseMove(point.x, point.y);
+        Point point = new Point(x + bounds.x, y + bounds.y);
         int buttonMask = decodeVNCButtonMask(vncButtonMask);
+        // Decode the special VNC mouse buttons 4 and 5, which if pressed mean that
+        // the scroll wheel has been rotated up and down respectively by one unit.
+        boolean wheelUp = ((vncButtonMask & (1 << 4)) != 0);
+        boolean wheelDown = ((vncButtonMask & (1 << 5)) != 0);
+        if (buttonMask == oldButtonMask && wheelUp == false && wheelDown == false) {
+            pendingMotion = point;
+            return;
+        }
+        pendingMotion = null;
+        mouseMove(point);
         int maskChange = buttonMask ^ oldButtonMask;
         if (maskChange != 0) {
             int buttonsToPress = maskChange & buttonMask;
             int buttonsToRelease = maskChange & ~buttonMask;
             if (buttonsToPress != 0) {
-                robot.mousePress(buttonsToPress);
+                mouseButtons(buttonsToPress, true);
             }
             if (buttonsToRelease != 0) {
-                robot.mouseRelease(buttonsToRelease);
+                mouseButtons(buttonsToRelease, false);
             }
         }
-        // Decode the special VNC mouse buttons 4 and 5, which if pressed mean that
-        // the scroll wheel has been rotated up and down respectively by one unit.
-        if ((vncButtonMask & (1 << 4)) != 0) {
-            robot.mouseWheel(-1);    // Up.
+        if (wheelUp) {
+            mouseWheel(-1);
         }
-        if ((vncButtonMask & (1 << 5)) != 0) {
-            robot.mouseWheel(1);    // Down.
+        if (wheelDown) {
+            mouseWheel(1);
         }
         oldButtonMask = buttonMask;
     }
     
-    public void fireKeyEvent(int keyCode, boolean isDown) {
+    public void fireKeyEvent(int vncKeyCode, boolean isDown) {
+        flushMotion();
+        if (USE_XTEST) {
+            // RFB key codes are X keysyms.
+            XTest.key(vncKeyCode, isDown);
+            return;
+        }
         Robot robot = currentMonitor.getRobot();
+        int keyCode = keyCodeTranslator.getJavaKeyCode(vncKeyCode);
         if (isDown) {
             robot.keyPress(keyCode);
         } else {
             robot.keyRelease(keyCode);
         }
     }
+    
+    /**
+     * Passes on everything we've been holding back. Call this when there are no more client messages waiting to be read.
+     */
+    public void flush() {
+        flushMotion();
+        if (USE_XTEST) {
+            XTest.flush();
+        }
+    }
+    
+    private void flushMotion() {
+        if (pendingMotion != null) {
+            mouseMove(pendingMotion);
+            pendingMotion = null;
+        }
+    }
+    
+    private void mouseMove(Point point) {
+        setCurrentMonitor(point);
+        Point confinedPoint = currentMonitor.getConfinedPoint(point);
+        if (USE_XTEST) {
+            Rectangle monitorBounds = currentMonitor.getBounds();
+            XTest.motion(monitorBounds.x + confinedPoint.x, monitorBounds.y + confinedPoint.y);
+        } else {
+            currentMonitor.getRobot().mouseMove(confinedPoint.x, confinedPoint.y);
+        }
+    }
+    
+    private void mouseButtons(int buttons, boolean isPress) {
+        if (USE_XTEST) {
+            int[] masks = { InputEvent.BUTTON1_MASK, InputEvent.BUTTON2_MASK, InputEvent.BUTTON3_MASK };
+            for (int i = 0; i < masks.length; ++i) {
+                if ((buttons & masks[i]) != 0) {
+                    XTest.button(i + 1, isPress);
+                }
+            }
+        } else if (isPress) {
+            currentMonitor.getRobot().mousePress(buttons);
+        } else {
+            currentMonitor.getRobot().mouseRelease(buttons);
+        }
+    }
+    
+    private void mouseWheel(int notches) {
+        if (USE_XTEST) {
+            // X represents each notch as a click of button 4 (up) or 5 (down).
+            int button = (notches < 0) ? 4 : 5;
+            XTest.button(button, true);
+            XTest.button(button, false);
+        } else {
+            currentMonitor.getRobot().mouseWheel(notches);
+        }
+    }
 }
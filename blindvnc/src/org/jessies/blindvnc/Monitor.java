@@ -46,6 +46,10 @@ public class Monitor {
         }
     }
     
+    public Rectangle getBounds() {
+        return bounds;
+    }
+    
     public Robot getRobot() {
         return robot;
     }
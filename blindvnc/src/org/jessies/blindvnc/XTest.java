@@ -0,0 +1,31 @@
+package org.jessies.blindvnc;
+
+/**
+ * Injects input events through the X11 XTEST extension.
+ * 
+ * java.awt.Robot waits for the X server to process each event before returning, which makes a fast-moving remote pointer lag behind.
+ * These methods just queue requests on our own X connection, so callers must call flush after each batch of events.
+ * Xlib isn't thread-safe, so all the methods are synchronized.
+ * 
+ * See "org_jessies_blindvnc_XTest.cpp" for the native methods' implementations.
+ */
+class XTest {
+    static { System.loadLibrary("xtest"); }
+    
+    /**
+     * Connects to the X server named by $DISPLAY. Returns false if that's impossible, or if the server doesn't support XTEST.
+     */
+    static synchronized native boolean open();
+    
+    /** Moves the pointer to the given root window coordinates. */
+    static synchronized native void motion(int x, int y);
+    
+    /** Presses or releases the given X button (1 to 5; 4 and 5 being the scroll wheel). */
+    static synchronized native void button(int button, boolean isPress);
+    
+    /** Presses or releases the key that generates the given X keysym, which is what RFB key events contain. */
+    static synchronized native void key(int keysym, boolean isPress);
+    
+    /** Sends any queued events to the X server, without waiting for it to process them. */
+    static synchronized native void flush();
+}
@@ -3,6 +3,7 @@ package e.debugger;
 import com.sun.jdi.*;
 import com.sun.jdi.event.*;
 import com.sun.jdi.request.*;
+import java.awt.event.*;
 import java.util.*;
 import javax.swing.*;
 import javax.swing.event.*;
@@ -18,17 +19,35 @@ import e.util.*;
 
 public class ThreadTree extends ETree {
     
+    // Threads that start and die within this long of each other never appear, and a burst of changes costs one tree update.
+    private static final int UPDATE_DELAY_MS = 20;
+    
     private DefaultTreeModel model;
     private TreeSelectionModel selection;
     private Map<ThreadGroupReference, DefaultMutableTreeNode> threadGroupNodes = new HashMap<ThreadGroupReference, DefaultMutableTreeNode>();
     private Map<ThreadReference, DefaultMutableTreeNode> threadNodes = new HashMap<ThreadReference, DefaultMutableTreeNode>();
     
+    // Each of these costs a JDWP round trip to find out, and never changes, so we only ask once per group.
+    private Map<ThreadGroupReference, String> threadGroupNames = new HashMap<ThreadGroupReference, String>();
+    private Map<ThreadGroupReference, ThreadGroupReference> threadGroupParents = new HashMap<ThreadGroupReference, ThreadGroupReference>();
+    
+    // Changes reported by the target VM but not yet applied to the tree.
+    private Set<ThreadReference> startedThreads = new LinkedHashSet<ThreadReference>();
+    private Set<ThreadReference> deadThreads = new HashSet<ThreadReference>();
+    private javax.swing.Timer updateTimer;
+    
     public ThreadTree() {
         super(new DefaultTreeModel(new DefaultMutableTreeNode("")));
         setRootVisible(false);
         setRowHeight(-1);
         this.selection = getSelectionModel();
         selection.setSelectionMode(TreeSelectionModel.SINGLE_TREE_SELECTION);
+        updateTimer = new javax.swing.Timer(UPDATE_DELAY_MS, new ActionListener() {
+            public void actionPerformed(ActionEvent e) {
+                applyPendingChanges();
+            }
+        });
+        updateTimer.setRepeats(false);
     }
     
     public void enableThreadEvents(final TargetVm vm) {
@@ -38,8 +57,10 @@ public class ThreadTree extends ETree {
                 return ThreadStartEvent.class;
             }
             public void eventDispatched(Event e) {
-                setThreads(vm.getAllThreads());
-                vm.resume();
+                ThreadReference thread = ((ThreadStartEvent) e).thread();
+                deadThreads.remove(thread);
+                startedThreads.add(thread);
+                updateTimer.start();
             }
         });
         eventQueue.addVmEventListener(new VmEventListener() {
@@ -47,13 +68,20 @@ public class ThreadTree extends ETree {
                 return ThreadDeathEvent.class;
             }
             public void eventDispatched(Event e) {
-                setThreads(vm.getAllThreads());
-                vm.resume();
+                ThreadReference thread = ((ThreadDeathEvent) e).thread();
+                // A thread that starts and dies between updates needn't trouble the tree at all.
+                if (startedThreads.remove(thread) == false) {
+                    deadThreads.add(thread);
+                }
+                updateTimer.start();
             }
         });
+        // These events are just for our information, so there's no reason to stop the target VM for them.
         EventRequestManager eventManager = vm.getEventRequestManager();
         ThreadStartRequest startRequest = eventManager.createThreadStartRequest();
         ThreadDeathRequest deathRequest = eventManager.createThreadDeathRequest();
+        startRequest.setSuspendPolicy(EventRequest.SUSPEND_NONE);
+        deathRequest.setSuspendPolicy(EventRequest.SUSPEND_NONE);
         startRequest.setEnabled(true);
         deathRequest.setEnabled(true);
         setThreads(vm.getAllThreads());
@@ -69,6 +97,8 @@ public class ThreadTree extends ETree {
     }
     
     public void selectThread(ThreadReference thread) {
+        // Make sure we know about the thread, even if its start event is still waiting for the timer.
+        applyPendingChanges();
         DefaultMutableTreeNode node = threadNodes.get(thread);
         if (node != null) {
             TreePath path = new TreePath(model.getPathToRoot(node));
@@ -90,17 +120,68 @@ public class ThreadTree extends ETree {
     public void setThreads(List<ThreadReference> threads) {
         setModel(model = new DefaultTreeModel(new DefaultMutableTreeNode("")));
         threadGroupNodes.clear();
+        threadNodes.clear();
+        startedThreads.clear();
+        deadThreads.clear();
         for (ThreadReference thread : threads) {
             addThread(thread);
         }
         expandAll();
     }
     
-    private void addThread(ThreadReference thread) {
-        DefaultMutableTreeNode groupNode = getGroupNode(thread.threadGroup());
+    private void applyPendingChanges() {
+        updateTimer.stop();
+        for (ThreadReference thread : deadThreads) {
+            removeThread(thread);
+        }
+        deadThreads.clear();
+        for (ThreadReference thread : startedThreads) {
+            DefaultMutableTreeNode threadNode = addThread(thread);
+            if (threadNode != null) {
+                expandPath(new TreePath(model.getPathToRoot(threadNode.getParent())));
+            }
+        }
+        startedThreads.clear();
+    }
+    
+    /**
+     * Adds a node for the given thread, returning null if the thread has already gone.
+     */
+    private DefaultMutableTreeNode addThread(ThreadReference thread) {
+        if (threadNodes.containsKey(thread)) {
+            return null;
+        }
+        ThreadGroupReference threadGroup;
+        try {
+            threadGroup = thread.threadGroup();
+        } catch (ObjectCollectedException ex) {
+            return null;
+        }
+        DefaultMutableTreeNode groupNode = getGroupNode(threadGroup);
         DefaultMutableTreeNode threadNode = new DefaultMutableTreeNode(thread);
         threadNodes.put(thread, threadNode);
         model.insertNodeInto(threadNode, groupNode, groupNode.getChildCount());
+        return threadNode;
+    }
+    
+    /**
+     * Removes the given thread's node, and the nodes of any thread groups left empty.
+     */
+    private void removeThread(ThreadReference thread) {
+        DefaultMutableTreeNode node = threadNodes.remove(thread);
+        if (node == null) {
+            return;
+        }
+        DefaultMutableTreeNode root = (DefaultMutableTreeNode) model.getRoot();
+        while (node != root) {
+            DefaultMutableTreeNode parentNode = (DefaultMutableTreeNode) node.getParent();
+            model.removeNodeFromParent(node);
+            if (parentNode == root || parentNode.getChildCount() > 0) {
+                break;
+            }
+            threadGroupNodes.values().remove(parentNode);
+            node = parentNode;
+        }
     }
     
     /**
@@ -113,11 +194,15 @@ public class ThreadTree extends ETree {
         }
         DefaultMutableTreeNode groupNode = threadGroupNodes.get(threadGroup);
         if (groupNode == null) {
-            groupNode = new DefaultMutableTreeNode(threadGroup.name());
+            if (threadGroupNames.containsKey(threadGroup) == false) {
+                threadGroupNames.put(threadGroup, threadGroup.name());
+                threadGroupParents.put(threadGroup, threadGroup.parent());
+            }
+            groupNode = new DefaultMutableTreeNode(threadGroupNames.get(threadGroup));
             threadGroupNodes.put(threadGroup, groupNode);
+            DefaultMutableTreeNode parentNode = getGroupNode(threadGroupParents.get(threadGroup));
+            model.insertNodeInto(groupNode, parentNode, 0);
         }
-        DefaultMutableTreeNode parentNode = getGroupNode(threadGroup.parent());
-        model.insertNodeInto(groupNode, parentNode, 0);
         return groupNode;
     }
 }
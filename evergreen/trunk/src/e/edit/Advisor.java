@@ -46,9 +46,7 @@ public class Advisor extends JPanel {
      * We used to put off initialization until the researchers were actually needed, but that tends to be early on, and on the EDT.
      */
     public static void initResearchersOnBackgroundThread() {
-        final ExecutorService executor = ThreadUtilities.newSingleThreadExecutor("initResearchersOnBackgroundThread");
-        executor.execute(new ResearcherInitializationRunnable());
-        executor.shutdown();
+        WorkScheduler.submit(WorkScheduler.Priority.BACKGROUND, "Initialize Researchers", new ResearcherInitializationRunnable());
     }
     
     private static class ResearcherInitializationRunnable implements Runnable {
@@ -62,7 +60,7 @@ public class Advisor extends JPanel {
             final ConcurrentLinkedQueue<WorkspaceResearcher> newResearchers = new ConcurrentLinkedQueue<WorkspaceResearcher>();
             
             // Run all the researchers' initialization code in parallel.
-            final ExecutorService executor = ThreadUtilities.newFixedThreadPool(8, "initResearchersOnBackgroundThread");
+            final WorkScheduler.Batch executor = WorkScheduler.newBatch(WorkScheduler.Priority.BACKGROUND, "Initialize Researchers");
             executor.execute(new Runnable() {
                 public void run() {
                     newResearchers.add(JavaResearcher.getSharedInstance());
@@ -94,11 +92,9 @@ public class Advisor extends JPanel {
                 }
             });
             
-            // That's all we want to do with this executor.
-            executor.shutdown();
-            // But we don't want to unlock the collection until we've finished filling it!
+            // We don't want to unlock the collection until we've finished filling it!
             try {
-                executor.awaitTermination(60, TimeUnit.SECONDS);
+                executor.awaitCompletion();
                 researchers.addAll(newResearchers);
             } catch (InterruptedException ex) {
                 Log.warn("Failed to initialize researchers.", ex);
@@ -2,6 +2,7 @@ package e.edit;
 
 import e.ptextarea.*;
 import e.util.*;
+import java.awt.*;
 import java.awt.event.*;
 import java.util.*;
 
@@ -17,6 +18,11 @@ import java.util.*;
  * 
  * Regarding a possible future "fancier interface", "pyflakes" is a very fast checker for Python, and "ruby -wc" and "tidy -qe" are already very quick.
  * Checking as-you-type sounds eminently possible, even without the ability to use any of these in-process.
+ * 
+ * Checkers run on a worker thread, with their output streamed into an errors window as it arrives; the window's stop button kills the checker.
+ * A checker that can read the file to be checked from its standard input can be configured as "<FileType>.stdinLintChecker", in which case we feed it the unsaved text instead of asking the user to save.
+ * Runs for the same file are coalesced: a new request cancels any run in progress, and replaces any run still waiting to start, so it's cheap to check repeatedly.
+ * A file's successive runs share one errors window, which is only created when a run actually starts.
  */
 public class CheckForLintAction extends ETextAction {
     public CheckForLintAction() {
@@ -29,13 +35,17 @@ public class CheckForLintAction extends ETextAction {
     
     @Override public boolean isEnabled() {
         final ETextWindow textWindow = getFocusedTextWindow();
-        return textWindow != null && getCheckerCommand(textWindow.getFileType()) != null;
+        return textWindow != null && (getCheckerCommand(textWindow.getFileType()) != null || getStdinCheckerCommand(textWindow.getFileType()) != null);
     }
     
     private String getCheckerCommand(FileType fileType) {
         return Parameters.getString(fileType.getName() + ".lintChecker", null);
     }
     
+    private String getStdinCheckerCommand(FileType fileType) {
+        return Parameters.getString(fileType.getName() + ".stdinLintChecker", null);
+    }
+    
     private void checkForLint() {
         // Check which file?
         // We need to get hold of this before we do anything that might lose the focus.
@@ -46,45 +56,156 @@ public class CheckForLintAction extends ETextAction {
         }
         
         // Get the appropriate command for the selected file's type.
+        // We prefer a checker that reads standard input, because then we can check the text as it is rather than as it was last saved.
         FileType fileType = textWindow.getFileType();
-        String command = getCheckerCommand(fileType);
-        if (command == null) {
-            Evergreen.getInstance().showAlert("Unable to check for lint", "Don't know how to check " + fileType.getName() + " files.");
-            return;
+        Workspace workspace = Evergreen.getInstance().getCurrentWorkspace();
+        final String filename = textWindow.getFilename();
+        String command = getStdinCheckerCommand(fileType);
+        String input = null;
+        if (command != null) {
+            input = textWindow.getTextArea().getTextBuffer().toString();
+        } else {
+            command = getCheckerCommand(fileType);
+            if (command == null) {
+                Evergreen.getInstance().showAlert("Unable to check for lint", "Don't know how to check " + fileType.getName() + " files.");
+                return;
+            }
+            
+            // Are there unsaved files?
+            // We don't just check the selected file because it might #include (or whatever) other files.
+            boolean shouldContinue = workspace.prepareForAction("Save before checking for lint?", "Some files are currently modified but not saved.");
+            if (shouldContinue == false) {
+                return;
+            }
+            
+            // Append the filename.
+            // FIXME: shouldn't this actually be using our shell-escaping code?
+            command += " \"" + FileUtilities.fileFromString(filename).toString() + "\"";
         }
         
-        // Are there unsaved files?
-        // We don't just check the selected file because it might #include (or whatever) other files.
-        Workspace workspace = Evergreen.getInstance().getCurrentWorkspace();
-        boolean shouldContinue = workspace.prepareForAction("Save before checking for lint?", "Some files are currently modified but not saved.");
-        if (shouldContinue == false) {
-            return;
+        new LintRun(workspace, filename, command, input, fileType == FileType.XML).start();
+    }
+    
+    // Keyed by filename, and also guards the state of every LintRun.
+    // A file has at most one run in progress, which is the one in this map, and at most one run waiting to follow it.
+    private static final Map<String, LintRun> runs = new HashMap<String, LintRun>();
+    
+    /**
+     * Runs a checker on a worker thread, streaming its output into an errors window.
+     * Stdout and stderr go to the same window, so we don't have to worry about which commands output where.
+     */
+    private static class LintRun implements Runnable, ProcessUtilities.ProcessListener, ProcessUtilities.LineListener {
+        private final Workspace workspace;
+        private final String filename;
+        private final String command;
+        // The text to feed to a checker that reads standard input, or null if the checker reads the file itself.
+        private final String input;
+        private final boolean isXml;
+        
+        // Set when the run is submitted: either a new window, or the one the cancelled run before us was using.
+        private EErrorsWindow errorsWindow;
+        private Process process;
+        private LintRun next;
+        private volatile boolean cancelled = false;
+        
+        private LintRun(Workspace workspace, String filename, String command, String input, boolean isXml) {
+            this.workspace = workspace;
+            this.filename = filename;
+            this.command = command;
+            this.input = input;
+            this.isXml = isXml;
         }
         
-        // Append the filename.
-        final String filename = textWindow.getFilename();
-        // FIXME: shouldn't this actually be using our shell-escaping code?
-        command += " \"" + FileUtilities.fileFromString(filename).toString() + "\"";
+        private void start() {
+            synchronized (runs) {
+                LintRun current = runs.get(filename);
+                if (current != null) {
+                    // Whatever the run in progress would say is about to be out of date.
+                    // Any run already waiting behind it never started, so has no window, and can simply be forgotten.
+                    current.next = this;
+                    current.cancel();
+                    return;
+                }
+                errorsWindow = workspace.createErrorsWindow("Lint Output");
+                runs.put(filename, this);
+            }
+            WorkScheduler.submit(WorkScheduler.Priority.BULK_IO, "Check For Lint", this);
+        }
         
-        // Collect stdout and stderr into the same list, so we don't have to worry about which commands output where.
-        ArrayList<String> lines = new ArrayList<String>();
-        int status = ProcessUtilities.backQuote(null, ProcessUtilities.makeShellCommandArray(command), lines, lines);
+        // Callers must hold the lock on 'runs'.
+        private void cancel() {
+            cancelled = true;
+            if (process != null) {
+                ProcessUtilities.terminateProcess(process);
+            }
+        }
+        
+        public void run() {
+            EventQueue.invokeLater(new Runnable() {
+                public void run() {
+                    errorsWindow.setVisible(true);
+                }
+            });
+            errorsWindow.showStatus("Started task \"" + command + "\"");
+            ProcessUtilities.runCommand(null, ProcessUtilities.makeShellCommandArray(command), this, (input != null) ? input : "", this, this);
+        }
+        
+        public void processStarted(Process process) {
+            synchronized (runs) {
+                this.process = process;
+                if (cancelled) {
+                    ProcessUtilities.terminateProcess(process);
+                }
+            }
+            errorsWindow.taskDidStart(process);
+        }
         
-        if (fileType == FileType.XML) {
-            // Reformat the tidy(1) output into the grep(1) style we understand.
-            Rewriter rewriter = new Rewriter("^line (\\d+) column (\\d+) - (.)") {
-                public String replacement() {
-                    return filename + ":" + group(1) + ":" + group(2) + ": " + group(3).toLowerCase();
+        public void processExited(int status) {
+            LintRun nextRun;
+            synchronized (runs) {
+                process = null;
+                nextRun = next;
+                if (nextRun != null) {
+                    // The next run's taskDidStart will clear our output from the window.
+                    nextRun.errorsWindow = errorsWindow;
+                    runs.put(filename, nextRun);
+                } else {
+                    runs.remove(filename);
                 }
-            };
-            for (int i = 0; i < lines.size(); ++i) {
-                lines.set(i, rewriter.rewrite(lines.get(i)));
             }
+            if (nextRun != null) {
+                WorkScheduler.submit(WorkScheduler.Priority.BULK_IO, "Check For Lint", nextRun);
+            } else {
+                errorsWindow.taskDidExit(status);
+            }
+        }
+        
+        public void processLine(String line) {
+            if (cancelled) {
+                return;
+            }
+            errorsWindow.appendLines(true, Collections.singletonList(rewriteLine(line)));
         }
         
-        // Show the user what the tool found.
-        final EErrorsWindow errorsWindow = workspace.createErrorsWindow("Lint Output");
-        errorsWindow.appendLines(true, lines);
-        errorsWindow.taskDidExit(status);
+        private String rewriteLine(String line) {
+            if (isXml) {
+                // Reformat the tidy(1) output into the grep(1) style we understand.
+                Rewriter rewriter = new Rewriter("^line (\\d+) column (\\d+) - (.)") {
+                    public String replacement() {
+                        return filename + ":" + group(1) + ":" + group(2) + ": " + group(3).toLowerCase();
+                    }
+                };
+                line = rewriter.rewrite(line);
+            }
+            if (input != null) {
+                // Checkers reading standard input call the file "-" or "<stdin>"; we want links to the real file.
+                if (line.startsWith("-:")) {
+                    line = filename + line.substring(1);
+                } else if (line.startsWith("<stdin>:")) {
+                    line = filename + line.substring(7);
+                }
+            }
+            return line;
+        }
     }
 }
@@ -20,6 +20,15 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
     // Used to update the watermark without creating and destroying an excessive number of threads.
     private static final ExecutorService WATERMARK_UPDATE_EXECUTOR = ThreadUtilities.newSingleThreadExecutor("Watermark Updater");
     
+    // Remembered files are restored as empty windows whose content is read when they're first focused or given room on the screen.
+    // The rest are loaded one at a time in idle moments, so a big saved session doesn't delay start-up or block the EDT for long.
+    private static final LinkedList<ETextWindow> deferredWindows = new LinkedList<ETextWindow>();
+    private static final Timer deferredWindowLoader = new Timer(100, new ActionListener() {
+        public void actionPerformed(ActionEvent e) {
+            loadNextDeferredWindow();
+        }
+    });
+    
     private final String filename;
     private final File file;
     private final PTextArea textArea;
@@ -30,7 +39,12 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
     private final BirdView birdView;
     private final TagsUpdater tagsUpdater;
     
-    private long lastModifiedTime;
+    // What the file on disk looked like when we last read or wrote it, so we can tell cheaply whether it's since changed.
+    private volatile DiskState diskState;
+    
+    private boolean isContentLoaded = false;
+    // The address to go to once our content is loaded, if jumpToAddress was called before then.
+    private String pendingAddress;
     
     // Each text window has its own current regular expression for finds, which may be null if there's no currently active search in that window.
     private String currentRegularExpression;
@@ -38,8 +52,8 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
     private Timer findResultsUpdateTimer;
     private PFindListener findResultsUpdater = new PFindListener() {
         public void aboutToFind() {
-            // FIXME: isn't this too conservative? shouldn't we check whether the timer is running? if it's not, aren't the results already up to date?
-            updateFindResults();
+            // "Find Next" and "Find Previous" need the matches for the current text; this only re-matches what's been edited since the last update.
+            textArea.updateFindMatches();
         }
     };
     
@@ -57,6 +71,10 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
     }
     
     public ETextWindow(String filename) {
+        this(filename, false);
+    }
+    
+    public ETextWindow(String filename, boolean deferContentLoading) {
         super(filename);
         this.filename = filename;
         this.file = FileUtilities.fileFromString(filename);
@@ -79,11 +97,77 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
         add(birdView, BorderLayout.EAST);
         
         this.tagsUpdater = new TagsUpdater(this);
-        fillWithContent();
-        initUserConfigurableDefaults();
+        if (deferContentLoading) {
+            initDeferredContentLoading();
+        } else {
+            ensureContentLoaded();
+        }
         initFindResultsUpdater();
     }
     
+    /**
+     * Reads, styles and tags our file, if we haven't already.
+     * Windows restored from a previous session start out empty; anything that needs their content must call this first.
+     */
+    public void ensureContentLoaded() {
+        if (isContentLoaded) {
+            return;
+        }
+        isContentLoaded = true;
+        synchronized (deferredWindows) {
+            deferredWindows.remove(this);
+        }
+        try {
+            fillWithContent();
+        } catch (RuntimeException ex) {
+            if (getColumn() == null) {
+                // We're still being constructed, and our caller needs to know we failed.
+                throw ex;
+            }
+            // A restored file that's become unreadable since last time: fillWithContent has told the user.
+            // We mustn't leave an empty window that could be saved over the file.
+            closeWindow();
+            return;
+        }
+        initUserConfigurableDefaults();
+        if (pendingAddress != null) {
+            String address = pendingAddress;
+            pendingAddress = null;
+            jumpToAddress(address);
+        }
+    }
+    
+    private void initDeferredContentLoading() {
+        // Once we're given some space on the screen, we jump the queue.
+        watermarkViewPort.addChangeListener(new javax.swing.event.ChangeListener() {
+            public void stateChanged(javax.swing.event.ChangeEvent e) {
+                if (isContentLoaded == false && watermarkViewPort.getExtentSize().height > 0) {
+                    synchronized (deferredWindows) {
+                        if (deferredWindows.remove(ETextWindow.this)) {
+                            deferredWindows.addFirst(ETextWindow.this);
+                        }
+                    }
+                }
+            }
+        });
+        synchronized (deferredWindows) {
+            deferredWindows.add(this);
+        }
+        deferredWindowLoader.start();
+    }
+    
+    private static void loadNextDeferredWindow() {
+        ETextWindow textWindow;
+        synchronized (deferredWindows) {
+            textWindow = deferredWindows.poll();
+        }
+        if (textWindow == null) {
+            deferredWindowLoader.stop();
+            return;
+        }
+        textWindow.ensureContentLoaded();
+    }
+    
     private void initTextArea() {
         textArea.setPastedTextReformatter(new UnaryFunctor<String, String>() {
             public String evaluate(String pastedText) {
@@ -220,12 +304,14 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
     }
     
     private void updateFindResults() {
-        FindAction.INSTANCE.repeatLastFind(this);
+        // Only the edited lines are re-matched, and that happens in the background.
+        textArea.updateFindMatchesInBackground();
     }
     
     private void initFocusListener() {
         textArea.addFocusListener(new FocusListener() {
             public void focusGained(FocusEvent e) {
+                ensureContentLoaded();
                 updateWatermarkAndTitleBar();
                 updateStatusLine();
             }
@@ -257,6 +343,10 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
     
     /** Returns the grep-style ":<line>:<column>" address for the caret position. */
     public String getAddress() {
+        if (isContentLoaded == false) {
+            // Don't lose the remembered position of a file that was never looked at.
+            return (pendingAddress != null) ? pendingAddress : "";
+        }
         String result = addressFromOffset(textArea.getSelectionStart(), ":", ":");
         if (textArea.hasSelection()) {
             // emacs end offsets seem to include the character following.
@@ -339,8 +429,10 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
     
     private void fillWithContent() {
         try {
-            lastModifiedTime = file.lastModified();
-            textArea.getTextBuffer().readFromFile(file);
+            // The identity is recorded before we read, so a change made while we're reading makes us out of date rather than hiding the change.
+            final FileIdentity identity = FileIdentity.fromFile(file);
+            final String digest = textArea.getTextBuffer().readFromFile(file);
+            diskState = new DiskState(identity, digest);
             
             configureForGuessedFileType();
             updateWatermarkAndTitleBar();
@@ -428,6 +520,9 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
     
     @Override
     public void windowWillClose() {
+        synchronized (deferredWindows) {
+            deferredWindows.remove(this);
+        }
         if (findResultsUpdateTimer != null) {
             findResultsUpdateTimer.stop();
             findResultsUpdateTimer = null;
@@ -562,6 +657,10 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
     }
     
     public void jumpToAddress(String address) {
+        if (isContentLoaded == false) {
+            pendingAddress = address;
+            return;
+        }
         CharSequence chars = textArea.getTextBuffer();
         StringTokenizer st = new StringTokenizer(address, ":");
         if (st.hasMoreTokens() == false) {
@@ -610,24 +709,36 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
         return FileUtilities.getUserFriendlyName(file.getParent());
     }
     
+    private static class DiskState {
+        private final FileIdentity identity;
+        private final String digest;
+        
+        private DiskState(FileIdentity identity, String digest) {
+            this.identity = identity;
+            this.digest = digest;
+        }
+    }
+    
     private boolean isOutOfDateWithRespectToDisk() {
-        // If the time stamp on disk is the same as it was when we last read
-        // or wrote the file, assume it hasn't changed.
-        if (file.lastModified() == lastModifiedTime) {
+        // We've nothing in memory to be out of date.
+        final DiskState oldState = diskState;
+        if (isContentLoaded == false || oldState == null) {
             return false;
         }
         
-        // If the on-disk content is the same as what we have in memory, then
-        // the fact that the time stamp is different isn't significant.
-        try {
-            String currentContentInMemory = textArea.getText();
-            String currentContentOnDisk = StringUtilities.readFile(file);
-            if (currentContentInMemory.equals(currentContentOnDisk)) {
-                lastModifiedTime = file.lastModified();
-                return false;
-            }
-        } catch (Exception ex) {
-            Log.warn("Couldn't compare with on-disk copy.", ex);
+        // If the file's identity is the same as when we last read or wrote it, assume it hasn't changed.
+        // This costs a single stat(2).
+        final FileIdentity currentIdentity = FileIdentity.fromFile(file);
+        if (currentIdentity != null && currentIdentity.equals(oldState.identity)) {
+            return false;
+        }
+        
+        // The file has been touched, checked out, or rewritten, but the content might still be what we read or wrote.
+        // Digesting the file streams it through a small buffer rather than reading it all into a String.
+        final String currentDigest = FileUtilities.md5(file);
+        if (currentDigest != null && currentDigest.equals(oldState.digest)) {
+            diskState = new DiskState(currentIdentity, currentDigest);
+            return false;
         }
         
         return true;
@@ -635,6 +746,8 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
     
     /** Saves the text. Returns true if the file was saved okay. */
     public boolean save() {
+        // Never write an unloaded window's empty buffer over the file.
+        ensureContentLoaded();
         Evergreen editor = Evergreen.getInstance();
         
         PTextBuffer buffer = textArea.getTextBuffer();
@@ -675,12 +788,12 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
             editor.showStatus("Saving " + filename + "...");
             // The file may be a symbolic link on a CIFS server.
             // In this case, it's important that we write into the original file rather than creating a new one.
-            writeToFile(file);
+            final String digest = writeToFile(file);
             buffer.getUndoBuffer().setCurrentStateClean();
             getTitleBar().repaint();
             editor.showStatus("Saved " + filename);
             backupFile.delete();
-            this.lastModifiedTime = file.lastModified();
+            diskState = new DiskState(FileIdentity.fromFile(file), digest);
             configureForGuessedFileType();
             updateWatermarkAndTitleBar();
             tagsUpdater.updateTags();
@@ -694,7 +807,7 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
         return false;
     }
     
-    private void writeToFile(File file) {
+    private String writeToFile(File file) {
         // Only Java has newline hygiene as part of its language specification, but it probably applies to most computer languages.
         // For now, though, we let authors of plain text do what they like.
         if (getFileType() != FileType.PLAIN_TEXT) {
@@ -714,7 +827,7 @@ public class ETextWindow extends EWindow implements Comparable<ETextWindow>, PTe
             trimTrailingWhitespace();
         }
         
-        textArea.getTextBuffer().writeToFile(file);
+        return textArea.getTextBuffer().writeToFile(file);
     }
     
     private void trimTrailingWhitespace() {
@@ -94,7 +94,7 @@ public class Evergreen {
         }
         
         private void addInitialFile(String name, int y, boolean lastFocused) {
-            initialFiles.add(new InitialFile(name, y, lastFocused));
+            initialFiles.add(new InitialFile(name, y, lastFocused, lastFocused == false));
         }
     }
     
@@ -102,15 +102,18 @@ public class Evergreen {
         String filename; // strictly, filename(:address)?
         int y;
         boolean lastFocused;
+        // Remembered files other than the last-focused one aren't read until they're needed; see ETextWindow.ensureContentLoaded.
+        boolean deferContentLoading;
         
-        private InitialFile(String filename, int y, boolean lastFocused) {
+        private InitialFile(String filename, int y, boolean lastFocused, boolean deferContentLoading) {
             this.filename = filename;
             this.y = y;
             this.lastFocused = lastFocused;
+            this.deferContentLoading = deferContentLoading;
         }
         
         private InitialFile(String filename) {
-            this(filename, -1, false);
+            this(filename, -1, false, false);
         }
     }
     
@@ -322,7 +325,7 @@ public class Evergreen {
         }
         
         // Add an appropriate viewer for the filename to the chosen workspace.
-        return workspace.addViewerForFile(filename, address, file.y);
+        return workspace.addViewerForFile(filename, address, file.y, file.deferContentLoading);
     }
     
     /** Returns an array of all the workspaces. */
@@ -104,16 +104,21 @@ public class FindAction extends ETextAction implements MinibufferUser {
     //
     
     public void removeAllMatches() {
-        currentTextWindow.getTextArea().removeHighlights(PFind.MatchHighlight.HIGHLIGHTER_NAME);
-        currentTextWindow.getBirdView().clearMatchingLines();
+        currentTextWindow.getTextArea().findAllMatches(null, currentTextWindow.getBirdView());
     }
     
     private void findAllMatches(String regularExpression) {
         currentTextWindow.setCurrentRegularExpression(regularExpression);
-        PTextArea textArea = currentTextWindow.getTextArea();
+        final ETextWindow textWindow = currentTextWindow;
+        PTextArea textArea = textWindow.getTextArea();
         try {
-            textArea.findAllMatches(regularExpression, currentTextWindow.getBirdView());
-            currentTextWindow.updateStatusLine();
+            // Matches arrive in batches, so keep the match count in the status line current as they do.
+            textArea.findAllMatchesInBackground(regularExpression, textWindow.getBirdView(), new Runnable() {
+                public void run() {
+                    textWindow.updateStatusLine();
+                }
+            });
+            textWindow.updateStatusLine();
         } catch (PatternSyntaxException patternSyntaxException) {
             Evergreen.getInstance().showStatus(patternSyntaxException.getDescription());
             return;
@@ -30,9 +30,6 @@ public class FindInFilesDialog implements WorkspaceFileList.Listener {
         return currentSequenceNumber.incrementAndGet();
     }
     
-    /** We share these between all workspaces, to make it harder to accidentally launch a denial-of-service attack against ourselves. */
-    private static final ExecutorService definitionFinderExecutor = ThreadUtilities.newFixedThreadPool(8, "Find Definitions");
-    
     /** Which workspace is this "Find in Files" for? */
     private final Workspace workspace;
     
@@ -100,7 +97,7 @@ public class FindInFilesDialog implements WorkspaceFileList.Listener {
             this.matchCount = matchCount;
             this.pattern = pattern;
             if (pattern != null) {
-                definitionFinderExecutor.submit(new DefinitionFinder(file, pattern, this));
+                WorkScheduler.submit(WorkScheduler.Priority.BACKGROUND, "Find Definitions", new DefinitionFinder(file, pattern, this));
             }
         }
         
@@ -210,14 +207,13 @@ public class FindInFilesDialog implements WorkspaceFileList.Listener {
             try {
                 Pattern pattern = PatternUtilities.smartCaseCompile(regex);
                 
-                final int threadCount = Runtime.getRuntime().availableProcessors() + 1;
-                ThreadPoolExecutor executor = (ThreadPoolExecutor) ThreadUtilities.newFixedThreadPool(threadCount, "find-in-files");
+                // The user's waiting for these results, but the shared scheduler keeps us from competing with the EDT for more than our share of the CPUs.
+                WorkScheduler.Batch batch = WorkScheduler.newBatch(WorkScheduler.Priority.INTERACTIVE, "Find in Files");
                 for (String candidate : fileList) {
-                    executor.execute(new FileSearchRunnable(candidate, pattern));
+                    batch.execute(new FileSearchRunnable(candidate, pattern));
                 }
-                executor.shutdown();
                 try {
-                    executor.awaitTermination(3600, TimeUnit.SECONDS);
+                    batch.awaitCompletion();
                 } catch (InterruptedException ex) {
                     ex = ex; // Fine; we're still finished.
                 }
@@ -15,7 +15,7 @@ import javax.swing.tree.*;
 import org.jdesktop.swingworker.SwingWorker;
 
 public class TagsUpdater {
-    private static final ExecutorService executorService = ThreadUtilities.newSingleThreadExecutor("Tags Updater");
+    private static final Executor executorService = WorkScheduler.newSerialExecutor(WorkScheduler.Priority.BACKGROUND, "Tags Updater");
     private static final Stopwatch tagsUpdaterStopwatch = Stopwatch.get("TagsUpdater");
     private static final Comparator<String> TAG_COMPARATOR = new SmartStringComparator();
 
@@ -172,6 +172,8 @@ public class Workspace extends JPanel {
             leftColumn.setSelectedWindow(window);
             window.ensureSufficientlyVisible();
             ETextWindow textWindow = (ETextWindow) window;
+            // Our callers go on to use the content, so a window restored from the last session can't stay a placeholder.
+            textWindow.ensureContentLoaded();
             textWindow.jumpToAddress(address);
             EventQueue.invokeLater(new Runnable() {
                 public void run() {
@@ -183,11 +185,11 @@ public class Workspace extends JPanel {
         return null;
     }
     
-    public EWindow addViewerForFile(final String filename, final String address, final int y) {
+    public EWindow addViewerForFile(final String filename, final String address, final int y, final boolean deferContentLoading) {
         Evergreen.getInstance().showStatus("Opening " + filename + "...");
         EWindow window = null;
         try {
-            ETextWindow newWindow = new ETextWindow(filename);
+            ETextWindow newWindow = new ETextWindow(filename, deferContentLoading);
             window = addViewer(newWindow, address, y);
             if (filename.startsWith(getRootDirectory())) {
                 int prefixCharsToSkip = getRootDirectory().length();
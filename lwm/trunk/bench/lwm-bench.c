@@ -0,0 +1,544 @@
+/*
+ * Plays the part of a crowd of badly-behaved clients, and times how long
+ * the window manager takes to respond. Each scenario prints one line of
+ * JSON on the standard output. See README.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <sys/select.h>
+
+#include <X11/X.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/XTest.h>
+
+/* Window size, and the grid cell each window is placed in. */
+#define WIDTH	40
+#define HEIGHT	24
+#define CELL	72
+
+/* How long we wait for the window manager before giving up on an event. */
+#define TIMEOUT	5.0
+
+static Display * dpy;
+static Window root;
+static int screen_width;
+static int screen_height;
+static char * argv0;
+
+static Window * windows;
+static int nwindows;
+static int rounds = 10;
+
+static Atom net_wm_state;
+static Atom net_wm_state_fullscreen;
+
+static double
+now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+panic(char *s) {
+	fprintf(stderr, "%s: %s\n", argv0, s);
+	exit(EXIT_FAILURE);
+}
+
+typedef struct Wanted Wanted;
+struct Wanted {
+	Window window;
+	int type;
+};
+
+static Bool
+isWanted(Display *d, XEvent *ev, XPointer arg) {
+	Wanted *wanted = (Wanted *) arg;
+
+	(void) d;
+	return ev->type == wanted->type &&
+		(wanted->window == None || ev->xany.window == wanted->window);
+}
+
+/*
+ * Waits for an event of the given type on window w (or any window, if w is
+ * None). Other events stay queued, so that waiting for one window's event
+ * doesn't lose another's that we'll wait for next. Returns 0 if the window
+ * manager doesn't oblige within TIMEOUT seconds.
+ */
+static int
+waitFor(Window w, int type) {
+	XEvent ev;
+	Wanted wanted;
+	double deadline = now() + TIMEOUT;
+	int fd = ConnectionNumber(dpy);
+
+	wanted.window = w;
+	wanted.type = type;
+	for (;;) {
+		/* XCheckIfEvent reads whatever has arrived, too. */
+		if (XCheckIfEvent(dpy, &ev, isWanted, (XPointer) &wanted))
+			return 1;
+
+		{
+			fd_set readfds;
+			struct timeval tv;
+			double remaining = deadline - now();
+
+			if (remaining <= 0)
+				return 0;
+			tv.tv_sec = (long) remaining;
+			tv.tv_usec = (long) ((remaining - tv.tv_sec) * 1e6);
+			FD_ZERO(&readfds);
+			FD_SET(fd, &readfds);
+			select(fd + 1, &readfds, NULL, NULL, &tv);
+		}
+	}
+}
+
+/*
+ * Throws away the events we've no more use for, once lwm has dealt with
+ * everything we've asked of it so far, so that a stale one can't satisfy
+ * a later waitFor.
+ */
+static void
+discardEvents(void) {
+	XSync(dpy, True);
+}
+
+static void
+waitForOrDie(Window w, int type, char *what) {
+	if (!waitFor(w, type)) {
+		fprintf(stderr, "%s: timed out waiting for %s\n", argv0, what);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * Latencies are gathered into a Sample and summarised as a JSON object.
+ */
+typedef struct Sample Sample;
+struct Sample {
+	double * values;
+	int count;
+	int size;
+	double start;
+};
+
+static void
+Sample_Init(Sample *s, int size) {
+	s->values = (double *) malloc(size * sizeof(double));
+	s->count = 0;
+	s->size = size;
+	s->start = now();
+}
+
+static void
+Sample_Add(Sample *s, double seconds) {
+	if (s->count < s->size)
+		s->values[s->count++] = seconds;
+}
+
+static int
+compareDoubles(const void *a, const void *b) {
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+	return (x < y) ? -1 : (x > y);
+}
+
+static void
+Sample_Report(Sample *s, char *scenario) {
+	double total = 0;
+	double elapsed = now() - s->start;
+	int i;
+
+	qsort(s->values, s->count, sizeof(double), compareDoubles);
+	for (i = 0; i < s->count; i++)
+		total += s->values[i];
+
+	printf("{\"scenario\":\"%s\",\"windows\":%d,\"samples\":%d,"
+		"\"mean_ms\":%.3f,\"p50_ms\":%.3f,\"p95_ms\":%.3f,"
+		"\"max_ms\":%.3f,\"elapsed_ms\":%.3f}\n",
+		scenario, nwindows, s->count,
+		s->count ? 1e3 * total / s->count : 0.0,
+		s->count ? 1e3 * s->values[s->count / 2] : 0.0,
+		s->count ? 1e3 * s->values[(s->count * 95) / 100] : 0.0,
+		s->count ? 1e3 * s->values[s->count - 1] : 0.0,
+		1e3 * elapsed);
+	fflush(stdout);
+	free(s->values);
+}
+
+/*
+ * Creates the windows on a grid, with user-specified positions so that
+ * lwm puts them where we ask and they don't overlap.
+ */
+static void
+createWindows(void) {
+	XSetWindowAttributes attr;
+	XSizeHints hints;
+	int columns = screen_width / CELL;
+	int i;
+
+	if (columns * (screen_height / CELL) < nwindows)
+		panic("screen too small for that many windows");
+
+	windows = (Window *) malloc(nwindows * sizeof(Window));
+	attr.event_mask = StructureNotifyMask | FocusChangeMask;
+	attr.background_pixel = WhitePixel(dpy, DefaultScreen(dpy));
+	for (i = 0; i < nwindows; i++) {
+		int x = (i % columns) * CELL + CELL / 4;
+		int y = (i / columns) * CELL + CELL / 4;
+
+		windows[i] = XCreateWindow(dpy, root, x, y, WIDTH, HEIGHT, 0,
+			CopyFromParent, InputOutput, CopyFromParent,
+			CWEventMask | CWBackPixel, &attr);
+		hints.flags = USPosition | USSize;
+		hints.x = x;
+		hints.y = y;
+		hints.width = WIDTH;
+		hints.height = HEIGHT;
+		XSetWMNormalHints(dpy, windows[i], &hints);
+		XStoreName(dpy, windows[i], "lwm-bench");
+	}
+	XSync(dpy, False);
+}
+
+static void
+destroyWindows(void) {
+	int i;
+
+	for (i = 0; i < nwindows; i++)
+		XDestroyWindow(dpy, windows[i]);
+	free(windows);
+	windows = 0;
+	discardEvents();
+}
+
+static void
+mapAll(void) {
+	int i;
+
+	for (i = 0; i < nwindows; i++)
+		XMapWindow(dpy, windows[i]);
+	for (i = 0; i < nwindows; i++)
+		waitForOrDie(windows[i], MapNotify, "MapNotify");
+	discardEvents();
+}
+
+/* Returns the frame lwm has put around w, and its geometry. */
+static Window
+getFrame(Window w, int *x, int *y, unsigned int *width, unsigned int *height) {
+	Window root_return;
+	Window parent;
+	Window * children;
+	unsigned int nchildren;
+	unsigned int border_width, depth;
+
+	if (XQueryTree(dpy, w, &root_return, &parent, &children, &nchildren) == 0)
+		panic("XQueryTree failed");
+	if (children)
+		XFree(children);
+	if (parent == root)
+		panic("window wasn't reparented; is lwm running?");
+	XGetGeometry(dpy, parent, &root_return, x, y, width, height,
+		&border_width, &depth);
+	return parent;
+}
+
+/* Time from XMapWindow to MapNotify, one window at a time. */
+static void
+benchMap(void) {
+	Sample s;
+	int i;
+
+	Sample_Init(&s, nwindows);
+	for (i = 0; i < nwindows; i++) {
+		double start = now();
+		XMapWindow(dpy, windows[i]);
+		XFlush(dpy);
+		waitForOrDie(windows[i], MapNotify, "MapNotify");
+		Sample_Add(&s, now() - start);
+	}
+	Sample_Report(&s, "map");
+}
+
+/* Time for lwm to get through mapping, then unmapping, every window at once. */
+static void
+benchMapStorm(void) {
+	Sample s;
+	int r;
+	int i;
+
+	Sample_Init(&s, rounds);
+	for (r = 0; r < rounds; r++) {
+		double start = now();
+		mapAll();
+		for (i = 0; i < nwindows; i++)
+			XUnmapWindow(dpy, windows[i]);
+		for (i = 0; i < nwindows; i++)
+			waitForOrDie(windows[i], UnmapNotify, "UnmapNotify");
+		Sample_Add(&s, now() - start);
+	}
+	Sample_Report(&s, "map-storm");
+}
+
+/* Time from the pointer entering a window to the window getting the focus. */
+static void
+benchFocus(void) {
+	Sample s;
+	int r;
+	int i;
+
+	mapAll();
+	Sample_Init(&s, rounds * nwindows);
+	for (r = 0; r < rounds; r++) {
+		for (i = 0; i < nwindows; i++) {
+			int x, y;
+			Window child;
+			double start;
+
+			XTranslateCoordinates(dpy, windows[i], root,
+				WIDTH / 2, HEIGHT / 2, &x, &y, &child);
+			discardEvents();
+			start = now();
+			XTestFakeMotionEvent(dpy, DefaultScreen(dpy), x, y, CurrentTime);
+			XFlush(dpy);
+			/* The first window may already have the focus. */
+			if (waitFor(windows[i], FocusIn))
+				Sample_Add(&s, now() - start);
+		}
+	}
+	Sample_Report(&s, "focus");
+}
+
+/*
+ * Drags with the given button from (from_x, from_y) in frame coordinates,
+ * by (dx, dy) each step, timing each step until the frame's been moved
+ * or resized.
+ */
+static void
+drag(Sample *s, Window frame, int button, int from_x, int from_y, int dx, int dy) {
+	int x, y;
+	Window child;
+	int step;
+	int steps = 50;
+
+	XSelectInput(dpy, frame, StructureNotifyMask);
+	XTranslateCoordinates(dpy, frame, root, from_x, from_y, &x, &y, &child);
+	XTestFakeMotionEvent(dpy, DefaultScreen(dpy), x, y, CurrentTime);
+	XTestFakeButtonEvent(dpy, button, True, CurrentTime);
+	discardEvents();
+	for (step = 1; step <= steps; step++) {
+		double start = now();
+		XTestFakeMotionEvent(dpy, DefaultScreen(dpy), x + step * dx, y + step * dy, CurrentTime);
+		XFlush(dpy);
+		if (waitFor(frame, ConfigureNotify))
+			Sample_Add(s, now() - start);
+	}
+	XTestFakeButtonEvent(dpy, button, False, CurrentTime);
+	XSelectInput(dpy, frame, NoEventMask);
+	XSync(dpy, False);
+}
+
+static void
+benchMove(void) {
+	Sample s;
+	Window frame;
+	int x, y;
+	unsigned int width, height;
+	int r;
+
+	XMapWindow(dpy, windows[0]);
+	waitForOrDie(windows[0], MapNotify, "MapNotify");
+	Sample_Init(&s, rounds * 50);
+	for (r = 0; r < rounds; r++) {
+		frame = getFrame(windows[0], &x, &y, &width, &height);
+		/* Middle button in the title bar moves; avoid the close box. */
+		drag(&s, frame, Button2, width / 2, 2, (r % 2) ? -4 : 4, (r % 2) ? -4 : 4);
+	}
+	Sample_Report(&s, "move");
+}
+
+static void
+benchResize(void) {
+	Sample s;
+	Window frame;
+	int x, y;
+	unsigned int width, height;
+	int r;
+
+	XMapWindow(dpy, windows[0]);
+	waitForOrDie(windows[0], MapNotify, "MapNotify");
+	Sample_Init(&s, rounds * 50);
+	for (r = 0; r < rounds; r++) {
+		frame = getFrame(windows[0], &x, &y, &width, &height);
+		/* Left button in the bottom right corner resizes. */
+		drag(&s, frame, Button1, width - 2, height - 2, (r % 2) ? -3 : 3, (r % 2) ? -3 : 3);
+	}
+	Sample_Report(&s, "resize");
+}
+
+/* Time from asking for full screen (or back) to being resized. */
+static void
+benchFullScreen(void) {
+	Sample s;
+	int r;
+	int i;
+	XEvent ev;
+
+	mapAll();
+	Sample_Init(&s, 2 * rounds * nwindows);
+	for (r = 0; r < 2 * rounds; r++) {
+		for (i = 0; i < nwindows; i++) {
+			double start;
+
+			discardEvents();
+			start = now();
+			memset(&ev, 0, sizeof(ev));
+			ev.xclient.type = ClientMessage;
+			ev.xclient.window = windows[i];
+			ev.xclient.message_type = net_wm_state;
+			ev.xclient.format = 32;
+			ev.xclient.data.l[0] = 2;	/* _NET_WM_STATE_TOGGLE */
+			ev.xclient.data.l[1] = net_wm_state_fullscreen;
+			XSendEvent(dpy, root, False,
+				SubstructureNotifyMask | SubstructureRedirectMask, &ev);
+			XFlush(dpy);
+			if (waitFor(windows[i], ConfigureNotify))
+				Sample_Add(&s, now() - start);
+		}
+	}
+	Sample_Report(&s, "fullscreen");
+}
+
+/*
+ * Rewrites every window's title many times, then measures how long it
+ * takes lwm to catch up: lwm handles events in order, so once a window
+ * mapped afterwards is mapped, all the PropertyNotify events have been
+ * dealt with.
+ */
+static void
+benchPropertySpam(void) {
+	Sample s;
+	char title[64];
+	Window sentinel;
+	int r;
+	int i;
+
+	mapAll();
+	sentinel = XCreateSimpleWindow(dpy, root, 0, 0, WIDTH, HEIGHT, 0, 0, 0);
+	XSelectInput(dpy, sentinel, StructureNotifyMask);
+	Sample_Init(&s, rounds);
+	for (r = 0; r < rounds; r++) {
+		double start = now();
+
+		for (i = 0; i < nwindows * 10; i++) {
+			sprintf(title, "lwm-bench %d/%d", r, i);
+			XStoreName(dpy, windows[i % nwindows], title);
+		}
+		XMapWindow(dpy, sentinel);
+		XFlush(dpy);
+		waitForOrDie(sentinel, MapNotify, "sentinel MapNotify");
+		Sample_Add(&s, now() - start);
+		XUnmapWindow(dpy, sentinel);
+		waitForOrDie(sentinel, UnmapNotify, "sentinel UnmapNotify");
+	}
+	Sample_Report(&s, "property-spam");
+}
+
+typedef struct Scenario Scenario;
+struct Scenario {
+	char * name;
+	void (*run)(void);
+};
+
+static Scenario scenarios[] = {
+	{"map", benchMap},
+	{"map-storm", benchMapStorm},
+	{"focus", benchFocus},
+	{"move", benchMove},
+	{"resize", benchResize},
+	{"fullscreen", benchFullScreen},
+	{"property-spam", benchPropertySpam},
+};
+#define NSCENARIOS ((int) (sizeof(scenarios)/sizeof(scenarios[0])))
+
+static void
+usage(void) {
+	int i;
+
+	fprintf(stderr, "usage: %s [-n windows] [-r rounds] scenario...\n", argv0);
+	fprintf(stderr, "scenarios:");
+	for (i = 0; i < NSCENARIOS; i++)
+		fprintf(stderr, " %s", scenarios[i].name);
+	fprintf(stderr, " all\n");
+	exit(EXIT_FAILURE);
+}
+
+static void
+run(char *name) {
+	int i;
+
+	for (i = 0; i < NSCENARIOS; i++) {
+		if (strcmp(name, "all") == 0 || strcmp(name, scenarios[i].name) == 0) {
+			/* Every scenario starts with fresh, unmapped windows. */
+			createWindows();
+			scenarios[i].run();
+			destroyWindows();
+			if (strcmp(name, "all") != 0)
+				return;
+		}
+	}
+	if (strcmp(name, "all") != 0)
+		usage();
+}
+
+extern int
+main(int argc, char *argv[]) {
+	int event_base, error_base, major, minor;
+	int c;
+
+	argv0 = argv[0];
+	nwindows = 100;
+
+	while ((c = getopt(argc, argv, "n:r:")) != -1) {
+		switch (c) {
+		case 'n':
+			nwindows = atoi(optarg);
+			break;
+		case 'r':
+			rounds = atoi(optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind == argc || nwindows < 1 || rounds < 1)
+		usage();
+
+	dpy = XOpenDisplay(NULL);
+	if (dpy == 0)
+		panic("can't open display.");
+	if (!XTestQueryExtension(dpy, &event_base, &error_base, &major, &minor))
+		panic("the server doesn't support XTEST.");
+	root = DefaultRootWindow(dpy);
+	screen_width = DisplayWidth(dpy, DefaultScreen(dpy));
+	screen_height = DisplayHeight(dpy, DefaultScreen(dpy));
+	net_wm_state = XInternAtom(dpy, "_NET_WM_STATE", False);
+	net_wm_state_fullscreen = XInternAtom(dpy, "_NET_WM_STATE_FULLSCREEN", False);
+
+	for (; optind < argc; optind++)
+		run(argv[optind]);
+
+	XCloseDisplay(dpy);
+	return EXIT_SUCCESS;
+}
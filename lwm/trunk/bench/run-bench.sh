@@ -0,0 +1,53 @@
+#!/bin/sh
+
+# Runs each lwm-bench scenario against a fresh lwm on a private Xvfb, and
+# writes one line of JSON per result to the standard output. See README.
+#
+# Usage: run-bench.sh [scenario...]
+#
+# LWM, WINDOWS, ROUNDS and BENCH_DISPLAY override the defaults below.
+
+LWM=${LWM:-./lwm-stats}
+WINDOWS=${WINDOWS:-100}
+ROUNDS=${ROUNDS:-10}
+BENCH_DISPLAY=${BENCH_DISPLAY:-:73}
+SCENARIOS=${*:-"map map-storm focus move resize fullscreen property-spam"}
+
+TMP=`mktemp -d /tmp/lwm-bench.XXXXXX` || exit 1
+CLK_TCK=`getconf CLK_TCK`
+REVISION=`git describe --always --dirty 2>/dev/null || echo unknown`
+
+Xvfb $BENCH_DISPLAY -screen 0 1600x1200x24 -nolisten tcp 2> $TMP/Xvfb.log &
+XVFB_PID=$!
+trap 'kill $XVFB_PID 2> /dev/null; rm -rf $TMP' 0
+DISPLAY=$BENCH_DISPLAY
+export DISPLAY
+
+# Give Xvfb a moment to start listening.
+sleep 1
+
+# Prints lwm's user and system CPU time in clock ticks.
+cpu_ticks() {
+	awk '{ print $14 + $15 }' /proc/$1/stat
+}
+
+for scenario in $SCENARIOS; do
+	LWM_STATS=$TMP/stats $LWM 2> $TMP/lwm.log &
+	LWM_PID=$!
+	sleep 1
+	before=`cpu_ticks $LWM_PID`
+
+	./lwm-bench -n $WINDOWS -r $ROUNDS $scenario | sed -e "s/^{/{\"revision\":\"$REVISION\",/"
+
+	after=`cpu_ticks $LWM_PID`
+	kill -TERM $LWM_PID
+	wait $LWM_PID 2> /dev/null
+
+	echo "{\"revision\":\"$REVISION\",\"scenario\":\"$scenario\",\"lwm_cpu_ms\":`expr \( $after - $before \) \* 1000 / $CLK_TCK`}"
+
+	# Turn lwm's per-event statistics into JSON too.
+	awk -v revision=$REVISION -v scenario=$scenario 'NR > 1 {
+		printf("{\"revision\":\"%s\",\"scenario\":\"%s\",\"event\":\"%s\",\"count\":%s,\"requests\":%s,\"requests_per_event\":%.2f,\"total_us\":%s,\"max_us\":%s}\n", revision, scenario, $1, $2, $3, $3 / $2, $4, $5)
+	}' $TMP/stats
+	rm -f $TMP/stats
+done
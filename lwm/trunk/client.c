@@ -159,6 +159,8 @@ Client_Add(Window w, Window root) {
 	c->window = w;
 	c->parent = root;
 	c->framed = False;
+	c->shaped = False;
+	c->shape_pending = False;
 	c->hidden = False;
 	c->state = WithdrawnState;
 	c->internal_state = INormal;
@@ -179,6 +181,7 @@ Client_Add(Window w, Window root) {
 	c->ncmapwins = 0;
 	c->cmapwins = 0;
 	c->wmcmaps = 0;
+	c->prefetch = 0;
 	c->accepts_focus = 1;
 	c->next = clients;
 
@@ -254,6 +257,8 @@ Client_Remove(Client *c) {
 	if (getScreenFromRoot(c->parent) == 0)
 		XDestroyWindow(dpy, c->parent);
 	
+	prefetch_end(c);
+	
 	if (c->ncmapwins != 0) {
 		XFree(c->cmapwins);
 		free(c->wmcmaps);
@@ -770,6 +775,7 @@ Client_Focus(Client *c, Time time) {
 extern void
 Client_Name(Client *c, const char *name, Bool is_utf8) {
 	int tx;
+	int full_tx;
 	static const char dots[] = " [...] ";
 	int cut;
 
@@ -780,9 +786,11 @@ Client_Name(Client *c, const char *name, Bool is_utf8) {
 
 	if (c->menu_name) free(c->menu_name);
 	c->menu_name = 0;
-	tx = titleWidth(popup_font_set, c);
-	if (tx <= (c->screen->display_width - (c->screen->display_width / 10)))
+	full_tx = tx = titleWidth(popup_font_set, c);
+	if (tx <= (c->screen->display_width - (c->screen->display_width / 10))) {
+		menu_rename(c, tx);
 		return;
+	}
 
 	/* the menu entry for this client will not fit on the display
 	 * (minus 10% for saftey), so produced a truncated version...
@@ -793,7 +801,11 @@ Client_Name(Client *c, const char *name, Bool is_utf8) {
 			free(c->menu_name);
 			c->menu_name = 0;
 		}
-		if (cut >= (strlen(c->name) / 2)) break;
+		if (cut >= (strlen(c->name) / 2)) {
+			/* We're back to the whole name. */
+			tx = full_tx;
+			break;
+		}
 		c->menu_name = sdup(c->name);
 		/* FIXME: this is not UTF-8 safe! */
 		sprintf(&c->menu_name[(strlen(c->name) / 2) - cut], dots);
@@ -805,4 +817,5 @@ Client_Name(Client *c, const char *name, Bool is_utf8) {
 		if (!tx) break;
 	} while (tx >
 		(c->screen->display_width - (c->screen->display_width / 10)));
+	menu_rename(c, tx);
 }
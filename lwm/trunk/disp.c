@@ -44,6 +44,7 @@ static void buttonpress(XEvent *);
 static void buttonrelease(XEvent *);
 static void focuschange(XEvent *);
 static void maprequest(XEvent *);
+static void createnotify(XEvent *);
 static void configurereq(XEvent *);
 static void unmap(XEvent *);
 static void destroy(XEvent *);
@@ -77,7 +78,7 @@ static Disp disps[] =
 	{CirculateRequest, circulaterequest},
 	{LeaveNotify, 0},
 	{ConfigureNotify, 0},
-	{CreateNotify, 0},
+	{CreateNotify, createnotify},
 	{GravityNotify, 0},
 	{MapNotify, 0},
 	{MappingNotify, 0},
@@ -295,6 +296,41 @@ static void circulaterequest(XEvent *ev) {
 	}
 }
 
+/*
+ * Note new top-level windows as soon as they're created, using the
+ * geometry in the event. This means that when the MapRequest arrives we
+ * already know about the window, rather than having to query every window
+ * on every screen to find it.
+ */
+static void
+createnotify(XEvent *ev) {
+	Client * c;
+	XCreateWindowEvent * e = &ev->xcreatewindow;
+	ScreenInfo * screen;
+	
+	screen = getScreenFromRoot(e->parent);
+	if (screen == 0 || e->override_redirect)
+		return;
+	if (e->window == screen->popup || e->window == screen->ewmh_compat)
+		return;
+	
+	c = Client_Add(e->window, screen->root);
+	
+	/* Client_Add returns the existing client if this is one of our frames. */
+	if (c == 0 || c->window != e->window)
+		return;
+	
+	c->screen = screen;
+	c->size.x = e->x;
+	c->size.y = e->y;
+	c->size.width = e->width;
+	c->size.height = e->height;
+	c->border = e->border_width;
+	
+	/* Start fetching the properties manage() will want. */
+	prefetch_start(c);
+}
+
 static void
 maprequest(XEvent *ev) {
 	Client * c;
@@ -657,6 +693,15 @@ property(XEvent * ev) {
 	if (c == 0)
 		return;
 	
+	/*
+	 * We only hear about windows we've not managed yet because we're
+	 * prefetching their properties. manage() will read them all anyway.
+	 */
+	if (c->prefetch != 0) {
+		prefetch_invalidate(c, e->atom);
+		return;
+	}
+	
 	if (e->atom == _mozilla_url || e->atom == XA_WM_NAME) {
 		getWindowName(c);
 		setactive(c, c == current, 0L);
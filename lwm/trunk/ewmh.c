@@ -175,9 +175,9 @@ ewmh_get_window_type(Window w) {
 	int i;
 	EWMHWindowType ret;
 
-	i = XGetWindowProperty(dpy, w,
+	i = prefetch_property(w,
 		ewmh_atom[_NET_WM_WINDOW_TYPE],
-		0, 100, False, XA_ATOM, &rt, &fmt, &n, &extra,
+		100, XA_ATOM, &rt, &fmt, &n, &extra,
 		(unsigned char **)&type);
 	if (i != Success || type == NULL)
 		return WTypeNone;
@@ -238,9 +238,9 @@ Bool ewmh_get_window_name(Client *c) {
 	unsigned long extra;
 	int i;
 
-	i = XGetWindowProperty(dpy, c->window,
+	i = prefetch_property(c->window,
 		ewmh_atom[_NET_WM_NAME],
-		0, 100, False, utf8_string, &rt, &fmt, &n, &extra,
+		100, utf8_string, &rt, &fmt, &n, &extra,
 		(unsigned char **)&name);
 	if (i != Success || name == NULL)
 		return False;
@@ -275,9 +275,9 @@ ewmh_get_state(Client *c) {
 	int i;
 
 	if (c == NULL) return;
-	i = XGetWindowProperty(dpy, c->window,
+	i = prefetch_property(c->window,
 		ewmh_atom[_NET_WM_STATE],
-		0, 100, False, XA_ATOM, &rt, &fmt, &n, &extra,
+		100, XA_ATOM, &rt, &fmt, &n, &extra,
 		(unsigned char **)&state);
 	if (i != Success || state == NULL) return;
 	c->wstate.skip_taskbar = False;
@@ -505,9 +505,9 @@ ewmh_get_strut(Client *c) {
 	int i;
 
 	if (c == NULL) return;
-	i = XGetWindowProperty(dpy, c->window,
+	i = prefetch_property(c->window,
 		ewmh_atom[_NET_WM_STRUT],
-		0, 5, False, XA_CARDINAL, &rt, &fmt, &n, &extra,
+		5, XA_CARDINAL, &rt, &fmt, &n, &extra,
 		(unsigned char **)&strut);
 	if (i != Success || strut == NULL || n < 4) return;
 	c->strut.left = (unsigned int) strut[0];
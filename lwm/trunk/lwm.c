@@ -196,8 +196,16 @@ main(int argc, char *argv[]) {
 		    if (FD_ISSET(dpy_fd, &readfds)) {
 			    while (XPending(dpy)) {
 				XNextEvent(dpy, &ev);
+#ifdef STATS
+				stats_begin(&ev);
+#endif
 				dispatch(&ev);
+#ifdef STATS
+				stats_end();
+#endif
 			    }
+			    /* Apply any shape changes the events brought. */
+			    flushShapes();
 		    }
 		    if (ice_fd > 0 && FD_ISSET(ice_fd, &readfds)) {
 			    session_process();
@@ -157,6 +157,9 @@ struct ScreenInfo {
 	char * display_spec;
 };
 
+/* Property requests made for a window before it was mapped; see prefetch.c. */
+typedef struct Prefetch Prefetch;
+
 typedef struct Client Client;
 struct Client {
 	Window window;		/* Client's window. */
@@ -164,6 +167,8 @@ struct Client {
 	Window trans;		/* Window that client is a transient for. */
 
 	Bool framed;		/* True is lwm is maintaining a frame */
+	Bool shaped;		/* True if the client has a bounding shape. */
+	Bool shape_pending;	/* True if the frame's shape needs updating. */
 
 	Client * next;		/* Next window in client list. */
 
@@ -198,6 +203,8 @@ struct Client {
 	int ncmapwins;
 	Window * cmapwins;
 	Colormap * wmcmaps;
+
+	Prefetch * prefetch;	/* Until managed, properties we've asked for. */
 };
 
 
@@ -304,6 +311,13 @@ extern void getColourmaps(Client *);
 extern void getTransientFor(Client *);
 extern void Terminate(int);
 
+/*	prefetch.c */
+extern void prefetch_start(Client *);
+extern void prefetch_invalidate(Client *, Atom);
+extern void prefetch_end(Client *);
+extern int prefetch_property(Window, Atom, long, Atom, Atom *, int *,
+	unsigned long *, unsigned long *, unsigned char **);
+
 /*	mouse.c */
 extern void getMousePosition(int *, int *);
 extern void hide(Client *);
@@ -312,6 +326,7 @@ extern int menu_whichitem(int, int);
 extern void menuhit(XButtonEvent *);
 extern void unhide(int, int);
 extern void menu_expose(void);
+extern void menu_rename(Client *, int);
 extern void menu_motionnotify(XEvent *);
 extern void menu_buttonrelease(XEvent *);
 
@@ -319,7 +334,9 @@ extern void menu_buttonrelease(XEvent *);
 extern int shapeEvent(XEvent *);
 extern int serverSupportsShapes(void);
 extern int isShaped(Window);
+extern void queryShape(Client *, XWindowAttributes *);
 extern void setShape(Client *);
+extern void flushShapes(void);
 
 /*	resource.c */
 extern char *font_name;
@@ -331,6 +348,14 @@ extern FocusMode focus_mode;
 extern char * sdup(char *);
 extern void parseResources(void);
 
+/*	stats.c */
+#ifdef STATS
+extern void stats_begin(XEvent *);
+extern void stats_end(void);
+extern void stats_xcb_request(unsigned long);
+extern void stats_write(void);
+#endif
+
 /*	session.c */
 extern int ice_fd;
 extern void session_init(int argc, char *argv[]);
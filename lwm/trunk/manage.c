@@ -43,6 +43,8 @@
 #include "lwm.h"
 
 static int getProperty(Window, Atom, Atom, long, unsigned char **);
+static XWMHints * getWMHints(Window);
+static int getWMNormalHints(Window, XSizeHints *);
 static int getWindowState(Window, int *);
 static void applyGravity(Client *);
 
@@ -56,7 +58,7 @@ manage(Client * c, int mapped)
 	XSetWindowAttributes attr;
 
 	/* For WM_PROTOCOLS handling. */
-	Atom * protocols;
+	Atom * protocols = 0;
 	int n;
 	int p;
 
@@ -80,7 +82,9 @@ manage(Client * c, int mapped)
 	} else {
 		c->framed = ewmh_hasframe(c);
 	}
-	if (isShaped(c->window)) c->framed = False;
+	XGetWindowAttributes(dpy, c->window, &current_attr);
+	queryShape(c, &current_attr);
+	if (c->shaped) c->framed = False;
 
 	/* get the EWMH strut - if there is one */
 	ewmh_get_strut(c);
@@ -89,7 +93,7 @@ manage(Client * c, int mapped)
 	 * Get the hints, window name, and normal hints (see ICCCM
 	 * section 4.1.2.3).
 	 */
-	hints = XGetWMHints(dpy, c->window);
+	hints = getWMHints(c->window);
 
 	getWindowName(c);
 	getNormalHints(c);
@@ -101,7 +105,6 @@ manage(Client * c, int mapped)
 	 * windows needing colourmaps that differ from the top-level
 	 * colourmap. (See ICCCM section 4.1.8.)
 	 */
-	XGetWindowAttributes(dpy, c->window, &current_attr);
 	c->cmap = current_attr.colormap;
 
 	getColourmaps(c);
@@ -111,7 +114,8 @@ manage(Client * c, int mapped)
 	 * protocols that we understand the client is prepared to
 	 * participate in. (See ICCCM section 4.1.2.7.)
 	 */
-	if (XGetWMProtocols(dpy, c->window, &protocols, &n) != 0) {
+	n = getProperty(c->window, wm_protocols, XA_ATOM, 1000000L, (unsigned char **) &protocols);
+	if (n > 0) {
 		for (p = 0; p < n; p++) {
 			if (protocols[p] == wm_delete) {
 				c->proto |= Pdelete;
@@ -136,17 +140,18 @@ manage(Client * c, int mapped)
 	if (!getWindowState(c->window, &state))
 		state = hints ? hints->initial_state : NormalState;
 
+	/* That's all the properties we wanted when the window was created. */
+	prefetch_end(c);
+
 	/*
 	 *	Sort out the window's position.
 	 */
 	{
-		Window root_window;
-		int x, y;
-		unsigned int w, h;
-		unsigned int border_width, depth;
-
-		XGetGeometry(dpy, c->window, &root_window, &x, &y, &w, &h,
-			&border_width, &depth);
+		/* XGetWindowAttributes already fetched the geometry. */
+		int x = current_attr.x;
+		int y = current_attr.y;
+		unsigned int w = current_attr.width;
+		unsigned int h = current_attr.height;
 
 		/*
 		 * Do the size first.
@@ -303,7 +308,9 @@ manage(Client * c, int mapped)
 			c->size.x, c->size.y);
 	}
 
-	setShape(c);
+	/* An unframed client has no frame of its own to shape. */
+	if (getScreenFromRoot(c->parent) == 0)
+		setShape(c);
 
 	XAddToSaveSet(dpy, c->window);
 	if (state == IconicState) {
@@ -344,10 +351,14 @@ applyGravity(Client *c) {
 
 void
 getTransientFor(Client *c) {
-	Window	trans = None;
+	Window	*trans = 0;
 
-	XGetTransientForHint(dpy, c->window, &trans);
-	c->trans = trans;
+	if (getProperty(c->window, XA_WM_TRANSIENT_FOR, XA_WINDOW, 1L, (unsigned char **) &trans) > 0) {
+		c->trans = trans[0];
+		XFree(trans);
+	} else {
+		c->trans = None;
+	}
 }
 
 void
@@ -438,6 +449,10 @@ getColourmaps(Client *c) {
 /*ARGSUSED*/
 void
 Terminate(int signal) {
+#ifdef STATS
+	stats_write();
+#endif
+
 	/* Set all clients free. */
 	Client_FreeAll();
 	
@@ -468,7 +483,7 @@ getProperty(Window w, Atom a, Atom type, long len, unsigned char **p) {
 	/*
 	 *	len is in 32-bit multiples.
 	 */
-	status = XGetWindowProperty(dpy, w, a, 0L, len, False, type, &real_type, &format, &n, &extra, p);
+	status = prefetch_property(w, a, len, type, &real_type, &format, &n, &extra, p);
 	if (status != Success || *p == 0)
 		return -1;
 	if (n == 0)
@@ -494,10 +509,10 @@ getWindowName(Client *c) {
 	was_nameless = (c->name == 0);
 	
 	if (ewmh_get_window_name(c) == False &&
-		XGetWindowProperty(dpy, c->window, _mozilla_url, 0L, 100L, False, AnyPropertyType, &actual_type, &format, &n, &extra, (unsigned char **) &name) == Success && name && *name != '\0' && n != 0) {
+		prefetch_property(c->window, _mozilla_url, 100L, AnyPropertyType, &actual_type, &format, &n, &extra, (unsigned char **) &name) == Success && name && *name != '\0' && n != 0) {
 		Client_Name(c, name, False);
 		XFree(name);
-	} else if (XGetWindowProperty(dpy, c->window, XA_WM_NAME, 0L, 100L, False, AnyPropertyType, &actual_type, &format, &n, &extra, (unsigned char **) &name) == Success && name && *name != '\0' && n != 0) {
+	} else if (prefetch_property(c->window, XA_WM_NAME, 100L, AnyPropertyType, &actual_type, &format, &n, &extra, (unsigned char **) &name) == Success && name && *name != '\0' && n != 0) {
 		/* That rather unpleasant condition is necessary because xwsh uses
 	 	* COMPOUND_TEXT rather than STRING for its WM_NAME property,
 	 	* and anonymous xwsh windows are annoying.
@@ -517,7 +532,6 @@ getWindowName(Client *c) {
 void
 getNormalHints(Client *c) {
 	int x, y, w, h;
-	long msize;
 
 	/* We have to be a little careful here. The ICCCM says that the x, y
 	 * and width, height components aren't used. So we use them. That means
@@ -529,7 +543,7 @@ getNormalHints(Client *c) {
 	h = c->size.height;
 
 	/* Do the get. */
-	if (XGetWMNormalHints(dpy, c->window, &c->size, &msize) == 0)
+	if (getWMNormalHints(c->window, &c->size) == 0)
 		c->size.flags = 0;
 
 	if (c->framed == True) {
@@ -586,6 +600,86 @@ getNormalHints(Client *c) {
 	c->size.height = h;
 }
 
+/*
+ * These are XGetWMHints and XGetWMNormalHints, but going through
+ * getProperty so that they can use properties prefetched on CreateNotify.
+ * The property layouts are from ICCCM sections 4.1.2.3 and 4.1.2.4.
+ */
+static XWMHints *
+getWMHints(Window w) {
+	long	*p = 0;
+	int	n;
+	XWMHints	*hints;
+
+	/* Pre-ICCCM clients leave out the window group. */
+	n = getProperty(w, XA_WM_HINTS, XA_WM_HINTS, 9L, (unsigned char **) &p);
+	if (n <= 0)
+		return 0;
+	if (n < 8 || (hints = XAllocWMHints()) == 0) {
+		XFree(p);
+		return 0;
+	}
+
+	hints->flags = p[0];
+	hints->input = p[1] ? True : False;
+	hints->initial_state = (int) p[2];
+	hints->icon_pixmap = (Pixmap) p[3];
+	hints->icon_window = (Window) p[4];
+	hints->icon_x = (int) p[5];
+	hints->icon_y = (int) p[6];
+	hints->icon_mask = (Pixmap) p[7];
+	if (n >= 9) {
+		hints->window_group = (XID) p[8];
+	} else {
+		hints->window_group = 0;
+		hints->flags &= ~WindowGroupHint;
+	}
+	XFree(p);
+	return hints;
+}
+
+static int
+getWMNormalHints(Window w, XSizeHints *hints) {
+	long	*p = 0;
+	int	n;
+
+	/* Pre-ICCCM clients leave out the base size and gravity. */
+	n = getProperty(w, XA_WM_NORMAL_HINTS, XA_WM_SIZE_HINTS, 18L, (unsigned char **) &p);
+	if (n <= 0)
+		return 0;
+	if (n < 15) {
+		XFree(p);
+		return 0;
+	}
+
+	hints->flags = p[0] & (USPosition | USSize | PAllHints);
+	hints->x = (int) p[1];
+	hints->y = (int) p[2];
+	hints->width = (int) p[3];
+	hints->height = (int) p[4];
+	hints->min_width = (int) p[5];
+	hints->min_height = (int) p[6];
+	hints->max_width = (int) p[7];
+	hints->max_height = (int) p[8];
+	hints->width_inc = (int) p[9];
+	hints->height_inc = (int) p[10];
+	hints->min_aspect.x = (int) p[11];
+	hints->min_aspect.y = (int) p[12];
+	hints->max_aspect.x = (int) p[13];
+	hints->max_aspect.y = (int) p[14];
+	if (n >= 18) {
+		hints->flags |= p[0] & (PBaseSize | PWinGravity);
+		hints->base_width = (int) p[15];
+		hints->base_height = (int) p[16];
+		hints->win_gravity = (int) p[17];
+	} else {
+		hints->base_width = hints->base_height = 0;
+		hints->win_gravity = 0;
+	}
+	XFree(p);
+	return 1;
+}
+
 static int
 getWindowState(Window w, int *state) {
 	long	*p = 0;
@@ -1,6 +1,6 @@
 #!/bin/sh
 
-DISTFILES="AUTHORS BUGS COPYING ChangeLog INSTALL Imakefile README TODO client.c cursor.c disp.c error.c ewmh.c ewmh.h lwm.c lwm.h lwm.man manage.c mouse.c no_xmkmf_makefile resource.c session.c shape.c"
+DISTFILES="AUTHORS BUGS COPYING ChangeLog INSTALL Imakefile README TODO client.c cursor.c disp.c error.c ewmh.c ewmh.h lwm.c lwm.h lwm.man manage.c mouse.c no_xmkmf_makefile resource.c session.c prefetch.c shape.c stats.c"
 
 VERSION=`cat VERSION`
 mkdir /tmp/lwm-$VERSION
@@ -33,12 +33,33 @@ static int current_item;	/* Last known selected menu item. -1 if none. */
 typedef struct menuitem menuitem;
 struct menuitem {
 	Client * client;
+	int width;	/* Cached titleWidth of the client's label. */
 	menuitem * next;
 };
 
 static menuitem * hidden_menu = 0;
 
+/*
+ * Measuring labels is slow, so we cache the menu's geometry, and only
+ * recompute it when a window is hidden, unhidden or renamed. The labels
+ * are drawn once into an off-screen pixmap; exposures and highlighting
+ * just copy from it.
+ */
+static Bool menu_geometry_valid = False;
+static int menu_width;		/* Width of menu. */
+static int menu_length;		/* Number of items on the menu. */
+
+static Pixmap menu_pixmap = None;
+static GC menu_pixmap_gc = 0;
+static ScreenInfo * menu_pixmap_screen = 0;
+static int menu_pixmap_width;
+static int menu_pixmap_height;
+static Bool menu_pixmap_valid = False;
+
 static void getMenuDimensions(int *, int *, int *);
+static void invalidateMenu(void);
+static void renderMenu(void);
+static void drawMenuItem(int);
 
 void
 getMousePosition(int * x, int * y) {
@@ -77,20 +98,132 @@ menu_whichitem(int x, int y) {
 
 static void
 getMenuDimensions(int *width, int *height, int *length) {
-	int w;	/* Widest string so far. */
-	int i;	/* Menu item. */
+	if (!menu_geometry_valid) {
+		int w;	/* Widest string so far. */
+		int i;	/* Menu item. */
+		
+		menuitem *m = hidden_menu;
+		
+		w = 0;
+		for (i = 0; m != 0; m = m->next, i++) {
+			int tw = m->width + 4;
+			if (tw > w) w = tw;
+		}
+		
+		menu_width = w + border;
+		menu_length = i;
+		menu_geometry_valid = True;
+	}
 	
-	menuitem *m = hidden_menu;
+	*width = menu_width;
+	*height = popupHeight();
+	*length = menu_length;
+}
+
+static void
+invalidateMenu(void) {
+	menu_geometry_valid = False;
+	menu_pixmap_valid = False;
+}
+
+/*
+ * Draws every label into the off-screen pixmap, (re)creating it if the
+ * menu has changed size or moved to another screen.
+ */
+static void
+renderMenu(void) {
+	int i;		/* Menu item being drawn. */
+	int width;	/* Width of each item. */
+	int height;	/* Height of each item. */
+	int length;	/* Number of menu items. */
+	menuitem *m;
+	
+	getMenuDimensions(&width, &height, &length);
+	if (length == 0)
+		return;
 	
-	w = 0;
-	for (i = 0; m != 0; m = m->next, i++) {
-		int tw = titleWidth(popup_font_set, m->client) + 4;
-		if (tw > w) w = tw;
+	if (menu_pixmap != None && (menu_pixmap_screen != current_screen ||
+			width != menu_pixmap_width || length * height != menu_pixmap_height)) {
+		XFreePixmap(dpy, menu_pixmap);
+		menu_pixmap = None;
+	}
+	if (menu_pixmap_gc != 0 && menu_pixmap_screen != current_screen) {
+		XFreeGC(dpy, menu_pixmap_gc);
+		menu_pixmap_gc = 0;
+	}
+	if (menu_pixmap == None) {
+		menu_pixmap = XCreatePixmap(dpy, current_screen->popup,
+			width, length * height,
+			DefaultDepth(dpy, current_screen - screens));
+		menu_pixmap_width = width;
+		menu_pixmap_height = length * height;
 	}
+	if (menu_pixmap_gc == 0) {
+		XGCValues gv;
+		gv.function = GXcopy;
+		gv.graphics_exposures = False;
+		menu_pixmap_gc = XCreateGC(dpy, menu_pixmap,
+			GCFunction | GCGraphicsExposures, &gv);
+	}
+	menu_pixmap_screen = current_screen;
 	
-	*width = w + border;
-	*height = popupHeight();
-	*length = i;
+	XSetForeground(dpy, menu_pixmap_gc, current_screen->white);
+	XFillRectangle(dpy, menu_pixmap, menu_pixmap_gc,
+		0, 0, width, length * height);
+	XSetForeground(dpy, menu_pixmap_gc, current_screen->black);
+	
+	for (m = hidden_menu, i = 0; m != 0; m = m->next, i++) {
+		int tx = (width - m->width) / 2;
+		int ty = i * height + ascent(popup_font_set_ext);
+		char *name;
+		int namelen;
+
+		if (m->client->menu_name == NULL) {
+			name = m->client->name;
+			namelen = m->client->namelen;
+		} else {
+			name = m->client->menu_name;
+			namelen = m->client->menu_namelen;
+		}
+		if (name == NULL)
+			continue;
+
+#ifdef X_HAVE_UTF8_STRING
+		if (m->client->name_utf8 == True)
+			Xutf8DrawString(dpy, menu_pixmap,
+				popup_font_set, 
+				menu_pixmap_gc, tx, ty,
+				name, namelen);
+		else
+#endif
+			XmbDrawString(dpy, menu_pixmap,
+				popup_font_set,
+				menu_pixmap_gc, tx, ty,
+				name, namelen);
+	}
+	
+	menu_pixmap_valid = True;
+}
+
+/*
+ * Copies one item from the pixmap to the menu window, highlighting it if
+ * it's the current item.
+ */
+static void
+drawMenuItem(int item) {
+	int width;	/* Width of menu. */
+	int height;	/* Height of each menu item. */
+	int length;	/* Number of menu items. */
+	
+	getMenuDimensions(&width, &height, &length);
+	if (item < 0 || item >= length || menu_pixmap == None)
+		return;
+	
+	XCopyArea(dpy, menu_pixmap, current_screen->popup, menu_pixmap_gc,
+		0, item * height, width, height, 0, item * height);
+	if (item == current_item)
+		XFillRectangle(dpy, current_screen->popup, current_screen->menu_gc,
+			0, item * height, width, height);
 }
 
 void
@@ -127,6 +260,9 @@ menuhit(XButtonEvent *e) {
 	
 	current_item = menu_whichitem(e->x_root, e->y_root);
 	
+	if (!menu_pixmap_valid || menu_pixmap_screen != current_screen)
+		renderMenu();
+	
 	XMoveResizeWindow(dpy, current_screen->popup, start_x, start_y,
 		width, length * height);
 	XMapRaised(dpy, current_screen->popup);
@@ -148,8 +284,10 @@ hide(Client *c) {
 	if (newitem == 0)
 		return;
 	newitem->client = c;
+	newitem->width = titleWidth(popup_font_set, c);
 	newitem->next = hidden_menu;
 	hidden_menu = newitem;
+	invalidateMenu();
 
 	/* Actually hide the window. */
 	XUnmapWindow(dpy, c->parent);
@@ -189,6 +327,7 @@ unhide(int n, int map) {
 		prev->next = m->next;
 	}
 	free(m);
+	invalidateMenu();
 
 	c->hidden = False;
 
@@ -225,75 +364,80 @@ unhidec(Client *c, int map) {
 	}
 }
 
+/*
+ * Called when a client's name changes, with the new width of its label,
+ * so that if it's hidden its label can be drawn again.
+ */
+void
+menu_rename(Client *c, int label_width) {
+	menuitem *m;
+	int old_width;
+	int width;	/* Width of menu. */
+	int height;	/* Height of each menu item. */
+	int length;	/* Number of menu items. */
+	
+	for (m = hidden_menu; m != 0; m = m->next) {
+		if (m->client == c)
+			break;
+	}
+	if (m == 0)
+		return;
+	
+	getMenuDimensions(&old_width, &height, &length);
+	m->width = label_width;
+	invalidateMenu();
+	if (mode != wm_menu_up)
+		return;
+	
+	/* If the widest label has changed, so has the menu. */
+	getMenuDimensions(&width, &height, &length);
+	if (width != old_width) {
+		if (start_x + width > current_screen->display_width)
+			start_x = current_screen->display_width - width;
+		if (start_x < 0)
+			start_x = 0;
+		XMoveResizeWindow(dpy, current_screen->popup, start_x, start_y,
+			width, length * height);
+	}
+	menu_expose();
+}
+
 void
 menu_expose(void) {
 	int i;		/* Menu item being drawn. */
 	int width;	/* Width of each item. */
 	int height;	/* Height of each item. */
 	int length;	/* Number of menu items. */
-	menuitem *m;
-
-	getMenuDimensions(&width, &height, &length);
 
-	/* Redraw the labels. */
-	for (m = hidden_menu, i = 0; m != 0; m = m->next, i++) {
-		int tx = (width - titleWidth(popup_font_set, m->client)) / 2;
-		int ty = i * height + ascent(popup_font_set_ext);
-		char *name;
-		int namelen;
-
-		if (m->client->menu_name == NULL) {
-			name = m->client->name;
-			namelen = m->client->namelen;
-		} else {
-			name = m->client->menu_name;
-			namelen = m->client->menu_namelen;
-		}
+	if (!menu_pixmap_valid || menu_pixmap_screen != current_screen)
+		renderMenu();
+	if (menu_pixmap == None)
+		return;
 
-#ifdef X_HAVE_UTF8_STRING
-		if (m->client->name_utf8 == True)
-			Xutf8DrawString(dpy, m->client->screen->popup,
-				popup_font_set, 
-				current_screen->menu_gc, tx, ty,
-				name, namelen);
-		else
-#endif
-			XmbDrawString(dpy, m->client->screen->popup,
-				popup_font_set,
-				current_screen->menu_gc, tx, ty,
-				name, namelen);
-	}
+	getMenuDimensions(&width, &height, &length);
+	XCopyArea(dpy, menu_pixmap, current_screen->popup, menu_pixmap_gc,
+		0, 0, width, length * height, 0, 0);
 
 	/* Highlight current item if there is one. */
-	if (current_item >= 0 && current_item < length)
+	i = current_item;
+	if (i >= 0 && i < length)
 		XFillRectangle(dpy, current_screen->popup, current_screen->menu_gc,
-			0, current_item * height, width, height);
+			0, i * height, width, height);
 }
 
 void
 menu_motionnotify(XEvent* ev) {
 	int old;			/* Old menu position. */
-	int width;		/* Width of menu. */
-	int height;		/* Height of each menu item. */
-	int length;		/* Number of menu items. */
 	XButtonEvent *e = &ev->xbutton;
 	
-	getMenuDimensions(&width, &height, &length);
-	
 	old = current_item;
 	current_item = menu_whichitem(e->x_root, e->y_root);
 	
 	if (current_item == old) return;
 	
-	/* Unhighlight the old position, if it was on the menu. */
-	if (old >= 0 && old < length)
-		XFillRectangle(dpy, current_screen->popup, current_screen->menu_gc,
-			0, old * height, width, height);
-	
-	/* Highlight the new position, if it's on the menu. */
-	if (current_item >= 0 && current_item < length)
-		XFillRectangle(dpy, current_screen->popup, current_screen->menu_gc,
-			0, current_item * height, width, height);
+	/* Unhighlight the old position, and highlight the new one. */
+	drawMenuItem(old);
+	drawMenuItem(current_item);
 }
 
 void
@@ -0,0 +1,267 @@
+/*
+ * Asynchronous property fetches for new windows.
+ *
+ * A client typically creates its window, sets its properties and maps it
+ * in one go, so by the time we see the CreateNotify the properties manage()
+ * wants are usually already there. We ask for all of them then, through
+ * XCB so we needn't wait for the replies, and manage() picks the replies up
+ * when the MapRequest arrives instead of making a round trip per property.
+ *
+ * We select PropertyChangeMask before asking, so any property that changes
+ * after our request was answered produces a PropertyNotify, which arrives
+ * before the MapRequest and makes us forget the stale reply. Anything we
+ * didn't prefetch, or have forgotten, is fetched synchronously as before.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <X11/X.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xatom.h>
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
+
+#include "lwm.h"
+#include "ewmh.h"
+
+/* How much of each property to ask for, in 32-bit units. */
+#define PREFETCH_LENGTH 1024L
+
+/* The properties manage() reads. */
+enum {
+	PWindowType, PState, PStrut, PNetName, PMozillaUrl, PName, PHints,
+	PNormalHints, PProtocols, PTransientFor, PColormapWindows, PWMState,
+	PMotifHints, P_LAST
+};
+
+struct Prefetch {
+	xcb_get_property_cookie_t cookie[P_LAST];
+	xcb_get_property_reply_t * reply[P_LAST];
+	Bool collected[P_LAST];	/* True once the cookie has been used up. */
+	Bool stale[P_LAST];	/* True if the property changed since. */
+};
+
+static Atom
+prefetchAtom(int i) {
+	switch (i) {
+	case PWindowType: return ewmh_atom[_NET_WM_WINDOW_TYPE];
+	case PState: return ewmh_atom[_NET_WM_STATE];
+	case PStrut: return ewmh_atom[_NET_WM_STRUT];
+	case PNetName: return ewmh_atom[_NET_WM_NAME];
+	case PMozillaUrl: return _mozilla_url;
+	case PName: return XA_WM_NAME;
+	case PHints: return XA_WM_HINTS;
+	case PNormalHints: return XA_WM_NORMAL_HINTS;
+	case PProtocols: return wm_protocols;
+	case PTransientFor: return XA_WM_TRANSIENT_FOR;
+	case PColormapWindows: return wm_colormaps;
+	case PWMState: return wm_state;
+	case PMotifHints: return motif_wm_hints;
+	}
+	return None;
+}
+
+static int
+prefetchIndex(Atom a) {
+	int i;
+
+	for (i = 0; i < P_LAST; i++)
+		if (prefetchAtom(i) == a)
+			return i;
+	return -1;
+}
+
+/*
+ * Forgets what we know about property i, discarding the reply if it
+ * hasn't arrived yet.
+ */
+static void
+forget(Prefetch *p, int i) {
+	if (p->collected[i] == False)
+		xcb_discard_reply(XGetXCBConnection(dpy), p->cookie[i].sequence);
+	else if (p->reply[i] != 0)
+		free(p->reply[i]);
+	p->reply[i] = 0;
+	p->collected[i] = True;
+	p->stale[i] = True;
+}
+
+/*
+ * Called on CreateNotify: asks for all the properties manage() will want.
+ */
+void
+prefetch_start(Client *c) {
+	xcb_connection_t * conn = XGetXCBConnection(dpy);
+	xcb_void_cookie_t cookie;
+	uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE;
+	Prefetch * p;
+	int i;
+
+	if (c->prefetch != 0)
+		return;
+	p = calloc(1, sizeof *p);
+	if (p == 0)
+		return;
+
+	/*
+	 * The window may already have gone, so make any error come back to
+	 * us rather than to the error handler, and ignore it. If the window
+	 * has gone, the DestroyNotify will clean up.
+	 */
+	cookie = xcb_change_window_attributes_checked(conn, c->window,
+		XCB_CW_EVENT_MASK, &mask);
+	xcb_discard_reply(conn, cookie.sequence);
+
+	for (i = 0; i < P_LAST; i++) {
+		p->cookie[i] = xcb_get_property(conn, 0, c->window,
+			prefetchAtom(i), XCB_GET_PROPERTY_TYPE_ANY,
+			0, PREFETCH_LENGTH);
+	}
+
+#ifdef STATS
+	stats_xcb_request(p->cookie[P_LAST - 1].sequence);
+#endif
+
+	/* Xlib's XFlush doesn't flush XCB's buffer unless Xlib's has something in it. */
+	xcb_flush(conn);
+	c->prefetch = p;
+}
+
+/*
+ * Called on PropertyNotify for a window we haven't managed yet.
+ */
+void
+prefetch_invalidate(Client *c, Atom a) {
+	int i;
+
+	if (c->prefetch == 0 || (i = prefetchIndex(a)) < 0)
+		return;
+	forget(c->prefetch, i);
+}
+
+/*
+ * Called once manage() is done with the replies, or when the window goes
+ * away before it's mapped.
+ */
+void
+prefetch_end(Client *c) {
+	int i;
+
+	if (c->prefetch == 0)
+		return;
+	for (i = 0; i < P_LAST; i++)
+		forget(c->prefetch, i);
+	free(c->prefetch);
+	c->prefetch = 0;
+}
+
+/*
+ * Converts a reply into what XGetWindowProperty would have returned for
+ * the given length and type. Returns False if the reply doesn't have
+ * enough of the property to do that.
+ */
+static Bool
+convertReply(xcb_get_property_reply_t *r, long length, Atom req_type,
+	Atom *actual_type, int *format, unsigned long *nitems,
+	unsigned long *bytes_after, unsigned char **prop) {
+	unsigned long have;
+	unsigned long total;
+	unsigned long nbytes;
+	unsigned long i;
+	unsigned char * value;
+	unsigned char * data;
+
+	*actual_type = r->type;
+	*format = r->format;
+	*nitems = 0;
+	*bytes_after = 0;
+	*prop = 0;
+	if (r->type == XCB_NONE) {
+		*format = 0;
+		return True;
+	}
+
+	have = xcb_get_property_value_length(r);
+	total = have + r->bytes_after;
+	if (req_type != AnyPropertyType && r->type != req_type) {
+		*bytes_after = total;
+		return True;
+	}
+
+	nbytes = 4 * (unsigned long) length;
+	if (nbytes > total)
+		nbytes = total;
+	if (nbytes > have || r->format == 0)
+		return False;
+
+	/*
+	 * Like Xlib, we hand back format 32 data as longs and add a NUL. The
+	 * caller frees the result with XFree, which is free.
+	 */
+	value = xcb_get_property_value(r);
+	*nitems = nbytes / (r->format / 8);
+	*bytes_after = total - nbytes;
+	switch (r->format) {
+	case 32:
+		data = malloc(*nitems * sizeof(long) + 1);
+		if (data == 0)
+			return False;
+		for (i = 0; i < *nitems; i++)
+			((long *) data)[i] = ((uint32_t *) value)[i];
+		break;
+	case 16:
+		data = malloc(*nitems * sizeof(short) + 1);
+		if (data == 0)
+			return False;
+		for (i = 0; i < *nitems; i++)
+			((short *) data)[i] = ((uint16_t *) value)[i];
+		break;
+	default:
+		data = malloc(nbytes + 1);
+		if (data == 0)
+			return False;
+		memcpy(data, value, nbytes);
+		data[nbytes] = '\0';
+		break;
+	}
+	*prop = data;
+	return True;
+}
+
+/*
+ * Like XGetWindowProperty with an offset of 0 and delete False, but uses
+ * the reply to our CreateNotify request if there is one.
+ */
+int
+prefetch_property(Window w, Atom a, long length, Atom req_type,
+	Atom *actual_type, int *format, unsigned long *nitems,
+	unsigned long *bytes_after, unsigned char **prop) {
+	Client * c;
+	Prefetch * p;
+	xcb_generic_error_t * error = 0;
+	int i;
+
+	c = Client_Get(w);
+	if (c != 0 && c->window == w && (p = c->prefetch) != 0 &&
+		(i = prefetchIndex(a)) >= 0 && p->stale[i] == False) {
+		if (p->collected[i] == False) {
+			p->reply[i] = xcb_get_property_reply(XGetXCBConnection(dpy),
+				p->cookie[i], &error);
+			p->collected[i] = True;
+			if (error != 0) {
+				/* The window has gone. */
+				free(error);
+				*prop = 0;
+				return BadWindow;
+			}
+		}
+		if (p->reply[i] != 0 &&
+			convertReply(p->reply[i], length, req_type, actual_type,
+				format, nitems, bytes_after, prop) == True)
+			return Success;
+	}
+	return XGetWindowProperty(dpy, w, a, 0L, length, False, req_type,
+		actual_type, format, nitems, bytes_after, prop);
+}
@@ -33,28 +33,108 @@
 
 #include "lwm.h"
 
+#ifdef SHAPE
+/* How many clients have shape_pending set. */
+static int pending_shape_count = 0;
+#endif
+
+#ifdef SHAPE
+/*
+ * A bounding region that is just the window's own rectangle isn't a shape
+ * worth the name, and mustn't cost the client its frame. The extents are
+ * relative to the window's origin, so they include its border.
+ */
+static int
+isRealShape(int bounding_shaped, int x, int y, unsigned int width,
+	unsigned int height, int bw, unsigned int window_width,
+	unsigned int window_height) {
+	if (!bounding_shaped)
+		return 0;
+	return x != -bw || y != -bw || width != window_width + 2 * bw ||
+		height != window_height + 2 * bw;
+}
+#endif
+
+/*
+ * Finds out whether the client has a bounding shape, and asks to be told
+ * when that changes. XShapeQueryExtents has a small fixed-size reply, unlike
+ * XShapeGetRectangles, and the ShapeNotify events we select tell us
+ * everything we need from then on.
+ */
 /*ARGSUSED*/
-extern void 
-setShape(Client *c) {
+extern void
+queryShape(Client *c, XWindowAttributes *attr) {
 #ifdef  SHAPE
-	int n;
-	int order;
-	XRectangle *rect;
+	int bounding_shaped;
+	int clip_shaped;
+	int x, y, cx, cy;
+	unsigned int width, height, cwidth, cheight;
 
 	if (shape) {
+		/* Select first, so we can't miss a change after the query. */
 		XShapeSelectInput(dpy, c->window, ShapeNotifyMask);
-		rect = XShapeGetRectangles(dpy, c->window, ShapeBounding,
-			&n, &order);
-		if (n > 1)
+		c->shaped = False;
+		if (XShapeQueryExtents(dpy, c->window, &bounding_shaped,
+				&x, &y, &width, &height, &clip_shaped,
+				&cx, &cy, &cwidth, &cheight))
+			c->shaped = isRealShape(bounding_shaped, x, y, width,
+				height, attr->border_width, attr->width,
+				attr->height);
+	}
+#else
+#endif
+}
+
+/*
+ * Makes the frame's shape match the client's, as last reported.
+ */
+/*ARGSUSED*/
+extern void 
+setShape(Client *c) {
+#ifdef  SHAPE
+	if (shape) {
+		if (c->shaped)
 			XShapeCombineShape(dpy, c->parent, ShapeBounding,
 				border - 1, border - 1, c->window,
 				ShapeBounding, ShapeSet);
-		XFree(rect);
+		else
+			XShapeCombineMask(dpy, c->parent, ShapeBounding,
+				0, 0, None, ShapeSet);
 	}
 #else
 #endif
 }
 
+/*
+ * Recombines the shapes of clients that have changed since we were last
+ * called. Clients that reshape themselves continually send bursts of
+ * ShapeNotify events; we only want to do the work once per burst.
+ */
+extern void
+flushShapes(void) {
+#ifdef  SHAPE
+	Client *c;
+
+	if (pending_shape_count == 0)
+		return;
+	for (c = client_head(); c != 0; c = c->next) {
+		if (c->shape_pending) {
+			c->shape_pending = False;
+			/* Until it's managed, a client's parent is the root. */
+			if (getScreenFromRoot(c->parent) == 0)
+				setShape(c);
+		}
+	}
+	pending_shape_count = 0;
+	/*
+	 * We're called after the main loop's last XPending, so nothing
+	 * else will flush these before we block in select.
+	 */
+	XFlush(dpy);
+#else
+#endif
+}
+
 /*ARGSUSED*/
 extern int
 shapeEvent(XEvent *ev) {
@@ -62,10 +142,29 @@ shapeEvent(XEvent *ev) {
 	if (shape && ev->type == shape_event) {
 		Client *c;
 		XShapeEvent *e = (XShapeEvent *)ev;
+		unsigned int width, height;
 
+		if (e->kind != ShapeBounding)
+			return 1;
 		c = Client_Get(e->window);
-		if (c != 0)
-			setShape(c);
+		if (c != 0 && c->window == e->window) {
+			/*
+			 * The event tells us the extents; no need to ask. We
+			 * set the border width of the windows we manage to 0.
+			 */
+			width = c->size.width;
+			height = c->size.height;
+			if (c->framed == True) {
+				width -= 2 * border;
+				height -= 2 * border;
+			}
+			c->shaped = isRealShape(e->shaped, e->x, e->y,
+				e->width, e->height, 0, width, height);
+			if (!c->shape_pending) {
+				c->shape_pending = True;
+				pending_shape_count++;
+			}
+		}
 		return 1;
 	}
 #else
@@ -77,14 +176,19 @@ shapeEvent(XEvent *ev) {
 extern int
 isShaped(Window w) {
 #ifdef SHAPE
-	int	n;
-	int	order;
-	XRectangle	*rect;
-
-	rect = XShapeGetRectangles(dpy, w, ShapeBounding, &n, &order);
-	XFree(rect);
+	int bounding_shaped;
+	int clip_shaped;
+	int x, y, cx, cy;
+	unsigned int width, height, cwidth, cheight;
+	XWindowAttributes attr;
 
-	return (n > 1);
+	if (!XShapeQueryExtents(dpy, w, &bounding_shaped, &x, &y,
+			&width, &height, &clip_shaped, &cx, &cy, &cwidth, &cheight))
+		return 0;
+	if (!bounding_shaped || !XGetWindowAttributes(dpy, w, &attr))
+		return 0;
+	return isRealShape(bounding_shaped, x, y, width, height,
+		attr.border_width, attr.width, attr.height);
 #else
 	return 0;
 #endif
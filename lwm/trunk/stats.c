@@ -0,0 +1,125 @@
+/*
+ * Per-event-type statistics for benchmarking: how many of each event we
+ * handled, how many X requests handling them issued, and how long it took.
+ * Compile with -DSTATS and set LWM_STATS to the name of a file, and the
+ * statistics are written there when lwm exits. See bench/README.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sys/time.h>
+
+#include <X11/X.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#include "lwm.h"
+
+#ifdef STATS
+
+static char *event_names[] = {
+	0, 0, "KeyPress", "KeyRelease", "ButtonPress", "ButtonRelease",
+	"MotionNotify", "EnterNotify", "LeaveNotify", "FocusIn", "FocusOut",
+	"KeymapNotify", "Expose", "GraphicsExpose", "NoExpose",
+	"VisibilityNotify", "CreateNotify", "DestroyNotify", "UnmapNotify",
+	"MapNotify", "MapRequest", "ReparentNotify", "ConfigureNotify",
+	"ConfigureRequest", "GravityNotify", "ResizeRequest",
+	"CirculateNotify", "CirculateRequest", "PropertyNotify",
+	"SelectionClear", "SelectionRequest", "SelectionNotify",
+	"ColormapNotify", "ClientMessage", "MappingNotify",
+};
+#define NEVENT_NAMES ((int) (sizeof(event_names)/sizeof(event_names[0])))
+
+typedef struct EventStats EventStats;
+struct EventStats {
+	unsigned long count;
+	unsigned long requests;
+	double total_us;
+	double max_us;
+};
+
+/* Extension events (such as ShapeNotify) all share the last slot. */
+static EventStats stats[LASTEvent + 1];
+
+static int current_type;
+static unsigned long start_request;
+static struct timeval start_time;
+
+/* The sequence number of the last request we made through XCB. */
+static unsigned long last_xcb_request;
+
+/*
+ * Xlib doesn't see the requests we make through XCB until it next makes
+ * one of its own, but they're numbered in the same sequence, so the last
+ * request we've made is the later of Xlib's and XCB's.
+ */
+static unsigned long
+lastRequest(void) {
+	unsigned long last_xlib_request = NextRequest(dpy) - 1;
+
+	return (last_xcb_request > last_xlib_request) ? last_xcb_request :
+		last_xlib_request;
+}
+
+/*
+ * Called with the sequence number of each request made through XCB.
+ */
+void
+stats_xcb_request(unsigned long sequence) {
+	if (sequence > last_xcb_request)
+		last_xcb_request = sequence;
+}
+
+void
+stats_begin(XEvent *ev) {
+	current_type = (ev->type < LASTEvent) ? ev->type : LASTEvent;
+	start_request = lastRequest();
+	gettimeofday(&start_time, 0);
+}
+
+void
+stats_end(void) {
+	struct timeval end_time;
+	EventStats *s = &stats[current_type];
+	double us;
+
+	gettimeofday(&end_time, 0);
+	us = (end_time.tv_sec - start_time.tv_sec) * 1e6 +
+		(end_time.tv_usec - start_time.tv_usec);
+
+	s->count++;
+	s->requests += lastRequest() - start_request;
+	s->total_us += us;
+	if (us > s->max_us)
+		s->max_us = us;
+}
+
+void
+stats_write(void) {
+	char *filename;
+	FILE *fp;
+	int i;
+
+	filename = getenv("LWM_STATS");
+	if (filename == 0)
+		return;
+	fp = fopen(filename, "w");
+	if (fp == 0) {
+		perror(filename);
+		return;
+	}
+
+	fprintf(fp, "event\tcount\trequests\ttotal_us\tmax_us\n");
+	for (i = 0; i <= LASTEvent; i++) {
+		if (stats[i].count == 0)
+			continue;
+		fprintf(fp, "%s\t%lu\t%lu\t%.0f\t%.0f\n",
+			(i < NEVENT_NAMES) ? event_names[i] : "Extension",
+			stats[i].count, stats[i].requests,
+			stats[i].total_us, stats[i].max_us);
+	}
+	fclose(fp);
+}
+
+#endif
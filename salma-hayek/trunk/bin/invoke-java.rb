@@ -196,12 +196,114 @@ class Java
     return java_version
   end
 
+  # Running "java -version" costs a whole JVM start, which is a large fraction of our start-up time on a cold NFS-mounted install.
+  # The answer only changes when the JVM is replaced, so we remember it, keyed on the real pathname and mtime of the executable (and of the JDK, for java-launcher).
+  def java_version_cache_pathname()
+    cache_directory = ENV["XDG_CACHE_HOME"]
+    if cache_directory == nil || cache_directory == ""
+      home = ENV["HOME"]
+      if home == nil
+        return nil
+      end
+      cache_directory = File.join(home, ".cache")
+    end
+    return File.join(cache_directory, "org.jessies", "java-versions.yaml")
+  end
+  
+  def read_java_version_cache(cache_pathname)
+    require "yaml"
+    cache = YAML.load_file(cache_pathname)
+    if cache.kind_of?(Hash)
+      return cache
+    end
+    return {}
+  rescue Exception
+    # A missing or corrupt cache just means we have to ask the JVM.
+    return {}
+  end
+  
+  def write_java_version_cache(cache_pathname, cache)
+    require "fileutils"
+    require "yaml"
+    FileUtils.mkdir_p(File.dirname(cache_pathname))
+    # Write a temporary file and rename it so concurrent launches never see a partial file.
+    temporary_pathname = "#{cache_pathname}.#{Process.pid}"
+    File.open(temporary_pathname, "w") { |file| file.write(cache.to_yaml()) }
+    File.rename(temporary_pathname, cache_pathname)
+  rescue SystemCallError
+    # Failing to cache the result isn't fatal.
+  end
+  
+  # java-launcher loads whichever JVM it finds rather than being one, so replacing the JDK doesn't change its mtime.
+  # Describe the JDK it would pick up, so that its cache entries go stale when that does.
+  def java_launcher_jdk_key()
+    jdk_root = nil
+    if target_os() == "Cygwin"
+      jdk_root = findJdkFromRegistry() {
+        |version|
+        version >= 6
+      }
+    end
+    if jdk_root == nil
+      jdk_root = ENV["JAVA_HOME"]
+    end
+    if jdk_root != nil && jdk_root != ""
+      java_executable = File.join(jdk_root, "bin", "java")
+    else
+      java_executable = which("java")
+    end
+    key = [ "ORG_JESSIES_LAUNCHER_JVM_SHARED_LIBRARY", "ORG_JESSIES_LAUNCHER_JVM_LIMIT", "LD_LIBRARY_PATH" ].map() {
+      |name|
+      "#{name}=#{ENV[name]}"
+    }
+    if java_executable != nil && File.exist?(java_executable)
+      real_pathname = Pathname.new(java_executable).realpath().to_s()
+      key << "#{real_pathname}@#{File.mtime(real_pathname).to_i()}"
+    end
+    return key.join(" ")
+  end
+  
+  def get_cached_java_version(java_executable)
+    require "#{@salma_hayek}/bin/find-jdk-root.rb"
+    executable_pathname = java_executable
+    if executable_pathname.include?(File::SEPARATOR) == false
+      executable_pathname = which(java_executable)
+    end
+    cache_pathname = java_version_cache_pathname()
+    if executable_pathname == nil || cache_pathname == nil
+      return get_java_version(java_executable)
+    end
+    begin
+      # Resolve /etc/alternatives-style links so that switching JVM invalidates the entry.
+      real_pathname = Pathname.new(executable_pathname).realpath().to_s()
+      mtime = File.mtime(real_pathname).to_i()
+      cache_key = real_pathname
+      if File.basename(real_pathname) =~ /^java-launcher/
+        cache_key = "#{real_pathname} #{java_launcher_jdk_key()}"
+      end
+    rescue SystemCallError
+      return get_java_version(java_executable)
+    end
+    cache = read_java_version_cache(cache_pathname)
+    entry = cache[cache_key]
+    if entry.kind_of?(Hash) && entry["mtime"] == mtime && entry["version"] != nil
+      return entry["version"]
+    end
+    java_version = get_java_version(java_executable)
+    # Only cache answers that look like version numbers; anything else is an error message the user should see afresh.
+    if java_version.match(/^\d/) != nil
+      cache[cache_key] = { "mtime" => mtime, "version" => java_version }
+      write_java_version_cache(cache_pathname, cache)
+    end
+    return java_version
+  end
+  
   def is_java_new_enough(java_version)
     return (java_version.match(/^1\.[6-9]\.0/) != nil)
   end
 
   def check_java_version()
-    actual_java_version = get_java_version(@launcher)
+    actual_java_version = get_cached_java_version(@launcher)
     if is_java_new_enough(actual_java_version)
       return
     end
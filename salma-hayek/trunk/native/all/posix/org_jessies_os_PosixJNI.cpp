@@ -350,10 +350,17 @@ jobject org_jessies_os_PosixJNI::getpwuid(jint uid) {
     return translatePasswd(m_env, *pwp);
 }
 
+// POSIX.1-2008 calls the nanosecond timestamps st_mtim and st_ctim; Mac OS calls them st_mtimespec and st_ctimespec.
+#if defined(__APPLE__)
+#define STAT_NSEC(sb, prefix) ((sb).prefix##timespec.tv_nsec)
+#else
+#define STAT_NSEC(sb, prefix) ((sb).prefix##tim.tv_nsec)
+#endif
+
 static void translateStat(JNIEnv* env, jobject javaStat, const struct stat& sb) {
     jclass statClass = env->FindClass("org/jessies/os/Stat");
-    jmethodID setter = env->GetMethodID(statClass, "set", "(JJIJIIJJJJJJJ)V");
-    env->CallVoidMethod(javaStat, setter, jlong(sb.st_dev), jlong(sb.st_ino), jint(sb.st_mode), jlong(sb.st_nlink), jint(sb.st_uid), jint(sb.st_gid), jlong(sb.st_rdev), jlong(sb.st_size), jlong(sb.st_atime), jlong(sb.st_mtime), jlong(sb.st_ctime), jlong(sb.st_blksize), jlong(sb.st_blocks));
+    jmethodID setter = env->GetMethodID(statClass, "set", "(JJIJIIJJJJJJJJJ)V");
+    env->CallVoidMethod(javaStat, setter, jlong(sb.st_dev), jlong(sb.st_ino), jint(sb.st_mode), jlong(sb.st_nlink), jint(sb.st_uid), jint(sb.st_gid), jlong(sb.st_rdev), jlong(sb.st_size), jlong(sb.st_atime), jlong(sb.st_mtime), jlong(sb.st_ctime), jlong(sb.st_blksize), jlong(sb.st_blocks), jlong(STAT_NSEC(sb, st_m)), jlong(STAT_NSEC(sb, st_c)));
 }
 
 jint org_jessies_os_PosixJNI::fstat(jint fd, jobject javaStat) {
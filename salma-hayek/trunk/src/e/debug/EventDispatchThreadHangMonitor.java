@@ -40,6 +40,11 @@ public final class EventDispatchThreadHangMonitor extends EventQueue {
     // called on the event dispatch thread, like font loading).
     private static final double UNREASONABLE_DISPATCH_DURATION_S = 1.0;
     
+    // Dispatches that take longer than this aren't hangs, but they're long
+    // enough for the user to notice, so we record a burst of stack samples
+    // to show where the time went.
+    private static final double STALL_SAMPLING_DURATION_S = 0.2;
+    
     // Help distinguish multiple hangs in the log, and match start and end too.
     // Only access this via getNewHangNumber.
     private static int hangCount = 0;
@@ -58,6 +63,9 @@ public final class EventDispatchThreadHangMonitor extends EventQueue {
         // If so; what was the identifying hang number?
         private int hangNumber;
         
+        // Samples of the event dispatch thread, if this dispatch has stalled.
+        private SamplingProfiler.Burst stallSamples;
+        
         // The EDT for this dispatch (for the purpose of getting stack traces).
         // I don't know of any API for getting the event dispatch thread,
         // but we can assume that it's the current thread if we're in the
@@ -74,11 +82,23 @@ public final class EventDispatchThreadHangMonitor extends EventQueue {
         }
         
         public void checkForHang() {
-            if (TimeUtilities.nsToS(timeSoFar()) > UNREASONABLE_DISPATCH_DURATION_S) {
+            double secondsSoFar = TimeUtilities.nsToS(timeSoFar());
+            if (secondsSoFar > STALL_SAMPLING_DURATION_S && stallSamples == null) {
+                startStallSampling();
+            }
+            if (secondsSoFar > UNREASONABLE_DISPATCH_DURATION_S) {
                 examineHang();
             }
         }
         
+        private void startStallSampling() {
+            if (isWaitingForNextEvent(eventDispatchThread.getStackTrace())) {
+                // A modal dialog's event pump isn't a stall.
+                return;
+            }
+            stallSamples = SamplingProfiler.startBurst(eventDispatchThread);
+        }
+        
         // We can't use StackTraceElement.equals because that insists on checking the filename and line number.
         // That would be version-specific.
         private static boolean stackTraceElementIs(StackTraceElement e, String className, String methodName, boolean isNative) {
@@ -135,6 +155,9 @@ public final class EventDispatchThreadHangMonitor extends EventQueue {
         }
         
         public void dispose() {
+            if (stallSamples != null) {
+                Log.warn("event dispatch thread stalled for " + TimeUtilities.nsToString(timeSoFar()) + "; collapsed stack samples follow:\n" + stallSamples.stop());
+            }
             if (lastReportedStack != null) {
                 Log.warn("(hang #" + hangNumber + ") event dispatch thread unstuck after " + TimeUtilities.nsToString(timeSoFar()) + ".");
             }
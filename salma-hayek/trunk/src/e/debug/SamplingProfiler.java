@@ -0,0 +1,319 @@
+package e.debug;
+
+import e.util.*;
+import java.io.*;
+import java.lang.management.*;
+import java.util.*;
+import java.util.Timer;
+import javax.management.*;
+
+/**
+ * A low-overhead in-process sampling profiler.
+ *
+ * While running, we sample the event dispatch thread's stack frequently and every thread's stack less often.
+ * Samples are aggregated in the "collapsed stack" format understood by Brendan Gregg's flamegraph.pl:
+ * one line per distinct stack, frames outermost-first separated by ';', followed by a space and the number of times that stack was seen.
+ *
+ * We also offer a Burst, which samples a single thread until it's stopped; EventDispatchThreadHangMonitor uses one to record what the EDT was doing when it stalled.
+ *
+ * Finally, JDK Flight Recorder recordings can be started and stopped via the DiagnosticCommand MBean, on JVMs that have one.
+ */
+public final class SamplingProfiler {
+    // How often we sample the event dispatch thread.
+    private static final long EDT_SAMPLE_INTERVAL_MS = 10;
+    // We sample all threads once for every this many EDT samples.
+    private static final int ALL_THREADS_SAMPLE_RATIO = 10;
+    // A burst that's gone on this long is no longer telling us anything new.
+    private static final int MAX_BURST_SAMPLE_COUNT = 1000;
+    
+    private static final String FLIGHT_RECORDING_NAME = "org.jessies";
+    
+    private static SamplingProfiler runningProfiler;
+    
+    // The file the flight recording we started will be written to, or null if we're not recording.
+    private static File flightRecordingFile;
+    
+    // Null until we've asked; asking starts the platform MBean server, so we only do it once, and only when someone wants a recording.
+    private static Boolean flightRecorderSupport;
+    
+    // Shared by all bursts; created when the first one starts.
+    private static Timer burstTimer;
+    
+    private final Timer timer = new Timer("SamplingProfiler", true);
+    private final Map<String, Integer> collapsedStacks = new HashMap<String, Integer>();
+    private final long startTimeNs = System.nanoTime();
+    private int tickCount = 0;
+    private Thread eventDispatchThread;
+    
+    private SamplingProfiler() {
+        timer.scheduleAtFixedRate(new TimerTask() {
+            @Override
+            public void run() {
+                takeSample();
+            }
+        }, 0, EDT_SAMPLE_INTERVAL_MS);
+    }
+    
+    public static synchronized boolean isRunning() {
+        return (runningProfiler != null);
+    }
+    
+    /**
+     * Starts profiling, unless we already are.
+     */
+    public static synchronized void start() {
+        if (runningProfiler == null) {
+            runningProfiler = new SamplingProfiler();
+            Log.warn("Sampling profiler started.");
+        }
+    }
+    
+    /**
+     * Stops profiling and writes the collapsed stacks to a file whose name is returned.
+     * Returns null if we weren't profiling.
+     */
+    public static synchronized File stop() {
+        if (runningProfiler == null) {
+            return null;
+        }
+        SamplingProfiler profiler = runningProfiler;
+        runningProfiler = null;
+        profiler.timer.cancel();
+        File file = chooseOutputFile("profile", ".collapsed");
+        String failure = StringUtilities.writeFile(file, profiler.toCollapsedString());
+        if (failure != null) {
+            throw new RuntimeException("Couldn't write profile: " + failure);
+        }
+        Log.warn("Sampling profiler stopped after " + TimeUtilities.nsToString(System.nanoTime() - profiler.startTimeNs) + "; wrote \"" + file + "\".");
+        return file;
+    }
+    
+    private void takeSample() {
+        // The EDT can die and be replaced after an uncaught exception, so we check ours is still alive.
+        if (eventDispatchThread == null || eventDispatchThread.isAlive() == false) {
+            eventDispatchThread = findEventDispatchThread();
+        }
+        boolean sampleAllThreads = (tickCount++ % ALL_THREADS_SAMPLE_RATIO == 0);
+        if (sampleAllThreads) {
+            for (Map.Entry<Thread, StackTraceElement[]> entry : Thread.getAllStackTraces().entrySet()) {
+                Thread thread = entry.getKey();
+                // The EDT is sampled on every tick, below; don't count it twice.
+                if (thread != eventDispatchThread && thread != Thread.currentThread()) {
+                    addSample(collapsedStacks, thread, entry.getValue());
+                }
+            }
+        }
+        if (eventDispatchThread != null) {
+            addSample(collapsedStacks, eventDispatchThread, eventDispatchThread.getStackTrace());
+        }
+    }
+    
+    private String toCollapsedString() {
+        synchronized (collapsedStacks) {
+            return collapsedStacksToString(collapsedStacks);
+        }
+    }
+    
+    /**
+     * Records what a single thread is doing until stopped.
+     */
+    public static class Burst {
+        private final Map<String, Integer> collapsedStacks = new HashMap<String, Integer>();
+        private int sampleCount = 0;
+        private final TimerTask task;
+        
+        private Burst(final Thread thread) {
+            task = new TimerTask() {
+                @Override
+                public void run() {
+                    if (++sampleCount > MAX_BURST_SAMPLE_COUNT) {
+                        cancel();
+                        return;
+                    }
+                    addSample(collapsedStacks, thread, thread.getStackTrace());
+                }
+            };
+            getBurstTimer().scheduleAtFixedRate(task, 0, EDT_SAMPLE_INTERVAL_MS);
+        }
+        
+        /**
+         * Stops sampling and returns the collapsed stacks seen.
+         */
+        public String stop() {
+            task.cancel();
+            synchronized (collapsedStacks) {
+                return collapsedStacksToString(collapsedStacks);
+            }
+        }
+    }
+    
+    // Every stall gets a burst, so they share one thread rather than each starting its own.
+    private static synchronized Timer getBurstTimer() {
+        if (burstTimer == null) {
+            burstTimer = new Timer("SamplingProfiler Burst", true);
+        }
+        return burstTimer;
+    }
+    
+    public static Burst startBurst(Thread thread) {
+        return new Burst(thread);
+    }
+    
+    private static void addSample(Map<String, Integer> collapsedStacks, Thread thread, StackTraceElement[] stack) {
+        if (stack.length == 0) {
+            return;
+        }
+        StringBuilder key = new StringBuilder(thread.getName().replace(';', ':').replace(' ', '_'));
+        // Stack traces are innermost-first, but the collapsed format is outermost-first.
+        for (int i = stack.length - 1; i >= 0; --i) {
+            key.append(';');
+            key.append(stack[i].getClassName());
+            key.append('.');
+            key.append(stack[i].getMethodName());
+        }
+        String stackKey = key.toString();
+        synchronized (collapsedStacks) {
+            Integer count = collapsedStacks.get(stackKey);
+            collapsedStacks.put(stackKey, (count == null) ? 1 : count + 1);
+        }
+    }
+    
+    private static String collapsedStacksToString(Map<String, Integer> collapsedStacks) {
+        StringBuilder result = new StringBuilder();
+        for (String stack : new TreeSet<String>(collapsedStacks.keySet())) {
+            result.append(stack);
+            result.append(' ');
+            result.append(collapsedStacks.get(stack));
+            result.append('\n');
+        }
+        return result.toString();
+    }
+    
+    private static Thread findEventDispatchThread() {
+        // There's no API for finding the EDT from another thread, but its name is reliable in practice.
+        ThreadGroup rootGroup = Thread.currentThread().getThreadGroup();
+        while (rootGroup.getParent() != null) {
+            rootGroup = rootGroup.getParent();
+        }
+        Thread[] threads = new Thread[rootGroup.activeCount() * 2];
+        int threadCount = rootGroup.enumerate(threads, true);
+        for (int i = 0; i < threadCount; ++i) {
+            if (threads[i].getName().startsWith("AWT-EventQueue-")) {
+                return threads[i];
+            }
+        }
+        return null;
+    }
+    
+    /**
+     * Profiles and recordings go next to our log, where users already know to look, or in the temporary directory if we're not logging to a file.
+     */
+    private static File chooseOutputFile(String kind, String extension) {
+        String logFilename = System.getProperty("e.util.Log.filename");
+        String directory = (logFilename != null) ? FileUtilities.fileFromString(logFilename).getParent() : System.getProperty("java.io.tmpdir");
+        String timestamp = new java.text.SimpleDateFormat("yyyyMMdd-HHmmss").format(new Date());
+        return FileUtilities.fileFromParentAndString(directory, Log.getApplicationName().toLowerCase() + "-" + kind + "-" + timestamp + extension);
+    }
+    
+    //
+    // JDK Flight Recorder support.
+    // JFR is controlled through the DiagnosticCommand MBean's jfrStart and jfrStop operations.
+    // Older JVMs don't have the MBean, and some only allow JFR with -XX:+UnlockCommercialFeatures, so we check at run time.
+    //
+    
+    private static ObjectName getDiagnosticCommandName() throws MalformedObjectNameException {
+        return new ObjectName("com.sun.management:type=DiagnosticCommand");
+    }
+    
+    public static synchronized boolean isFlightRecorderSupported() {
+        if (flightRecorderSupport == null) {
+            flightRecorderSupport = Boolean.valueOf(checkForFlightRecorder());
+        }
+        return flightRecorderSupport.booleanValue();
+    }
+    
+    private static boolean checkForFlightRecorder() {
+        try {
+            MBeanServer server = ManagementFactory.getPlatformMBeanServer();
+            ObjectName name = getDiagnosticCommandName();
+            if (server.isRegistered(name) == false) {
+                return false;
+            }
+            for (MBeanOperationInfo operation : server.getMBeanInfo(name).getOperations()) {
+                if (operation.getName().equals("jfrStart")) {
+                    return true;
+                }
+            }
+        } catch (Exception ex) {
+            Log.warn("Problem checking for JDK Flight Recorder support", ex);
+        }
+        return false;
+    }
+    
+    public static synchronized boolean isFlightRecording() {
+        return (flightRecordingFile != null);
+    }
+    
+    /**
+     * Starts a JDK Flight Recorder recording, unless we already are, returning the file it will be written to when stopped.
+     */
+    public static synchronized File startFlightRecording() throws Exception {
+        if (flightRecordingFile == null) {
+            File file = chooseOutputFile("recording", ".jfr");
+            String result = invokeDiagnosticCommand("jfrStart", "name=" + FLIGHT_RECORDING_NAME, "filename=" + file.getAbsolutePath());
+            Log.warn("Started flight recording: " + result);
+            flightRecordingFile = file;
+        }
+        return flightRecordingFile;
+    }
+    
+    /**
+     * Stops the flight recording, returning the file it was written to.
+     * Returns null if we weren't recording.
+     */
+    public static synchronized File stopFlightRecording() throws Exception {
+        if (flightRecordingFile == null) {
+            return null;
+        }
+        File file = flightRecordingFile;
+        // Even if stopping fails, the recording is no use to us any more.
+        flightRecordingFile = null;
+        String result = invokeDiagnosticCommand("jfrStop", "name=" + FLIGHT_RECORDING_NAME);
+        Log.warn("Stopped flight recording: " + result);
+        return file;
+    }
+    
+    private static String invokeDiagnosticCommand(String operation, String... arguments) throws Exception {
+        MBeanServer server = ManagementFactory.getPlatformMBeanServer();
+        Object result = server.invoke(getDiagnosticCommandName(), operation, new Object[] { arguments }, new String[] { String[].class.getName() });
+        return String.valueOf(result).trim();
+    }
+    
+    /**
+     * Exposes the profiler to InAppServer clients, so a user can profile an application that's too busy to use its menus.
+     */
+    public static class Commands {
+        public void startProfiling(PrintWriter out) {
+            start();
+            out.println("Sampling profiler running.");
+        }
+        
+        public void stopProfiling(PrintWriter out) {
+            File file = stop();
+            out.println((file != null) ? ("Wrote \"" + file + "\".") : "Sampling profiler wasn't running.");
+        }
+        
+        public void startFlightRecording(PrintWriter out) throws Exception {
+            if (isFlightRecorderSupported() == false) {
+                out.println("This JVM doesn't support JDK Flight Recorder.");
+                return;
+            }
+            out.println("Recording to \"" + SamplingProfiler.startFlightRecording() + "\" until stopped.");
+        }
+        
+        public void stopFlightRecording(PrintWriter out) throws Exception {
+            File file = SamplingProfiler.stopFlightRecording();
+            out.println((file != null) ? ("Wrote \"" + file + "\".") : "Flight recording wasn't running.");
+        }
+    }
+}
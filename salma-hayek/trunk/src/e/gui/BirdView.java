@@ -215,6 +215,21 @@ public class BirdView extends JComponent {
         maybeRepaint();
     }
     
+    /**
+     * Moves the marks on lines after 'line' down by 'lineCount', or up if 'lineCount' is negative, for when lines are inserted or removed after it.
+     * Marks on removed lines are dropped; the caller is responsible for 'line' itself, which is where any removed lines' text ended up.
+     */
+    public synchronized void shiftMatchingLines(int line, int lineCount) {
+        BitSet shifted = matchingLines.get(0, line + 1);
+        for (int i = matchingLines.nextSetBit(line + 1); i != -1; i = matchingLines.nextSetBit(i + 1)) {
+            if (i + lineCount > line) {
+                shifted.set(i + lineCount);
+            }
+        }
+        matchingLines = shifted;
+        maybeRepaint();
+    }
+    
     public synchronized void clearMatchingLines() {
         matchingLines = new BitSet();
         maybeRepaint();
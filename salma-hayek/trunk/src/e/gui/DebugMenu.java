@@ -1,13 +1,17 @@
 package e.gui;
 
+import e.debug.*;
 import e.ptextarea.*;
 import e.util.*;
 import java.awt.*;
+import java.io.*;
 import java.util.*;
 import java.util.List;
 import java.awt.event.*;
 import javax.swing.*;
 import javax.swing.Timer;
+import javax.swing.event.MenuEvent;
+import javax.swing.event.MenuListener;
 
 /**
  * A "Debug" menu for any Java application.
@@ -31,6 +35,21 @@ public class DebugMenu {
         menu.add(new MouseEventTester());
         menu.addSeparator();
         menu.add(new HeapViewAction());
+        final SamplingProfilerAction samplingProfilerAction = new SamplingProfilerAction();
+        final FlightRecordingAction flightRecordingAction = new FlightRecordingAction();
+        menu.add(samplingProfilerAction);
+        menu.add(flightRecordingAction);
+        // The profiler is shared by every window's menu, and by InAppServer clients, so we check its state whenever the menu's shown.
+        menu.addMenuListener(new MenuListener() {
+            public void menuSelected(MenuEvent e) {
+                samplingProfilerAction.updateName();
+                flightRecordingAction.updateName();
+            }
+            public void menuDeselected(MenuEvent e) {
+            }
+            public void menuCanceled(MenuEvent e) {
+            }
+        });
         // FIXME: an action to turn on debugging of hung AWT exits. All frames or just the parent frame? Just the parent is probably the more obvious (given that new frames could be created afterwards).
         return menu;
     }
@@ -260,6 +279,59 @@ public class DebugMenu {
         }
     }
     
+    private static class SamplingProfilerAction extends AbstractAction {
+        public SamplingProfilerAction() {
+            updateName();
+        }
+        
+        private void updateName() {
+            GuiUtilities.configureAction(this, SamplingProfiler.isRunning() ? "Stop Sampling _Profiler" : "Start Sampling _Profiler", null);
+        }
+        
+        public void actionPerformed(ActionEvent e) {
+            if (SamplingProfiler.isRunning()) {
+                try {
+                    File file = SamplingProfiler.stop();
+                    SimpleDialog.showAlert(null, "Sampling profiler stopped", "The collapsed stacks were written to \"" + file + "\". Use flamegraph.pl to turn them into a flame graph.");
+                } catch (Exception ex) {
+                    SimpleDialog.showDetails(null, "Failed to write profile", ex);
+                }
+            } else {
+                SamplingProfiler.start();
+            }
+            updateName();
+        }
+    }
+    
+    private static class FlightRecordingAction extends AbstractAction {
+        public FlightRecordingAction() {
+            updateName();
+        }
+        
+        private void updateName() {
+            GuiUtilities.configureAction(this, SamplingProfiler.isFlightRecording() ? "Stop Flight _Recording" : "Start Flight _Recording", null);
+        }
+        
+        public void actionPerformed(ActionEvent e) {
+            // We don't ask until we're used, because asking starts the platform MBean server, and every menu bar has one of us.
+            if (SamplingProfiler.isFlightRecorderSupported() == false) {
+                SimpleDialog.showAlert(null, "Flight recording unavailable", "This JVM doesn't support JDK Flight Recorder.");
+                return;
+            }
+            try {
+                if (SamplingProfiler.isFlightRecording()) {
+                    File file = SamplingProfiler.stopFlightRecording();
+                    SimpleDialog.showAlert(null, "Flight recording stopped", "The recording was written to \"" + file + "\".");
+                } else {
+                    SamplingProfiler.startFlightRecording();
+                }
+            } catch (Exception ex) {
+                SimpleDialog.showDetails(null, "Flight recording failed", ex);
+            }
+            updateName();
+        }
+    }
+    
     private static class ShowUiDefaultsAction extends AbstractAction {
         public ShowUiDefaultsAction() {
             GuiUtilities.configureAction(this, "Show _UI Defaults", null);
@@ -53,29 +53,93 @@ public class BugDatabaseHighlighter extends RegularExpressionStyleApplicator {
         }
     }
     
-    private final String urlTemplate;
-    
-    private BugDatabaseHighlighter(PTextArea textArea, String regularExpression, String urlTemplate) {
-        super(textArea, regularExpression, PStyle.HYPERLINK);
-        this.urlTemplate = urlTemplate;
-    }
-    
-    public static void highlightBugs(PTextArea textArea) {
+    // All the patterns that can share a single Pattern, and the group number each one's groups start after.
+    private static final Pattern COMBINED_PATTERN;
+    private static final int[] GROUP_BASES;
+    private static final String[] URL_TEMPLATES;
+    // Patterns that can't share, because they use back references that would be renumbered.
+    private static final ArrayList<String[]> SEPARATE_PATTERNS = new ArrayList<String[]>();
+    static {
         // Group 1 - the text to be underlined.
         // Group 2 - the id, inserted into the template.
-        
+        ArrayList<String[]> patterns = new ArrayList<String[]>();
         // Site-local bug database links.
         for (SiteLocalScriptEntry entry : siteLocalScriptEntries) {
-            highlightBug(textArea, entry.patternToMatch, entry.linkTemplate);
+            patterns.add(new String[] { entry.patternToMatch, entry.linkTemplate });
         }
         // Sun Java bugs.
-        highlightBug(textArea, "\\b(([4-6]\\d{6}))\\b", "http://bugs.sun.com/bugdatabase/view_bug.do?bug_id=%s");
+        patterns.add(new String[] { "\\b(([4-6]\\d{6}))\\b", "http://bugs.sun.com/bugdatabase/view_bug.do?bug_id=%s" });
         // RFCs; not strictly bugs, but often referenced in comments.
-        highlightBug(textArea, "(?i)\\b(rfc\\s*(\\d{3,4}))\\b", "http://tools.ietf.org/html/rfc%s");
+        patterns.add(new String[] { "(?i)\\b(rfc\\s*(\\d{3,4}))\\b", "http://tools.ietf.org/html/rfc%s" });
+        
+        // Matching one alternation is much cheaper than scanning each comment once per pattern.
+        // Each alternative is wrapped in a non-capturing group, which also limits the scope of any embedded flags such as (?i).
+        StringBuilder combined = new StringBuilder();
+        ArrayList<Integer> groupBases = new ArrayList<Integer>();
+        ArrayList<String> urlTemplates = new ArrayList<String>();
+        int groupCount = 0;
+        for (String[] pattern : patterns) {
+            int patternGroupCount;
+            try {
+                patternGroupCount = Pattern.compile(pattern[0]).matcher("").groupCount();
+            } catch (PatternSyntaxException ex) {
+                Log.warn("BugDatabaseHighlighter skipping bad pattern \"" + pattern[0] + "\".", ex);
+                continue;
+            }
+            if (Pattern.compile("\\\\[1-9]").matcher(pattern[0]).find()) {
+                SEPARATE_PATTERNS.add(pattern);
+                continue;
+            }
+            if (combined.length() > 0) {
+                combined.append('|');
+            }
+            combined.append("(?:").append(pattern[0]).append(')');
+            groupBases.add(groupCount);
+            urlTemplates.add(pattern[1]);
+            groupCount += patternGroupCount;
+        }
+        COMBINED_PATTERN = Pattern.compile(combined.toString());
+        GROUP_BASES = new int[groupBases.size()];
+        for (int i = 0; i < GROUP_BASES.length; ++i) {
+            GROUP_BASES[i] = groupBases.get(i);
+        }
+        URL_TEMPLATES = urlTemplates.toArray(new String[urlTemplates.size()]);
+    }
+    
+    // Null for the combined pattern, whose template depends on which alternative matched.
+    private final String urlTemplate;
+    
+    private BugDatabaseHighlighter(PTextArea textArea, Pattern pattern, String urlTemplate) {
+        super(textArea, pattern, PStyle.HYPERLINK);
+        this.urlTemplate = urlTemplate;
     }
     
-    private static void highlightBug(PTextArea textArea, String regularExpression, String urlTemplate) {
-        textArea.addStyleApplicator(new BugDatabaseHighlighter(textArea, regularExpression, urlTemplate));
+    public static void highlightBugs(PTextArea textArea) {
+        textArea.addStyleApplicator(new BugDatabaseHighlighter(textArea, COMBINED_PATTERN, null));
+        for (String[] pattern : SEPARATE_PATTERNS) {
+            textArea.addStyleApplicator(new BugDatabaseHighlighter(textArea, Pattern.compile(pattern[0]), pattern[1]));
+        }
+    }
+    
+    // Returns the index of the combined pattern's alternative that matched.
+    private static int matchedAlternative(Matcher matcher) {
+        for (int i = 0; i < GROUP_BASES.length; ++i) {
+            if (matcher.start(GROUP_BASES[i] + 1) != -1) {
+                return i;
+            }
+        }
+        throw new IllegalStateException("no alternative matched " + matcher);
+    }
+    
+    @Override
+    protected String getRequiredCharacters() {
+        // The built-in patterns all need a digit, but we can't say anything about site-local ones.
+        return siteLocalScriptEntries.isEmpty() ? "0123456789" : null;
+    }
+    
+    @Override
+    protected int getStyledGroup(Matcher matcher) {
+        return (urlTemplate != null) ? 1 : GROUP_BASES[matchedAlternative(matcher)] + 1;
     }
     
     @Override
@@ -92,7 +156,11 @@ public class BugDatabaseHighlighter extends RegularExpressionStyleApplicator {
     }
     
     private String urlForMatcher(Matcher matcher) {
-        return new Formatter().format(urlTemplate, matcher.group(2)).toString();
+        if (urlTemplate != null) {
+            return new Formatter().format(urlTemplate, matcher.group(2)).toString();
+        }
+        int alternative = matchedAlternative(matcher);
+        return new Formatter().format(URL_TEMPLATES[alternative], matcher.group(GROUP_BASES[alternative] + 2)).toString();
     }
     
     @Override
@@ -15,6 +15,12 @@ class HyperlinkStyleApplicator extends RegularExpressionStyleApplicator {
         super(textArea, PatternUtilities.HYPERLINK_PATTERN, PStyle.HYPERLINK);
     }
     
+    @Override
+    protected String getRequiredCharacters() {
+        // Every URL we recognize contains "://".
+        return ":";
+    }
+    
     @Override
     public boolean canApplyStylingTo(PStyle style) {
         return (style == PStyle.NORMAL || style == PStyle.COMMENT);
@@ -2,20 +2,104 @@ package e.ptextarea;
 
 import java.util.*;
 import java.util.regex.*;
+import org.jessies.test.*;
 
 /**
  * Recognizes keywords within NORMAL text segments and styles them KEYWORD.
  */
 public class KeywordStyleApplicator extends RegularExpressionStyleApplicator {
-    private Set<String> keywords;
+    private final KeywordTable keywords;
     
     public KeywordStyleApplicator(PTextArea textArea, Set<String> keywords, String keywordRegularExpression) {
         super(textArea, keywordRegularExpression, PStyle.KEYWORD);
-        this.keywords = keywords;
+        this.keywords = new KeywordTable(keywords);
     }
     
     @Override
     public boolean isAcceptableMatch(CharSequence line, Matcher matcher) {
-        return keywords.contains(matcher.group(1));
+        String word = matcher.group(1);
+        return keywords.contains(word, 0, word.length());
+    }
+    
+    @Override
+    protected boolean isAcceptableMatch(CharSequence line, CharSequence text, Matcher matcher) {
+        // Most words aren't keywords, so avoid creating a String for each one just to look it up.
+        return keywords.contains(text, matcher.start(1), matcher.end(1));
+    }
+    
+    /**
+     * An open-addressed hash set of keywords that can be queried with a range of a CharSequence.
+     * If the set we're given is ordered by String.CASE_INSENSITIVE_ORDER, lookups are case-insensitive in the same way.
+     */
+    private static class KeywordTable {
+        private final String[] table;
+        private final boolean ignoreCase;
+        
+        KeywordTable(Set<String> keywords) {
+            this.ignoreCase = (keywords instanceof SortedSet && ((SortedSet<?>) keywords).comparator() == String.CASE_INSENSITIVE_ORDER);
+            int capacity = 16;
+            while (capacity < keywords.size() * 2) {
+                capacity *= 2;
+            }
+            this.table = new String[capacity];
+            for (String keyword : keywords) {
+                int index = hash(keyword, 0, keyword.length()) & (capacity - 1);
+                while (table[index] != null) {
+                    index = (index + 1) & (capacity - 1);
+                }
+                table[index] = keyword;
+            }
+        }
+        
+        boolean contains(CharSequence text, int start, int end) {
+            int index = hash(text, start, end) & (table.length - 1);
+            for (String keyword; (keyword = table[index]) != null; index = (index + 1) & (table.length - 1)) {
+                if (regionMatches(keyword, text, start, end)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        private int hash(CharSequence text, int start, int end) {
+            int result = 0;
+            for (int i = start; i < end; ++i) {
+                result = 31 * result + fold(text.charAt(i));
+            }
+            return result ^ (result >>> 16);
+        }
+        
+        private boolean regionMatches(String keyword, CharSequence text, int start, int end) {
+            if (keyword.length() != end - start) {
+                return false;
+            }
+            for (int i = 0; i < keyword.length(); ++i) {
+                if (fold(keyword.charAt(i)) != fold(text.charAt(start + i))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        
+        // This is the comparison String.CASE_INSENSITIVE_ORDER makes.
+        private char fold(char ch) {
+            return ignoreCase ? Character.toLowerCase(Character.toUpperCase(ch)) : ch;
+        }
+    }
+    
+    @Test private static void testKeywordTable() {
+        KeywordTable caseSensitive = new KeywordTable(new HashSet<String>(Arrays.asList("if", "else", "while")));
+        Assert.equals(caseSensitive.contains("} else {", 2, 6), true);
+        Assert.equals(caseSensitive.contains("} Else {", 2, 6), false);
+        Assert.equals(caseSensitive.contains("elsewhere", 0, 4), true);
+        Assert.equals(caseSensitive.contains("elsewhere", 0, 9), false);
+        Assert.equals(caseSensitive.contains("", 0, 0), false);
+        
+        TreeSet<String> keywords = new TreeSet<String>(String.CASE_INSENSITIVE_ORDER);
+        keywords.addAll(Arrays.asList("BEGIN", "end"));
+        KeywordTable caseInsensitive = new KeywordTable(keywords);
+        Assert.equals(caseInsensitive.contains("begin", 0, 5), true);
+        Assert.equals(caseInsensitive.contains("End", 0, 3), true);
+        Assert.equals(caseInsensitive.contains("ending", 0, 6), false);
     }
 }
@@ -13,7 +13,9 @@ package e.ptextarea;
  */
 
 public abstract class PAnchor implements Comparable<PAnchor> {
+    // While we're in a PAnchorSet, this is relative to our chunk's offset, so the set can move a whole chunk of anchors at once.
     private int index;
+    private PAnchorSet.Chunk chunk;
     
     public PAnchor(int index) {
         this.index = index;
@@ -21,12 +23,25 @@ public abstract class PAnchor implements Comparable<PAnchor> {
     
     /** Returns the current index at which this anchor is anchored. */
     public int getIndex() {
-        return index;
+        return (chunk != null) ? chunk.offset + index : index;
     }
     
     /** Changes the index at which this anchor is anchored. */
     public void setIndex(int index) {
-        this.index = index;
+        this.index = (chunk != null) ? index - chunk.offset : index;
+    }
+    
+    PAnchorSet.Chunk getChunk() {
+        return chunk;
+    }
+    
+    /**
+     * Moves this anchor to 'newChunk' (or out of its PAnchorSet, if null) without changing its index.
+     */
+    void setChunk(PAnchorSet.Chunk newChunk) {
+        int absoluteIndex = getIndex();
+        this.chunk = newChunk;
+        setIndex(absoluteIndex);
     }
     
     /**
@@ -40,24 +55,24 @@ public abstract class PAnchor implements Comparable<PAnchor> {
     public int hashCode() {
         // FIXME: because this class is mutable, instances MUST NOT be stored long-term in hashes.
         // FIXME: instances are hashed, so we (a) don't want to return a constant here because we want O(1) lookup, and (b) should investigate the performance of this implementation.
-        return index;
+        return getIndex();
     }
     
     @Override
     public final boolean equals(Object obj) {
         if (obj instanceof PAnchor) {
-            return (index == ((PAnchor) obj).index);
+            return (getIndex() == ((PAnchor) obj).getIndex());
         }
         return false;
     }
     
     @Override
     public final int compareTo(PAnchor other) {
-        return (index - other.index);
+        return (getIndex() - other.getIndex());
     }
     
     @Override
     public String toString() {
-        return "PAnchor[index=" + index + "]";
+        return "PAnchor[index=" + getIndex() + "]";
     }
 }
@@ -2,124 +2,272 @@ package e.ptextarea;
 
 import e.util.*;
 import java.util.*;
+import org.jessies.test.*;
 
 /**
  * Contains all the PAnchor instances related to a given text buffer.
  * Responsible for ensuring that their offsets are updated when the text changes.
+ *
+ * The anchors are kept in order in a list of chunks of at most MAX_CHUNK_SIZE anchors.
+ * Each anchor's index is stored relative to its chunk's offset, so an edit only touches the anchors of one chunk individually, and moves all the chunks after it by adjusting their offsets.
+ * After a "find all" with tens of thousands of matches, that's the difference between updating every anchor on every keystroke and updating a few hundred.
  */
 class PAnchorSet implements PTextListener {
-    // This list is sorted so we can binarySearch it.
-    private ArrayList<PAnchor> anchors = new ArrayList<PAnchor>();
+    private static final int MAX_CHUNK_SIZE = 512;
+    // Chunks smaller than this are merged with a neighbor when anchors are removed, so we don't end up with lots of tiny chunks.
+    private static final int MIN_CHUNK_SIZE = MAX_CHUNK_SIZE / 4;
+    
+    static final class Chunk {
+        // Added to the stored index of each of this chunk's anchors to get its actual index.
+        int offset;
+        // This list is sorted so we can binary search it.
+        final ArrayList<PAnchor> anchors = new ArrayList<PAnchor>();
+        
+        private Chunk(int offset) {
+            this.offset = offset;
+        }
+        
+        private int lastIndex() {
+            return anchors.get(anchors.size() - 1).getIndex();
+        }
+        
+        // Returns the position of the first anchor at or after textIndex.
+        private int lowerBound(int textIndex) {
+            int low = 0;
+            int high = anchors.size();
+            while (low < high) {
+                int mid = (low + high) >>> 1;
+                if (anchors.get(mid).getIndex() < textIndex) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            return low;
+        }
+    }
+    
+    private ArrayList<Chunk> chunks = new ArrayList<Chunk>();
     
     synchronized void add(PAnchor anchor) {
-        int index = getFirstAnchorIndex(anchor.getIndex());
-        anchors.add(index, anchor);
+        int textIndex = anchor.getIndex();
+        int chunkIndex = findChunk(textIndex);
+        if (chunkIndex == chunks.size()) {
+            if (chunks.isEmpty()) {
+                chunks.add(new Chunk(0));
+            } else {
+                // The new anchor goes at the end of the last chunk.
+                --chunkIndex;
+            }
+        }
+        Chunk chunk = chunks.get(chunkIndex);
+        chunk.anchors.add(chunk.lowerBound(textIndex), anchor);
+        anchor.setChunk(chunk);
+        if (chunk.anchors.size() > MAX_CHUNK_SIZE) {
+            split(chunkIndex);
+        }
     }
     
     /**
      * Bulk remove.
-     * Assumes you're trying to remove "most" of the anchors, perhaps when canceling a find.
+     * Only the chunks containing the dead anchors are touched, so canceling a find costs time proportional to the number of matches, not the number of anchors.
      */
     synchronized void removeAll(IdentityHashMap<PAnchor, Object> deadAnchors) {
-        // Sun 6529800: as of Java 7, this is significantly quicker than ArrayList.removeAll.
-        // Sun's fix for that bug could perform even better than simple work-around, so if you're reading this in 2009 or later, think about removing this code.
         // Note that *identity* is important here.
-        // PAnchor.equals only checks the offset, but we could have multiple PAnchor instances in anchors with the same offset.
-        for (int i = anchors.size() - 1; i >= 0; --i) {
-            if (deadAnchors.containsKey(anchors.get(i))) {
-                anchors.remove(i);
+        // PAnchor.equals only checks the offset, but we could have multiple PAnchor instances with the same offset.
+        IdentityHashMap<Chunk, Object> affectedChunks = new IdentityHashMap<Chunk, Object>();
+        for (PAnchor anchor : deadAnchors.keySet()) {
+            Chunk chunk = anchor.getChunk();
+            if (chunk != null) {
+                affectedChunks.put(chunk, null);
             }
         }
+        for (Chunk chunk : affectedChunks.keySet()) {
+            ArrayList<PAnchor> anchors = chunk.anchors;
+            int survivorCount = 0;
+            for (int i = 0; i < anchors.size(); ++i) {
+                PAnchor anchor = anchors.get(i);
+                if (deadAnchors.containsKey(anchor)) {
+                    anchor.setChunk(null);
+                } else {
+                    anchors.set(survivorCount++, anchor);
+                }
+            }
+            anchors.subList(survivorCount, anchors.size()).clear();
+        }
+        if (affectedChunks.isEmpty() == false) {
+            coalesceAll();
+        }
     }
     
     synchronized void remove(PAnchor anchor) {
-        int start = getFirstAnchorIndex(anchor.getIndex());
-        for (int i = start; i < anchors.size(); i++) {
+        Chunk chunk = anchor.getChunk();
+        if (chunk == null) {
+            return;
+        }
+        int textIndex = anchor.getIndex();
+        ArrayList<PAnchor> anchors = chunk.anchors;
+        for (int i = chunk.lowerBound(textIndex); i < anchors.size(); i++) {
             if (anchor == anchors.get(i)) {
                 anchors.remove(i);
-                return;
+                anchor.setChunk(null);
+                break;
             }
-            if (get(i).getIndex() > anchor.getIndex()) {
+            if (anchors.get(i).getIndex() > textIndex) {
                 break;
             }
         }
+        if (anchors.size() < MIN_CHUNK_SIZE) {
+            coalesce(chunks.indexOf(chunk));
+        }
     }
     
     /**
-     * Used as an argument to binarySearch.
+     * Returns the position in 'chunks' of the first chunk with an anchor at or after textIndex, or chunks.size() if there's no such chunk.
      */
-    private static class UnownedAnchor extends PAnchor {
-        public UnownedAnchor(int index) {
-            super(index);
+    private int findChunk(int textIndex) {
+        // checkLinearity();    // Comment this out to improve speed, but remove warnings when our state goes wrong.
+        int low = 0;
+        int high = chunks.size();
+        while (low < high) {
+            int mid = (low + high) >>> 1;
+            if (chunks.get(mid).lastIndex() < textIndex) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
         }
-        
-        // We don't add this to the anchor set, so it's never removed, so no-one needs to be notified of anything.
-        @Override
-        public void anchorDestroyed() {
+        return low;
+    }
+    
+    private void split(int chunkIndex) {
+        Chunk chunk = chunks.get(chunkIndex);
+        Chunk newChunk = new Chunk(chunk.offset);
+        List<PAnchor> secondHalf = chunk.anchors.subList(chunk.anchors.size() / 2, chunk.anchors.size());
+        moveAnchors(secondHalf, newChunk);
+        chunks.add(chunkIndex + 1, newChunk);
+    }
+    
+    // Appends 'anchors' to 'chunk', and removes them from the list they were in.
+    private static void moveAnchors(List<PAnchor> anchors, Chunk chunk) {
+        for (PAnchor anchor : anchors) {
+            anchor.setChunk(chunk);
+            chunk.anchors.add(anchor);
         }
+        anchors.clear();
     }
     
-    // Returns the first position where an anchor for the textIndex could be inserted
-    // without violating the ordering.
-    private int getFirstAnchorIndex(int textIndex) {
-        // checkLinearity();    // Comment this out to improve speed, but remove warnings when our state goes wrong.
-        return CollectionUtilities.lowerBound(anchors, new UnownedAnchor(textIndex), CollectionUtilities.naturalOrder());
+    // Removes the given chunk if it's empty, or merges it with a neighbor if it's small.
+    private void coalesce(int chunkIndex) {
+        if (chunkIndex == -1) {
+            return;
+        }
+        Chunk chunk = chunks.get(chunkIndex);
+        int size = chunk.anchors.size();
+        if (size == 0) {
+            chunks.remove(chunkIndex);
+        } else if (chunkIndex + 1 < chunks.size() && size + chunks.get(chunkIndex + 1).anchors.size() <= MAX_CHUNK_SIZE) {
+            moveAnchors(chunks.get(chunkIndex + 1).anchors, chunk);
+            chunks.remove(chunkIndex + 1);
+        } else if (chunkIndex > 0 && chunks.get(chunkIndex - 1).anchors.size() + size <= MAX_CHUNK_SIZE) {
+            moveAnchors(chunk.anchors, chunks.get(chunkIndex - 1));
+            chunks.remove(chunkIndex);
+        }
+    }
+    
+    // Removes all empty chunks, and merges small ones with their neighbors, in a single pass.
+    private void coalesceAll() {
+        ArrayList<Chunk> newChunks = new ArrayList<Chunk>(chunks.size());
+        for (Chunk chunk : chunks) {
+            int size = chunk.anchors.size();
+            if (size == 0) {
+                continue;
+            }
+            Chunk previous = newChunks.isEmpty() ? null : newChunks.get(newChunks.size() - 1);
+            if (previous != null && (size < MIN_CHUNK_SIZE || previous.anchors.size() < MIN_CHUNK_SIZE) && previous.anchors.size() + size <= MAX_CHUNK_SIZE) {
+                moveAnchors(chunk.anchors, previous);
+            } else {
+                newChunks.add(chunk);
+            }
+        }
+        chunks = newChunks;
     }
     
     private void checkLinearity() {
         int lastIndex = -1;
-        for (int i = 0; i < anchors.size(); i++) {
-            PAnchor anchor = get(i);
-            if (anchor.getIndex() < lastIndex) {
+        for (int i = 0; i < chunks.size(); i++) {
+            Chunk chunk = chunks.get(i);
+            if (chunk.anchors.isEmpty()) {
                 dumpAnchorIndices();
-                throw new IllegalStateException("Linearity out of order at index " + i);
+                throw new IllegalStateException("Empty chunk at index " + i);
+            }
+            for (PAnchor anchor : chunk.anchors) {
+                if (anchor.getChunk() != chunk) {
+                    dumpAnchorIndices();
+                    throw new IllegalStateException("Anchor " + anchor + " in the wrong chunk at index " + i);
+                }
+                if (anchor.getIndex() < lastIndex) {
+                    dumpAnchorIndices();
+                    throw new IllegalStateException("Linearity out of order in chunk " + i);
+                }
+                lastIndex = anchor.getIndex();
             }
-            lastIndex = anchor.getIndex();
         }
     }
     
-    private PAnchor get(int index) {
-        return anchors.get(index);
-    }
-    
     public synchronized void textInserted(PTextEvent event) {
-        int start = getFirstAnchorIndex(event.getOffset());
+        int offset = event.getOffset();
         int insertionLength = event.getLength();
-        for (int i = start; i < anchors.size(); i++) {
-            PAnchor anchor = get(i);
+        int chunkIndex = findChunk(offset);
+        if (chunkIndex == chunks.size()) {
+            return;
+        }
+        // Only the first chunk can contain anchors before the insertion point.
+        Chunk chunk = chunks.get(chunkIndex);
+        for (int i = chunk.lowerBound(offset); i < chunk.anchors.size(); i++) {
+            PAnchor anchor = chunk.anchors.get(i);
             anchor.setIndex(anchor.getIndex() + insertionLength);
         }
+        for (int i = chunkIndex + 1; i < chunks.size(); i++) {
+            chunks.get(i).offset += insertionLength;
+        }
     }
     
     private synchronized void dumpAnchorIndices() {
         Log.warn("Dumping anchor indices:");
-        for (int i = 0; i < anchors.size(); i++) {
-            PAnchor anchor = get(i);
-            Log.warn("  Anchor " + i + ": " + anchor);
-        }
-    }
-    
-    private int countAnchorsInRegion(int firstAnchorIndex, int offset, int length) {
-        int result = 0;
-        int endOffset = offset + length;
-        for (int i = firstAnchorIndex; i < anchors.size(); i++) {
-            if (get(i).getIndex() < endOffset) {
-                result++;
-            } else {
-                break;
+        int i = 0;
+        for (Chunk chunk : chunks) {
+            Log.warn(" Chunk with offset " + chunk.offset + ":");
+            for (PAnchor anchor : chunk.anchors) {
+                Log.warn("  Anchor " + i + ": " + anchor);
+                ++i;
             }
         }
-        return result;
     }
     
     public synchronized void textRemoved(PTextEvent event) {
+        int offset = event.getOffset();
         int deletionLength = event.getLength();
-        int firstAnchorIndex = getFirstAnchorIndex(event.getOffset());
-        int removeCount = countAnchorsInRegion(firstAnchorIndex, event.getOffset(), deletionLength);
-        // Copy the to-be-removed PAnchor instances to safety, then remove them from "anchors".
-        List<PAnchor> unsafeAnchorsToRemove = anchors.subList(firstAnchorIndex, firstAnchorIndex + removeCount);
-        List<PAnchor> anchorsToRemove = new ArrayList<PAnchor>(unsafeAnchorsToRemove);
-        unsafeAnchorsToRemove.clear();
+        int endOffset = offset + deletionLength;
+        // Take the PAnchor instances in the deleted region out of the set before telling any of them.
+        ArrayList<PAnchor> anchorsToRemove = new ArrayList<PAnchor>();
+        for (int chunkIndex = findChunk(offset); chunkIndex < chunks.size(); chunkIndex++) {
+            Chunk chunk = chunks.get(chunkIndex);
+            int first = chunk.lowerBound(offset);
+            List<PAnchor> deadAnchors = chunk.anchors.subList(first, chunk.lowerBound(endOffset));
+            for (PAnchor anchor : deadAnchors) {
+                anchor.setChunk(null);
+                anchorsToRemove.add(anchor);
+            }
+            deadAnchors.clear();
+            if (first < chunk.anchors.size()) {
+                // This chunk has anchors after the deleted region, so no later chunk has any in it.
+                break;
+            }
+        }
+        if (anchorsToRemove.isEmpty() == false) {
+            coalesceAll();
+        }
         // Note that the sub-class of PAnchor in PHighlight relies upon this delete
         // call in order to properly destroy itself when one of its extremes is
         // removed.  If you delete this code, some highlights (notably 'find'
@@ -129,20 +277,148 @@ class PAnchorSet implements PTextListener {
         for (PAnchor anchor : anchorsToRemove) {
             anchor.anchorDestroyed();
         }
-        // We must recalculate the first anchor index, because the one we calculated
-        // before could be wrong if an anchor's deletion caused the deletion of another.
-        int start = getFirstAnchorIndex(event.getOffset());
-        for (int i = start; i < anchors.size(); i++) {
-            PAnchor anchor = get(i);
+        // We must find the first affected chunk again, because an anchor's
+        // deletion can cause the deletion of another, and so change the chunks.
+        int chunkIndex = findChunk(offset);
+        if (chunkIndex == chunks.size()) {
+            return;
+        }
+        Chunk chunk = chunks.get(chunkIndex);
+        for (int i = chunk.lowerBound(offset); i < chunk.anchors.size(); i++) {
+            PAnchor anchor = chunk.anchors.get(i);
             anchor.setIndex(anchor.getIndex() - deletionLength);
         }
+        for (int i = chunkIndex + 1; i < chunks.size(); i++) {
+            chunks.get(i).offset -= deletionLength;
+        }
     }
     
     public synchronized void textCompletelyReplaced(PTextEvent event) {
-        ArrayList<PAnchor> oldAnchors = anchors;
-        anchors = new ArrayList<PAnchor>();
+        ArrayList<PAnchor> oldAnchors = new ArrayList<PAnchor>();
+        for (Chunk chunk : chunks) {
+            for (PAnchor anchor : chunk.anchors) {
+                anchor.setChunk(null);
+                oldAnchors.add(anchor);
+            }
+        }
+        chunks = new ArrayList<Chunk>();
         for (PAnchor anchor : oldAnchors) {
             anchor.anchorDestroyed();
         }
     }
+    
+    private static class TestAnchor extends PAnchor {
+        private boolean destroyed = false;
+        
+        private TestAnchor(int index) {
+            super(index);
+        }
+        
+        @Override
+        public void anchorDestroyed() {
+            destroyed = true;
+        }
+    }
+    
+    private static PTextEvent makeTestEvent(int eventType, int offset, int length) {
+        return new PTextEvent(null, eventType, offset, StringUtilities.nCopies(length, "x"));
+    }
+    
+    @Test private static void testEdits() {
+        // Enough anchors for several chunks, two at each even index.
+        PAnchorSet set = new PAnchorSet();
+        ArrayList<TestAnchor> anchors = new ArrayList<TestAnchor>();
+        for (int i = 0; i < 4 * MAX_CHUNK_SIZE; ++i) {
+            TestAnchor anchor = new TestAnchor(2 * (i / 2));
+            anchors.add(anchor);
+            set.add(anchor);
+        }
+        Assert.gt(set.chunks.size(), 1);
+        set.checkLinearity();
+        
+        set.textInserted(makeTestEvent(PTextEvent.INSERT, 1001, 5));
+        Assert.equals(anchors.get(1000).getIndex(), 1000);
+        Assert.equals(anchors.get(1002).getIndex(), 1007);
+        Assert.equals(anchors.get(anchors.size() - 1).getIndex(), anchors.size() - 2 + 5);
+        set.checkLinearity();
+        
+        // Removing [1000, 1009) destroys the anchors at 1000 and those moved to 1007.
+        set.textRemoved(makeTestEvent(PTextEvent.REMOVE, 1000, 9));
+        Assert.equals(anchors.get(999).destroyed, false);
+        Assert.equals(anchors.get(1000).destroyed, true);
+        Assert.equals(anchors.get(1003).destroyed, true);
+        Assert.equals(anchors.get(1004).destroyed, false);
+        Assert.equals(anchors.get(1004).getIndex(), 1000);
+        Assert.equals(anchors.get(anchors.size() - 1).getIndex(), anchors.size() - 2 - 4);
+        set.checkLinearity();
+        
+        // Bulk remove every other anchor.
+        IdentityHashMap<PAnchor, Object> deadAnchors = new IdentityHashMap<PAnchor, Object>();
+        for (int i = 0; i < anchors.size(); i += 2) {
+            deadAnchors.put(anchors.get(i), null);
+        }
+        set.removeAll(deadAnchors);
+        set.checkLinearity();
+        Assert.equals(anchors.get(1).getChunk() != null, true);
+        Assert.equals(anchors.get(2).getChunk() == null, true);
+        Assert.equals(anchors.get(2).getIndex(), 2);
+        
+        set.textCompletelyReplaced(makeTestEvent(PTextEvent.COMPLETE_REPLACEMENT, 0, 0));
+        Assert.equals(set.chunks.size(), 0);
+        Assert.equals(anchors.get(1).destroyed, true);
+    }
+    
+    @Test private static void testRemove() {
+        PAnchorSet set = new PAnchorSet();
+        ArrayList<TestAnchor> anchors = new ArrayList<TestAnchor>();
+        for (int i = 0; i < 3 * MAX_CHUNK_SIZE; ++i) {
+            TestAnchor anchor = new TestAnchor(7);
+            anchors.add(anchor);
+            set.add(anchor);
+        }
+        for (TestAnchor anchor : anchors) {
+            set.remove(anchor);
+            Assert.equals(anchor.getChunk() == null, true);
+            Assert.equals(anchor.getIndex(), 7);
+        }
+        Assert.equals(set.chunks.size(), 0);
+    }
+    
+    /**
+     * Times typing near the start of a document with a large number of live anchors.
+     */
+    public static void main(String[] arguments) {
+        final int anchorCount = 100000;
+        final int keystrokeCount = 100000;
+        PAnchorSet set = new PAnchorSet();
+        IdentityHashMap<PAnchor, Object> allAnchors = new IdentityHashMap<PAnchor, Object>();
+        for (int i = 0; i < anchorCount; ++i) {
+            PAnchor anchor = new TestAnchor(100 + 10 * i);
+            allAnchors.put(anchor, null);
+            set.add(anchor);
+        }
+        
+        Stopwatch typingStopwatch = Stopwatch.get("PAnchorSet typing with " + anchorCount + " anchors");
+        PTextEvent keystroke = makeTestEvent(PTextEvent.INSERT, 50, 1);
+        PTextEvent backspace = makeTestEvent(PTextEvent.REMOVE, 50, 1);
+        for (int i = 0; i < keystrokeCount; ++i) {
+            Stopwatch.Timer timer = typingStopwatch.start();
+            try {
+                set.textInserted(keystroke);
+                set.textRemoved(backspace);
+            } finally {
+                timer.stop();
+            }
+        }
+        System.err.println(typingStopwatch);
+        
+        Stopwatch removeAllStopwatch = Stopwatch.get("PAnchorSet.removeAll of " + anchorCount + " anchors");
+        Stopwatch.Timer timer = removeAllStopwatch.start();
+        try {
+            set.removeAll(allAnchors);
+        } finally {
+            timer.stop();
+        }
+        System.err.println(removeAllStopwatch);
+    }
 }
@@ -15,10 +15,22 @@ public abstract class PCFamilyIndenter extends PSimpleIndenter {
     private static final String SWITCH_LABEL_OUTDENT = "switchLabelOutdent";
     private static final String ACCESS_SPECIFIER_OUTDENT = "accessSpecifierOutdent";
 
+    // While we're fixing a range of lines, the buffer doesn't change, so there's no need to restyle a line every time we scan back over it.
+    private HashMap<Integer, String> effectivePartCache;
+
     public PCFamilyIndenter(PTextArea textArea) {
         super(textArea);
     }
 
+    @Override protected void fixIndentationOnLines(int startLine, int finishLine) {
+        effectivePartCache = new HashMap<Integer, String>();
+        try {
+            super.fixIndentationOnLines(startLine, finishLine);
+        } finally {
+            effectivePartCache = null;
+        }
+    }
+
     @Override
     public ArrayList<Preference> getPreferences() {
         ArrayList<Preference> result = super.getPreferences();
@@ -80,6 +92,17 @@ public abstract class PCFamilyIndenter extends PSimpleIndenter {
      * will be returned as an empty string.
      */
     private String extractEffectivePartOfLine(int lineIndex) {
+        String result = (effectivePartCache != null) ? effectivePartCache.get(lineIndex) : null;
+        if (result == null) {
+            result = extractEffectivePartOfBufferLine(lineIndex);
+            if (effectivePartCache != null) {
+                effectivePartCache.put(lineIndex, result);
+            }
+        }
+        return withReplacementIndentation(lineIndex, result);
+    }
+
+    private String extractEffectivePartOfBufferLine(int lineIndex) {
         List<PLineSegment> segments = textArea.getLineSegments(lineIndex);
         StringBuilder result = new StringBuilder(256);  // Initialize with some sensible capacity.
         for (PLineSegment segment: segments) {
@@ -427,7 +450,7 @@ public abstract class PCFamilyIndenter extends PSimpleIndenter {
             if (lineIndex == 0) {
                 return "";
             }
-            String previousLine = textArea.getLineText(lineIndex - 1);
+            String previousLine = getLineText(lineIndex - 1);
             int previousOperatorOutIndex = previousLine.indexOf("<<");
             if (previousOperatorOutIndex != -1) {
                 return StringUtilities.nCopies(previousOperatorOutIndex, ' ');
@@ -74,7 +74,7 @@ public class PFind {
                 }
                 
                 public void clearFindResults() {
-                    textArea.removeHighlights(PFind.MatchHighlight.HIGHLIGHTER_NAME);
+                    textArea.findAllMatches(null, null);
                 }
             };
             findDialog.showFindDialog(textArea, findField);
@@ -0,0 +1,454 @@
+package e.ptextarea;
+
+import e.gui.*;
+import e.util.*;
+import java.awt.*;
+import java.util.*;
+import java.util.List;
+import java.util.regex.*;
+
+/**
+ * Maintains the "find all" match highlights for a PTextArea.
+ *
+ * Matching runs on a WorkScheduler thread against a snapshot of just the text being searched, so the event dispatch thread neither waits for a regular expression to traverse the whole document nor holds the write lock while one does.
+ * A new find starts at the top of the visible region and wraps around, so the matches the user can see come first, and results are applied in batches as they're found.
+ *
+ * An edit makes any search in progress stale, so it's abandoned, and the edited region (together with whatever the abandoned search hadn't yet covered) is remembered as damaged.
+ * Updating then re-matches only from the start of the first damaged line, carrying on past the damage until it finds a match we already had, or for a few lines of context if it doesn't: from there on, the old matches are still right.
+ * A match that spans more lines than that can be missed if an edit touches a line after the one it starts on; the next full find puts that right.
+ * The BirdView is kept up to date line by line: edits move its marks along with the lines, and each batch recomputes the marks for the lines it covered.
+ *
+ * All our state is guarded by the text buffer's write lock, which we already hold when we're told about edits.
+ */
+final class PFindAll implements PTextListener {
+    // How many matches a background search collects before handing them to the event dispatch thread.
+    private static final int BATCH_SIZE = 1000;
+    // How many lines past the damage we re-match when there's no old match to tell us we're back in step.
+    private static final int CONTEXT_LINES = 2;
+    
+    private final PTextArea textArea;
+    
+    // The pattern whose matches we're maintaining, or null if there's no active find.
+    private Pattern pattern;
+    private BirdView birdView;
+    private Runnable matchesChangedListener;
+    
+    // Regions of the current text still to be re-matched, in the order they should be searched.
+    private final LinkedList<Region> pendingRegions = new LinkedList<Region>();
+    // The search in progress, if any. Its region has already been removed from pendingRegions.
+    private Search search;
+    // The region touched by edits since we last scheduled work, or null.
+    private Region damage;
+    
+    PFindAll(PTextArea textArea) {
+        this.textArea = textArea;
+        textArea.getTextBuffer().addTextListener(this);
+    }
+    
+    /**
+     * Replaces the active find with one for 'regularExpression', which may be null or empty to clear all matches.
+     * Nothing is searched until the caller asks for updateInBackground or updateNow.
+     * A PatternSyntaxException leaves the existing matches alone.
+     */
+    void setPattern(String regularExpression, BirdView birdView, Runnable matchesChangedListener) {
+        Pattern newPattern = null;
+        if (regularExpression != null && regularExpression.length() > 0) {
+            newPattern = PatternUtilities.smartCaseCompile(regularExpression);
+        }
+        textArea.getLock().getWriteLock();
+        try {
+            abandonScheduledWork();
+            damage = null;
+            textArea.removeHighlights(PFind.MatchHighlight.HIGHLIGHTER_NAME);
+            if (birdView != null) {
+                birdView.clearMatchingLines();
+            }
+            this.pattern = newPattern;
+            this.birdView = birdView;
+            this.matchesChangedListener = matchesChangedListener;
+            if (pattern != null) {
+                final int visibleStart = getVisibleStartOffset();
+                pendingRegions.add(new Region(visibleStart, textArea.getTextBuffer().length()));
+                if (visibleStart > 0) {
+                    pendingRegions.add(new Region(0, visibleStart));
+                }
+            }
+        } finally {
+            textArea.getLock().relinquishWriteLock();
+        }
+    }
+    
+    private int getVisibleStartOffset() {
+        Rectangle visible = textArea.getVisibleRect();
+        if (visible.isEmpty()) {
+            return 0;
+        }
+        final int offset = textArea.getTextIndex(textArea.getNearestCoordinates(new Point(0, visible.y)));
+        return textArea.getLineStartOffset(textArea.getLineOfOffset(offset));
+    }
+    
+    /**
+     * Starts bringing the matches up to date on a background thread, unless that's already happening.
+     */
+    void updateInBackground() {
+        textArea.getLock().getWriteLock();
+        try {
+            if (pattern == null) {
+                return;
+            }
+            if (damage != null) {
+                pendingRegions.add(damage);
+                damage = null;
+            }
+            if (search == null) {
+                startNextSearch();
+            }
+        } finally {
+            textArea.getLock().relinquishWriteLock();
+        }
+    }
+    
+    /**
+     * Brings the matches up to date on the calling thread, abandoning any background search.
+     * This is for callers that need the results immediately, such as "Find Next" straight after an edit.
+     * It's cheap if the matches are already up to date.
+     */
+    void updateNow() {
+        textArea.getLock().getWriteLock();
+        try {
+            if (pattern == null) {
+                return;
+            }
+            abandonScheduledWork();
+            if (damage == null) {
+                return;
+            }
+            search = new Search(damage, true);
+            damage = null;
+            search.run();
+            fireMatchesChanged();
+        } finally {
+            textArea.getLock().relinquishWriteLock();
+        }
+    }
+    
+    private void startNextSearch() {
+        Region region = pendingRegions.poll();
+        if (region == null) {
+            return;
+        }
+        search = new Search(region, false);
+        WorkScheduler.submit(WorkScheduler.Priority.INTERACTIVE, "Find All", search);
+    }
+    
+    /**
+     * Stops the search in progress and forgets the pending regions, turning anything they hadn't yet covered back into damage.
+     */
+    private void abandonScheduledWork() {
+        if (search != null) {
+            search.cancelled = true;
+            addDamage(search.appliedTo, Math.max(search.appliedTo, search.syncOffset));
+            search = null;
+        }
+        for (Region region : pendingRegions) {
+            addDamage(region.start, region.end);
+        }
+        pendingRegions.clear();
+    }
+    
+    private void addDamage(int start, int end) {
+        if (damage == null) {
+            damage = new Region(start, end);
+        } else {
+            damage.start = Math.min(damage.start, start);
+            damage.end = Math.max(damage.end, end);
+        }
+    }
+    
+    /**
+     * Applies a batch of matches, replacing the old matches whose start offsets fall in the region the batch covers.
+     * Called with the write lock held.
+     */
+    private void applyBatch(Search batchSearch, Batch batch) {
+        if (batchSearch != search || batchSearch.cancelled) {
+            return;
+        }
+        // The lines whose BirdView marks might change are those the old and new matches end on.
+        int lastEnd = Math.min(batch.to, textArea.getTextBuffer().length());
+        for (PHighlight highlight : textArea.getNamedHighlightsOverlapping(PFind.MatchHighlight.HIGHLIGHTER_NAME, batch.from, batch.to)) {
+            if (highlight.getStartIndex() >= batch.from) {
+                lastEnd = Math.max(lastEnd, highlight.getEndIndex());
+            }
+        }
+        List<PHighlight> replacements = new ArrayList<PHighlight>(batch.count);
+        for (int i = 0; i < batch.count; ++i) {
+            replacements.add(new PFind.MatchHighlight(textArea, batch.starts[i], batch.ends[i]));
+            lastEnd = Math.max(lastEnd, batch.ends[i]);
+        }
+        textArea.replaceHighlights(PFind.MatchHighlight.HIGHLIGHTER_NAME, batch.from, batch.to, replacements);
+        updateBirdView(textArea.getLineOfOffset(batch.from), textArea.getLineOfOffset(lastEnd));
+        search.appliedTo = batch.to;
+        if (batch.isLast) {
+            search = null;
+            // A synchronous search's caller tidies up after it.
+            if (batchSearch.isSynchronous == false) {
+                startNextSearch();
+            }
+        }
+        if (batchSearch.isSynchronous == false) {
+            fireMatchesChanged();
+        }
+    }
+    
+    /**
+     * Recomputes the BirdView's marks for the lines [firstLine, lastLine].
+     * Removing a match from a line doesn't tell us whether the line has other matches, so we look at all the matches ending on those lines.
+     */
+    private void updateBirdView(int firstLine, int lastLine) {
+        if (birdView == null) {
+            return;
+        }
+        final int startOffset = textArea.getLineStartOffset(firstLine);
+        final int endOffset = (lastLine + 1 < textArea.getLineCount()) ? textArea.getLineStartOffset(lastLine + 1) - 1 : textArea.getTextBuffer().length();
+        birdView.setValueIsAdjusting(true);
+        try {
+            for (int line = firstLine; line <= lastLine; ++line) {
+                birdView.removeMatchingLine(line);
+            }
+            // Start one early so that an empty match at startOffset counts as overlapping.
+            for (PHighlight highlight : textArea.getNamedHighlightsOverlapping(PFind.MatchHighlight.HIGHLIGHTER_NAME, Math.max(0, startOffset - 1), endOffset + 1)) {
+                final int end = highlight.getEndIndex();
+                if (end >= startOffset && end <= endOffset) {
+                    birdView.addMatchingLine(textArea.getLineOfOffset(end));
+                }
+            }
+        } finally {
+            birdView.setValueIsAdjusting(false);
+        }
+    }
+    
+    private void fireMatchesChanged() {
+        if (matchesChangedListener != null) {
+            matchesChangedListener.run();
+        }
+    }
+    
+    //
+    // PTextListener interface.
+    //
+    
+    public void textInserted(PTextEvent event) {
+        textChanged(event.getOffset(), event.getLength(), 0, countNewlines(event.getCharacters()));
+    }
+    
+    public void textRemoved(PTextEvent event) {
+        textChanged(event.getOffset(), 0, event.getLength(), -countNewlines(event.getCharacters()));
+    }
+    
+    public void textCompletelyReplaced(PTextEvent event) {
+        if (pattern != null) {
+            abandonScheduledWork();
+            damage = new Region(0, event.getLength());
+            if (birdView != null) {
+                birdView.clearMatchingLines();
+            }
+        }
+    }
+    
+    private static int countNewlines(CharSequence chars) {
+        int result = 0;
+        for (int i = 0; i < chars.length(); ++i) {
+            if (chars.charAt(i) == '\n') {
+                ++result;
+            }
+        }
+        return result;
+    }
+    
+    private void textChanged(int offset, int insertedLength, int removedLength, int lineCountChange) {
+        if (pattern == null) {
+            return;
+        }
+        // The marks for the edited line itself will be recomputed when its damage is re-matched.
+        if (birdView != null && lineCountChange != 0) {
+            birdView.shiftMatchingLines(textArea.getLineOfOffset(offset), lineCountChange);
+        }
+        // The work we'd scheduled was in terms of the old text, so it becomes damage and is adjusted along with the rest.
+        abandonScheduledWork();
+        if (damage != null) {
+            damage.start = adjustOffset(damage.start, offset, insertedLength, removedLength);
+            damage.end = adjustOffset(damage.end, offset, insertedLength, removedLength);
+        }
+        addDamage(offset, offset + insertedLength);
+    }
+    
+    private static int adjustOffset(int oldOffset, int editOffset, int insertedLength, int removedLength) {
+        if (oldOffset <= editOffset) {
+            return oldOffset;
+        } else if (oldOffset < editOffset + removedLength) {
+            return editOffset;
+        } else {
+            return oldOffset - removedLength + insertedLength;
+        }
+    }
+    
+    private static class Region {
+        private int start;
+        private int end;
+        
+        private Region(int start, int end) {
+            this.start = start;
+            this.end = end;
+        }
+    }
+    
+    /**
+     * Matches found by a search, covering the offsets [from, to).
+     */
+    private static class Batch {
+        private final int from;
+        private int to;
+        private int count = 0;
+        private int[] starts = new int[16];
+        private int[] ends = new int[16];
+        private boolean isLast = false;
+        
+        private Batch(int from) {
+            this.from = from;
+        }
+        
+        private void add(int start, int end) {
+            if (count == starts.length) {
+                starts = Arrays.copyOf(starts, 2 * count);
+                ends = Arrays.copyOf(ends, 2 * count);
+            }
+            starts[count] = start;
+            ends[count] = end;
+            ++count;
+        }
+    }
+    
+    /**
+     * Re-matches a region, on the calling thread if it's synchronous and as a WorkScheduler task otherwise.
+     * It's constructed with the write lock held, and takes everything it needs from the text area then.
+     */
+    private class Search implements Runnable {
+        // The text to search: the buffer itself for a synchronous search, and otherwise a copy of the part we need, starting at textOffset.
+        private final CharSequence text;
+        private final int textOffset;
+        private final Pattern searchPattern = pattern;
+        private final boolean isSynchronous;
+        // Where matching starts: the start of the region's first line, or of an old match overlapping it.
+        private final int scanStart;
+        // Once we're at or beyond this offset, a match identical to an old one means we're done.
+        private final int syncOffset;
+        // We don't look for matches starting at or beyond this offset: the old ones there are still right.
+        private final int scanEnd;
+        // The old matches at or beyond syncOffset.
+        private final int[] oldStarts;
+        private final int[] oldEnds;
+        // How far the batches applied so far reach; guarded by the write lock.
+        private int appliedTo;
+        private volatile boolean cancelled = false;
+        
+        private Search(Region region, boolean isSynchronous) {
+            this.isSynchronous = isSynchronous;
+            final PTextBuffer buffer = textArea.getTextBuffer();
+            final int length = buffer.length();
+            int start = textArea.getLineStartOffset(textArea.getLineOfOffset(Math.min(region.start, length)));
+            for (PHighlight highlight : textArea.getNamedHighlightsOverlapping(PFind.MatchHighlight.HIGHLIGHTER_NAME, start, start + 1)) {
+                start = Math.min(start, highlight.getStartIndex());
+            }
+            this.scanStart = start;
+            this.appliedTo = start;
+            this.syncOffset = Math.max(start, Math.min(region.end, length));
+            this.scanEnd = getStartOfLineAfter(syncOffset, CONTEXT_LINES);
+            List<PHighlight> oldMatches = textArea.getNamedHighlightsOverlapping(PFind.MatchHighlight.HIGHLIGHTER_NAME, syncOffset, scanEnd + 1);
+            this.oldStarts = new int[oldMatches.size()];
+            this.oldEnds = new int[oldMatches.size()];
+            for (int i = 0; i < oldMatches.size(); ++i) {
+                oldStarts[i] = oldMatches.get(i).getStartIndex();
+                oldEnds[i] = oldMatches.get(i).getEndIndex();
+            }
+            if (isSynchronous) {
+                // We hold the write lock until we're done, so the buffer can't change under us.
+                this.text = buffer;
+                this.textOffset = 0;
+            } else {
+                // A line either side gives lookaround something to look at, and lets a match that starts before scanEnd finish.
+                final int startLine = textArea.getLineOfOffset(scanStart);
+                this.textOffset = (startLine > 0) ? textArea.getLineStartOffset(startLine - 1) : 0;
+                this.text = buffer.subSequence(textOffset, getStartOfLineAfter(scanEnd, CONTEXT_LINES)).toString();
+            }
+        }
+        
+        /**
+         * Returns the offset of the start of the line 'lineCount' lines after the one containing 'offset', or the end of the text if there's no such line.
+         */
+        private int getStartOfLineAfter(int offset, int lineCount) {
+            final int line = textArea.getLineOfOffset(offset) + 1 + lineCount;
+            return (line < textArea.getLineCount()) ? textArea.getLineStartOffset(line) : textArea.getTextBuffer().length();
+        }
+        
+        public void run() {
+            Matcher matcher = searchPattern.matcher(text);
+            // Our copy's ends aren't the text's, so they shouldn't satisfy anchors, and lookaround should see past the region.
+            matcher.useAnchoringBounds(false);
+            matcher.useTransparentBounds(true);
+            matcher.region(scanStart - textOffset, text.length());
+            Batch batch = new Batch(scanStart);
+            int oldIndex = 0;
+            boolean found = matcher.find();
+            while (found) {
+                if (cancelled) {
+                    return;
+                }
+                final int start = textOffset + matcher.start();
+                final int end = textOffset + matcher.end();
+                if (start >= scanEnd && scanEnd < textOffset + text.length()) {
+                    // We've covered the damage and its context without getting back in step; the old matches from here on are still right.
+                    deliver(batch, scanEnd, true);
+                    return;
+                }
+                if (start >= syncOffset) {
+                    while (oldIndex < oldStarts.length && oldStarts[oldIndex] < start) {
+                        ++oldIndex;
+                    }
+                    if (oldIndex < oldStarts.length && oldStarts[oldIndex] == start && oldEnds[oldIndex] == end) {
+                        deliver(batch, start, true);
+                        return;
+                    }
+                }
+                batch.add(start, end);
+                if (batch.count == BATCH_SIZE) {
+                    // Matcher.find won't return another match starting at an empty match's offset, so the next batch can start just after it.
+                    final int batchEnd = Math.max(end, start + 1);
+                    deliver(batch, batchEnd, false);
+                    batch = new Batch(batchEnd);
+                }
+                found = matcher.find();
+            }
+            // We reached the end of what we were searching.
+            deliver(batch, (scanEnd < textOffset + text.length()) ? scanEnd : textOffset + text.length() + 1, true);
+        }
+        
+        private void deliver(final Batch batch, int to, boolean isLast) {
+            batch.to = to;
+            batch.isLast = isLast;
+            if (isSynchronous) {
+                applyBatch(this, batch);
+                return;
+            }
+            EventQueue.invokeLater(new Runnable() {
+                public void run() {
+                    textArea.getLock().getWriteLock();
+                    try {
+                        applyBatch(Search.this, batch);
+                    } finally {
+                        textArea.getLock().relinquishWriteLock();
+                    }
+                }
+            });
+        }
+    }
+}
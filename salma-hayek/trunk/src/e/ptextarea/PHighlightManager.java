@@ -1,7 +1,16 @@
 package e.ptextarea;
 
 import java.util.*;
+import org.jessies.test.*;
 
+/**
+ * Holds a PTextArea's highlights, grouped by highlighter name.
+ *
+ * Each group is an interval tree: a treap ordered by start offset, in which every node also records the highlight with the greatest end offset in its subtree.
+ * Highlights are anchored, so their offsets change as the text is edited, but an edit never reorders anchors, so neither the ordering nor the recorded maxima need fixing up afterwards.
+ * Single additions and removals are O(log n), and overlap queries only visit subtrees that can contain an overlapping highlight, however long the highlights are.
+ * Bulk additions and removals rebuild a group in one linear pass instead.
+ */
 public class PHighlightManager {
     private final Map<String, HighlightSet> highlighterSets = new LinkedHashMap<String, HighlightSet>();
     
@@ -11,27 +20,75 @@ public class PHighlightManager {
     }
     
     public synchronized void add(PHighlight highlight) {
-        String highlighterName = highlight.getHighlighterName();
-        if (highlighterSets.containsKey(highlighterName) == false) {
-            highlighterSets.put(highlighterName, new HighlightSet());
+        getOrCreateSet(highlight.getHighlighterName()).add(highlight);
+    }
+    
+    /**
+     * Adds all the given highlights, which needn't be of the same type.
+     */
+    public synchronized void addAll(Collection<? extends PHighlight> highlights) {
+        for (Map.Entry<String, List<PHighlight>> entry : groupByHighlighterName(highlights).entrySet()) {
+            getOrCreateSet(entry.getKey()).addAll(entry.getValue());
         }
-        highlighterSets.get(highlighterName).add(highlight);
     }
     
     public synchronized void remove(PHighlight highlight) {
-        String highlighterName = highlight.getHighlighterName();
-        if (highlighterSets.containsKey(highlighterName)) {
-            highlighterSets.get(highlighterName).remove(highlight);
+        HighlightSet set = highlighterSets.get(highlight.getHighlighterName());
+        if (set != null) {
+            set.remove(highlight);
         }
     }
     
+    /**
+     * Removes all the given highlights, which needn't be of the same type.
+     */
+    public synchronized void removeAll(Collection<? extends PHighlight> highlights) {
+        for (Map.Entry<String, List<PHighlight>> entry : groupByHighlighterName(highlights).entrySet()) {
+            HighlightSet set = highlighterSets.get(entry.getKey());
+            if (set != null) {
+                set.removeAll(entry.getValue());
+            }
+        }
+    }
+    
+    /**
+     * Removes all the highlights matching highlighterName, returning them in order.
+     */
+    public synchronized List<PHighlight> removeAllOfType(String highlighterName) {
+        HighlightSet set = highlighterSets.get(highlighterName);
+        // We keep the empty set rather than removing it, so that this type of highlight keeps its place in the painting order.
+        return (set != null) ? set.clear() : new ArrayList<PHighlight>();
+    }
+    
+    private HighlightSet getOrCreateSet(String highlighterName) {
+        HighlightSet set = highlighterSets.get(highlighterName);
+        if (set == null) {
+            set = new HighlightSet();
+            highlighterSets.put(highlighterName, set);
+        }
+        return set;
+    }
+    
+    private static Map<String, List<PHighlight>> groupByHighlighterName(Collection<? extends PHighlight> highlights) {
+        Map<String, List<PHighlight>> result = new LinkedHashMap<String, List<PHighlight>>();
+        for (PHighlight highlight : highlights) {
+            List<PHighlight> group = result.get(highlight.getHighlighterName());
+            if (group == null) {
+                group = new ArrayList<PHighlight>();
+                result.put(highlight.getHighlighterName(), group);
+            }
+            group.add(highlight);
+        }
+        return result;
+    }
+    
     /**
      * Returns all highlighters overlapping the range [beginOffset, endOffset).
      */
     public synchronized List<PHighlight> getHighlightsOverlapping(int beginOffset, int endOffset) {
         List<PHighlight> result = new ArrayList<PHighlight>();
         for (HighlightSet set : highlighterSets.values()) {
-            result.addAll(set.getHighlightsOverlapping(beginOffset, endOffset));
+            set.collectHighlightsOverlapping(beginOffset, endOffset, result);
         }
         return result;
     }
@@ -40,12 +97,12 @@ public class PHighlightManager {
      * Returns all highlighters matching highlighterName overlapping the range [beginOffset, endOffset).
      */
     public synchronized List<PHighlight> getNamedHighlightsOverlapping(String highlighterName, int beginOffset, int endOffset) {
+        List<PHighlight> result = new ArrayList<PHighlight>();
         HighlightSet set = highlighterSets.get(highlighterName);
         if (set != null) {
-            return set.getHighlightsOverlapping(beginOffset, endOffset);
-        } else {
-            return Collections.emptyList();
+            set.collectHighlightsOverlapping(beginOffset, endOffset, result);
         }
+        return result;
     }
     
     public synchronized PHighlight getNextOrPreviousHighlight(String highlighterName, boolean next, int offset) {
@@ -57,67 +114,398 @@ public class PHighlightManager {
     }
     
     private static class HighlightSet {
-        private TreeSet<PHighlight> highlights = new TreeSet<PHighlight>();
+        private static final Random random = new Random();
+        
+        private Node root;
+        private int size = 0;
+        
+        private static final class Node {
+            private final PHighlight highlight;
+            private final int priority = random.nextInt();
+            private Node left;
+            private Node right;
+            // The highlight with the greatest end offset in this subtree.
+            private PHighlight maxEnd;
+            
+            private Node(PHighlight highlight) {
+                this.highlight = highlight;
+                this.maxEnd = highlight;
+            }
+            
+            private void update() {
+                maxEnd = highlight;
+                if (left != null && left.maxEnd.getEndIndex() > maxEnd.getEndIndex()) {
+                    maxEnd = left.maxEnd;
+                }
+                if (right != null && right.maxEnd.getEndIndex() > maxEnd.getEndIndex()) {
+                    maxEnd = right.maxEnd;
+                }
+            }
+        }
+        
+        private int size() {
+            return size;
+        }
         
         private void add(PHighlight highlight) {
-            highlights.add(highlight);
+            // Like the TreeSet we used to use, we keep at most one highlight per start offset, and the first one wins.
+            if (findStartingAt(highlight.getStartIndex()) != null) {
+                return;
+            }
+            root = insert(root, new Node(highlight));
+            ++size;
+        }
+        
+        private void addAll(List<PHighlight> highlights) {
+            // A few highlights are cheaper to insert individually than to rebuild for.
+            if (highlights.size() < size / 16) {
+                for (PHighlight highlight : highlights) {
+                    add(highlight);
+                }
+                return;
+            }
+            List<PHighlight> newHighlights = new ArrayList<PHighlight>(highlights);
+            Collections.sort(newHighlights);
+            List<PHighlight> oldHighlights = toList();
+            List<PHighlight> merged = new ArrayList<PHighlight>(oldHighlights.size() + newHighlights.size());
+            int oldIndex = 0;
+            int newIndex = 0;
+            while (oldIndex < oldHighlights.size() || newIndex < newHighlights.size()) {
+                if (newIndex == newHighlights.size() || (oldIndex < oldHighlights.size() && oldHighlights.get(oldIndex).getStartIndex() <= newHighlights.get(newIndex).getStartIndex())) {
+                    // Edits can leave existing highlights sharing a start offset, and those we keep.
+                    merged.add(oldHighlights.get(oldIndex++));
+                } else {
+                    PHighlight next = newHighlights.get(newIndex++);
+                    if (merged.isEmpty() || merged.get(merged.size() - 1).getStartIndex() != next.getStartIndex()) {
+                        merged.add(next);
+                    }
+                }
+            }
+            rebuild(merged);
         }
         
         private void remove(PHighlight highlight) {
-            highlights.remove(highlight);
+            Node[] removed = new Node[1];
+            root = remove(root, highlight, highlight.getStartIndex(), removed);
+            if (removed[0] != null) {
+                --size;
+            }
         }
         
-        private int size() {
-            return highlights.size();
+        private void removeAll(List<PHighlight> highlights) {
+            if (highlights.size() < size / 16) {
+                for (PHighlight highlight : highlights) {
+                    remove(highlight);
+                }
+                return;
+            }
+            IdentityHashMap<PHighlight, Object> deadHighlights = new IdentityHashMap<PHighlight, Object>();
+            for (PHighlight highlight : highlights) {
+                deadHighlights.put(highlight, null);
+            }
+            List<PHighlight> survivors = new ArrayList<PHighlight>(size);
+            for (PHighlight highlight : toList()) {
+                if (deadHighlights.containsKey(highlight) == false) {
+                    survivors.add(highlight);
+                }
+            }
+            rebuild(survivors);
+        }
+        
+        private List<PHighlight> clear() {
+            List<PHighlight> result = toList();
+            root = null;
+            size = 0;
+            return result;
         }
         
+        private List<PHighlight> toList() {
+            List<PHighlight> result = new ArrayList<PHighlight>(size);
+            collectAll(root, result);
+            return result;
+        }
+        
+        private static void collectAll(Node node, List<PHighlight> result) {
+            if (node != null) {
+                collectAll(node.left, result);
+                result.add(node.highlight);
+                collectAll(node.right, result);
+            }
+        }
+        
+        /**
+         * Rebuilds the treap from highlights sorted by start offset, in linear time.
+         * This is the usual stack-based Cartesian tree construction: the stack holds the right spine of the tree built so far.
+         */
+        private void rebuild(List<PHighlight> sortedHighlights) {
+            Node[] stack = new Node[sortedHighlights.size()];
+            int depth = 0;
+            for (PHighlight highlight : sortedHighlights) {
+                Node node = new Node(highlight);
+                Node lastPopped = null;
+                while (depth > 0 && stack[depth - 1].priority < node.priority) {
+                    lastPopped = stack[--depth];
+                    lastPopped.update();
+                }
+                node.left = lastPopped;
+                if (depth > 0) {
+                    stack[depth - 1].right = node;
+                }
+                stack[depth++] = node;
+            }
+            root = (depth > 0) ? stack[0] : null;
+            while (depth > 0) {
+                stack[--depth].update();
+            }
+            size = sortedHighlights.size();
+        }
+        
+        private static Node insert(Node node, Node newNode) {
+            if (node == null) {
+                return newNode;
+            }
+            if (newNode.highlight.getStartIndex() < node.highlight.getStartIndex()) {
+                node.left = insert(node.left, newNode);
+                if (node.left.priority > node.priority) {
+                    return rotateRight(node);
+                }
+            } else {
+                node.right = insert(node.right, newNode);
+                if (node.right.priority > node.priority) {
+                    return rotateLeft(node);
+                }
+            }
+            node.update();
+            return node;
+        }
+        
+        /**
+         * Removes 'highlight' (by identity) from the subtree rooted at 'node', storing its node in removed[0].
+         * An edit that deletes text can leave several highlights with the same start offset, so we may have to look on both sides of a node with the start offset we're after.
+         */
+        private static Node remove(Node node, PHighlight highlight, int startIndex, Node[] removed) {
+            if (node == null) {
+                return null;
+            }
+            if (node.highlight == highlight) {
+                removed[0] = node;
+                return join(node.left, node.right);
+            }
+            final int nodeStartIndex = node.highlight.getStartIndex();
+            if (startIndex <= nodeStartIndex) {
+                node.left = remove(node.left, highlight, startIndex, removed);
+            }
+            if (removed[0] == null && startIndex >= nodeStartIndex) {
+                node.right = remove(node.right, highlight, startIndex, removed);
+            }
+            node.update();
+            return node;
+        }
+        
+        /**
+         * Joins two treaps, where everything in 'left' starts no later than anything in 'right'.
+         */
+        private static Node join(Node left, Node right) {
+            if (left == null) {
+                return right;
+            } else if (right == null) {
+                return left;
+            } else if (left.priority > right.priority) {
+                left.right = join(left.right, right);
+                left.update();
+                return left;
+            } else {
+                right.left = join(left, right.left);
+                right.update();
+                return right;
+            }
+        }
+        
+        private static Node rotateRight(Node node) {
+            Node newRoot = node.left;
+            node.left = newRoot.right;
+            newRoot.right = node;
+            node.update();
+            newRoot.update();
+            return newRoot;
+        }
+        
+        private static Node rotateLeft(Node node) {
+            Node newRoot = node.right;
+            node.right = newRoot.left;
+            newRoot.left = node;
+            node.update();
+            newRoot.update();
+            return newRoot;
+        }
+        
+        private PHighlight findStartingAt(int offset) {
+            Node node = root;
+            while (node != null) {
+                final int startIndex = node.highlight.getStartIndex();
+                if (startIndex == offset) {
+                    return node.highlight;
+                }
+                node = (offset < startIndex) ? node.left : node.right;
+            }
+            return null;
+        }
+        
+        /**
+         * Returns the first highlight starting at or after 'offset'.
+         */
         private PHighlight getHighlightAfter(int offset) {
-            SortedSet<PHighlight> after = highlights.tailSet(new ProbeHighlight(offset));
-            return (after.size() == 0) ? null : after.first();
+            PHighlight result = null;
+            Node node = root;
+            while (node != null) {
+                if (node.highlight.getStartIndex() >= offset) {
+                    result = node.highlight;
+                    node = node.left;
+                } else {
+                    node = node.right;
+                }
+            }
+            return result;
         }
         
+        /**
+         * Returns the last highlight starting before 'offset'.
+         */
         private PHighlight getHighlightBefore(int offset) {
-            SortedSet<PHighlight> before = highlights.headSet(new ProbeHighlight(offset));
-            return (before.size() == 0) ? null : before.last();
-        }
-        
-        private List<PHighlight> getHighlightsOverlapping(int beginOffset, int endOffset) {
-            // The 'firstItem' is to be the lowest-indexed highlight wrapper which *overlaps* the range.
-            // We must check highlights which start <= beginOffset to determine if they end > beginOffset.
-            PHighlight firstItem = new ProbeHighlight(beginOffset);
-            SortedSet<PHighlight> highlightsBeforeStart = highlights.headSet(firstItem, true);
-            if (highlightsBeforeStart.size() > 0) {
-                PHighlight lastBefore = highlightsBeforeStart.last();
-                if (lastBefore.getEndIndex() > beginOffset) {
-                    firstItem = lastBefore;
+            PHighlight result = null;
+            Node node = root;
+            while (node != null) {
+                if (node.highlight.getStartIndex() < offset) {
+                    result = node.highlight;
+                    node = node.right;
+                } else {
+                    node = node.left;
                 }
             }
-            
-            // Now we have the start, and the end too, so we can simply grab the subset between these two extremes (inclusive of firstItem) and return as a list.
-            SortedSet<PHighlight> highlightsInRange = highlights.subSet(firstItem, new ProbeHighlight(endOffset));
-            List<PHighlight> result = new ArrayList<PHighlight>(highlightsInRange);
             return result;
         }
+        
+        /**
+         * Appends the highlights overlapping [beginOffset, endOffset) to 'result', in order of start offset.
+         * Empty highlights count as overlapping if they start in the range.
+         */
+        private void collectHighlightsOverlapping(int beginOffset, int endOffset, List<PHighlight> result) {
+            collectHighlightsOverlapping(root, beginOffset, endOffset, result);
+        }
+        
+        private static void collectHighlightsOverlapping(Node node, int beginOffset, int endOffset, List<PHighlight> result) {
+            // Nothing in a subtree that ends before the range can overlap it.
+            if (node == null || node.maxEnd.getEndIndex() < beginOffset) {
+                return;
+            }
+            collectHighlightsOverlapping(node.left, beginOffset, endOffset, result);
+            final int startIndex = node.highlight.getStartIndex();
+            // Nothing from here rightwards starts before the end of the range.
+            if (startIndex >= endOffset) {
+                return;
+            }
+            if (startIndex >= beginOffset || node.highlight.getEndIndex() > beginOffset) {
+                result.add(node.highlight);
+            }
+            collectHighlightsOverlapping(node.right, beginOffset, endOffset, result);
+        }
     }
     
-    private static final class ProbeHighlight extends PHighlight {
-        private final int fixedOffset;
+    private static class TestHighlight extends PHighlight {
+        private final int startIndex;
+        private final int endIndex;
         
-        private ProbeHighlight(int fixedOffset) {
-            super();
-            this.fixedOffset = fixedOffset;
+        private TestHighlight(int startIndex, int endIndex) {
+            this.startIndex = startIndex;
+            this.endIndex = endIndex;
         }
         
         @Override public int getStartIndex() {
-            return fixedOffset;
+            return startIndex;
+        }
+        
+        @Override public int getEndIndex() {
+            return endIndex;
         }
         
         public String getHighlighterName() {
-            throw new UnsupportedOperationException();
+            return "Test";
         }
         
         protected void paintHighlight(java.awt.Graphics2D g, PCoordinates start, PCoordinates end, java.awt.Insets insets, int lineHeight, int firstLineIndex, int lastLineIndex) {
             throw new UnsupportedOperationException();
         }
     }
+    
+    private static List<PHighlight> makeTestHighlights(Random random, int count) {
+        List<PHighlight> result = new ArrayList<PHighlight>();
+        for (int i = 0; i < count; ++i) {
+            final int start = 10 * i + random.nextInt(10);
+            // Mostly short highlights, with the occasional long one that a neighbour-walking search would miss.
+            final int length = (random.nextInt(20) == 0) ? random.nextInt(2000) : random.nextInt(15);
+            result.add(new TestHighlight(start, start + length));
+        }
+        return result;
+    }
+    
+    private static List<PHighlight> naiveOverlapping(List<PHighlight> highlights, int beginOffset, int endOffset) {
+        List<PHighlight> result = new ArrayList<PHighlight>();
+        for (PHighlight highlight : highlights) {
+            final int start = highlight.getStartIndex();
+            if (start < endOffset && (start >= beginOffset || highlight.getEndIndex() > beginOffset)) {
+                result.add(highlight);
+            }
+        }
+        return result;
+    }
+    
+    @Test private static void testOverlapping() {
+        Random random = new Random(0);
+        List<PHighlight> highlights = makeTestHighlights(random, 2000);
+        PHighlightManager manager = new PHighlightManager();
+        // Half individually, half in bulk.
+        for (PHighlight highlight : highlights.subList(0, 1000)) {
+            manager.add(highlight);
+        }
+        manager.addAll(highlights.subList(1000, 2000));
+        Assert.equals(manager.countHighlightsOfType("Test"), 2000);
+        for (int i = 0; i < 200; ++i) {
+            final int begin = random.nextInt(21000);
+            final int end = begin + random.nextInt(300);
+            Assert.equals(manager.getHighlightsOverlapping(begin, end), naiveOverlapping(highlights, begin, end));
+        }
+        
+        // Remove a few individually, and many in bulk.
+        List<PHighlight> survivors = new ArrayList<PHighlight>();
+        List<PHighlight> victims = new ArrayList<PHighlight>();
+        for (PHighlight highlight : highlights) {
+            (random.nextBoolean() ? survivors : victims).add(highlight);
+        }
+        for (PHighlight highlight : victims.subList(0, 10)) {
+            manager.remove(highlight);
+        }
+        manager.removeAll(victims.subList(10, victims.size()));
+        Assert.equals(manager.countHighlightsOfType("Test"), survivors.size());
+        for (int i = 0; i < 200; ++i) {
+            final int begin = random.nextInt(21000);
+            final int end = begin + random.nextInt(300);
+            Assert.equals(manager.getHighlightsOverlapping(begin, end), naiveOverlapping(survivors, begin, end));
+        }
+        
+        Assert.equals(manager.removeAllOfType("Test"), survivors);
+        Assert.equals(manager.countHighlightsOfType("Test"), 0);
+    }
+    
+    @Test private static void testNextAndPrevious() {
+        PHighlightManager manager = new PHighlightManager();
+        manager.addAll(Arrays.asList(new TestHighlight(10, 12), new TestHighlight(20, 22), new TestHighlight(30, 32)));
+        // A duplicate start offset is ignored, as it was when we used a TreeSet.
+        manager.add(new TestHighlight(20, 25));
+        Assert.equals(manager.countHighlightsOfType("Test"), 3);
+        Assert.equals(manager.getNextOrPreviousHighlight("Test", true, 20).getEndIndex(), 22);
+        Assert.equals(manager.getNextOrPreviousHighlight("Test", true, 21).getStartIndex(), 30);
+        Assert.equals(manager.getNextOrPreviousHighlight("Test", true, 31), null);
+        Assert.equals(manager.getNextOrPreviousHighlight("Test", false, 20).getStartIndex(), 10);
+        Assert.equals(manager.getNextOrPreviousHighlight("Test", false, 10), null);
+    }
 }
@@ -87,7 +87,15 @@ public abstract class PIndenter {
      * because they end in (a single character of) whitespace.
      */
     public final String getCurrentIndentationOfLine(int lineNumber) {
-        return indentationOf(textArea.getLineText(lineNumber));
+        return indentationOf(getLineText(lineNumber));
+    }
+    
+    /**
+     * Returns the text of the given line as indenters should see it.
+     * Overridden by PSimpleIndenter, which doesn't touch the buffer until it's worked out the indentation of a whole range of lines.
+     */
+    protected String getLineText(int lineNumber) {
+        return textArea.getLineText(lineNumber);
     }
     
     public static final String indentationOf(String line) {
@@ -113,6 +121,14 @@ public abstract class PIndenter {
         final int startLine = textArea.getLineOfOffset(startOffset);
         // I've thought about (and experimented with) the +-1 issue here.
         final int finishLine = textArea.getLineOfOffset(endOffset);
+        fixIndentationOnLines(startLine, finishLine);
+    }
+    
+    /**
+     * Corrects the indentation of the lines from startLine to finishLine inclusive.
+     * This implementation just fixes each line in turn.
+     */
+    protected void fixIndentationOnLines(int startLine, int finishLine) {
         for (int lineIndex = startLine; lineIndex <= finishLine; ++lineIndex) {
             fixIndentationOnLine(lineIndex);
         }
@@ -69,7 +69,7 @@ public class PNewCppIndenter extends PSimpleIndenter {
         String indentation = getCurrentIndentationOfLine(previousLineNumber);
         
         // Get the previous line, and the non-comment part of the previous line.
-        final String previousLine = textArea.getLineText(previousLineNumber);
+        final String previousLine = getLineText(previousLineNumber);
         final String activePartOfPrevious = getActivePartOfLine(previousLineNumber);
         
         //System.err.println("'" + activePartOfPrevious + "'; indentation '" + indentation + "'");
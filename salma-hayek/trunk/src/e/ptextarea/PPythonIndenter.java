@@ -37,7 +37,7 @@ public class PPythonIndenter extends PSimpleIndenter {
         
         // Get the previous line and remove any trailing comment.
         // FIXME: use styler information.
-        String previousLine = textArea.getLineText(previousNonBlankLineNumber);
+        String previousLine = getLineText(previousNonBlankLineNumber);
         int commentIndex = previousLine.indexOf("#");
         if (commentIndex != -1) {
             previousLine = previousLine.substring(0, commentIndex);
@@ -63,7 +63,7 @@ public class PPythonIndenter extends PSimpleIndenter {
         if (currentLine.matches("^\\s*(except|finally)\\b.*$")) {
             // Find the matching "try".
             for (int tryLineNumber = lineNumber - 1; tryLineNumber >= 0; --tryLineNumber) {
-                String tryLine = textArea.getLineText(tryLineNumber);
+                String tryLine = getLineText(tryLineNumber);
                 if (tryLine.matches("^\\s*(try|except)\\b.*$")) {
                     String tryIndentation = indentationOf(tryLine);
                     if (tryIndentation.length() >= getCurrentIndentationOfLine(lineNumber).length()) {
@@ -7,6 +7,11 @@ import java.util.*;
  * Implements the core functionality of any real indenter, which is to look at the line in question, split it into indentation and content, work out the new 
  */
 public abstract class PSimpleIndenter extends PIndenter {
+    // While fixIndentationOnLines works through a range, the replacement text for the lines it's done so far (null for the rest).
+    // The buffer isn't touched until the whole range is done, so getLineText has to consult this.
+    private String[] replacementLines;
+    private int firstReplacementLine;
+    
     public PSimpleIndenter(PTextArea textArea) {
         super(textArea);
     }
@@ -21,23 +26,123 @@ public abstract class PSimpleIndenter extends PIndenter {
             return;
         }
         int lineStartOffset = textArea.getLineStartOffset(lineIndex);
-        int charsInserted = replacementIndentation.length() - originalIndentation.length();
-        int desiredStartOffset = adjustOffsetAfterInsertion(textArea.getSelectionStart(), lineStartOffset, originalIndentation, replacementIndentation);
-        int desiredEndOffset = adjustOffsetAfterInsertion(textArea.getSelectionEnd(), lineStartOffset, originalIndentation, replacementIndentation);
-        int trimOffset = lineStartOffset + replacementLine.length();
-        int charsTrimmed = originalLine.length() - (replacementLine.length() - charsInserted);
-        desiredStartOffset = adjustOffsetAfterDeletion(desiredStartOffset, trimOffset, charsTrimmed);
-        desiredEndOffset = adjustOffsetAfterDeletion(desiredEndOffset, trimOffset, charsTrimmed);
+        int desiredStartOffset = adjustOffsetForReplacement(textArea.getSelectionStart(), lineStartOffset, originalLine, originalIndentation, replacementLine, replacementIndentation);
+        int desiredEndOffset = adjustOffsetForReplacement(textArea.getSelectionEnd(), lineStartOffset, originalLine, originalIndentation, replacementLine, replacementIndentation);
         textArea.replaceRange(replacementLine, lineStartOffset, lineStartOffset + originalLine.length());
         textArea.select(desiredStartOffset, desiredEndOffset);
     }
     
+    /**
+     * Works out the indentation of every line in the range against the unmodified buffer, and then applies the result as a single edit.
+     * Replacing each line as we went would cost a text event, an undo entry, restyling and a repaint per line.
+     */
+    @Override protected void fixIndentationOnLines(int startLine, int finishLine) {
+        if (startLine == finishLine) {
+            fixIndentationOnLine(startLine);
+            return;
+        }
+        final int lineCount = finishLine - startLine + 1;
+        String[] originalLines = new String[lineCount];
+        String[] originalIndentations = new String[lineCount];
+        String[] replacementIndentations = new String[lineCount];
+        String[] newLines = new String[lineCount];
+        replacementLines = newLines;
+        firstReplacementLine = startLine;
+        try {
+            for (int i = 0; i < lineCount; ++i) {
+                final int lineIndex = startLine + i;
+                originalLines[i] = textArea.getLineText(lineIndex);
+                originalIndentations[i] = indentationOf(originalLines[i]);
+                replacementIndentations[i] = calculateNewIndentation(lineIndex);
+                // Only now do later lines see this line's new indentation.
+                newLines[i] = replacementIndentations[i] + StringUtilities.trimTrailingWhitespace(originalLines[i].substring(originalIndentations[i].length()));
+            }
+        } finally {
+            replacementLines = null;
+        }
+        
+        int first = 0;
+        while (first < lineCount && newLines[first].equals(originalLines[first])) {
+            ++first;
+        }
+        if (first == lineCount) {
+            return;
+        }
+        int last = lineCount - 1;
+        while (newLines[last].equals(originalLines[last])) {
+            --last;
+        }
+        
+        // Move the selection just as it would have moved if we'd replaced each line in turn.
+        int desiredStartOffset = textArea.getSelectionStart();
+        int desiredEndOffset = textArea.getSelectionEnd();
+        final int replacementStartOffset = textArea.getLineStartOffset(startLine + first);
+        final int replacementEndOffset = textArea.getLineStartOffset(startLine + last) + originalLines[last].length();
+        StringBuilder replacement = new StringBuilder(replacementEndOffset - replacementStartOffset);
+        int lineStartOffset = replacementStartOffset;
+        for (int i = first; i <= last; ++i) {
+            if (newLines[i].equals(originalLines[i]) == false) {
+                desiredStartOffset = adjustOffsetForReplacement(desiredStartOffset, lineStartOffset, originalLines[i], originalIndentations[i], newLines[i], replacementIndentations[i]);
+                desiredEndOffset = adjustOffsetForReplacement(desiredEndOffset, lineStartOffset, originalLines[i], originalIndentations[i], newLines[i], replacementIndentations[i]);
+            }
+            if (i > first) {
+                replacement.append('\n');
+            }
+            replacement.append(newLines[i]);
+            lineStartOffset += newLines[i].length() + 1;
+        }
+        textArea.replaceRange(replacement, replacementStartOffset, replacementEndOffset);
+        textArea.select(desiredStartOffset, desiredEndOffset);
+    }
+    
+    @Override protected final String getLineText(int lineIndex) {
+        if (replacementLines != null) {
+            int i = lineIndex - firstReplacementLine;
+            if (i >= 0 && i < replacementLines.length && replacementLines[i] != null) {
+                return replacementLines[i];
+            }
+        }
+        return textArea.getLineText(lineIndex);
+    }
+    
+    /**
+     * Adjusts text derived from the buffer's copy of the given line, whose leading characters line up with the line's indentation, for any new indentation we've worked out but not yet applied.
+     * The derived text may have replaced comment characters in the indentation (the asterisk of a doc-comment, say) with spaces; we do the same to the new indentation.
+     */
+    protected final String withReplacementIndentation(int lineIndex, String derivedText) {
+        if (replacementLines == null) {
+            return derivedText;
+        }
+        String line = getLineText(lineIndex);
+        String bufferLine = textArea.getLineText(lineIndex);
+        if (line.equals(bufferLine)) {
+            return derivedText;
+        }
+        String originalIndentation = indentationOf(bufferLine);
+        if (derivedText.length() <= originalIndentation.length()) {
+            return derivedText;
+        }
+        String replacementIndentation = indentationOf(line);
+        if (derivedText.startsWith(originalIndentation) == false) {
+            replacementIndentation = replacementIndentation.replace('*', ' ');
+        }
+        return replacementIndentation + derivedText.substring(originalIndentation.length());
+    }
+    
     /**
      * Returns the indentation which should be used for the given line number.
      * Override this in your subclass to define your indenter's policy.
      */
     protected abstract String calculateNewIndentation(int lineNumber);
     
+    private static int adjustOffsetForReplacement(int offsetToAdjust, int lineStartOffset, String originalLine, String originalIndentation, String replacementLine, String replacementIndentation) {
+        int charsInserted = replacementIndentation.length() - originalIndentation.length();
+        int trimOffset = lineStartOffset + replacementLine.length();
+        int charsTrimmed = originalLine.length() - (replacementLine.length() - charsInserted);
+        offsetToAdjust = adjustOffsetAfterInsertion(offsetToAdjust, lineStartOffset, originalIndentation, replacementIndentation);
+        return adjustOffsetAfterDeletion(offsetToAdjust, trimOffset, charsTrimmed);
+    }
+    
     private static int adjustOffsetAfterInsertion(int offsetToAdjust, int lineStartOffset, String originalIndentation, String replacementIndentation) {
         if (offsetToAdjust < lineStartOffset) {
             return offsetToAdjust;
@@ -73,7 +178,7 @@ public abstract class PSimpleIndenter extends PIndenter {
     
     protected final int getPreviousNonBlankLineNumber(int startLineNumber) {
         for (int lineNumber = startLineNumber - 1; lineNumber >= 0; --lineNumber) {
-            if (textArea.getLineText(lineNumber).trim().length() != 0) {
+            if (getLineText(lineNumber).trim().length() != 0) {
                 return lineNumber;
             }
         }
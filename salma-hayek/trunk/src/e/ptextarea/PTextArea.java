@@ -33,9 +33,9 @@ public class PTextArea extends JComponent implements PLineListener, Scrollable,
     private final PTabSegment SINGLE_TAB = new PTabSegment(this, 0, 1);
     
     private PHighlightManager highlights = new PHighlightManager();
+    private PFindAll findAll;
     private PTextStyler textStyler = new PPlainTextStyler(this);
-    private List<StyleApplicator> styleApplicators;
-    private TabStyleApplicator tabStyleApplicator = new TabStyleApplicator(this);
+    private StyleApplicatorChain styleApplicators;
     
     private boolean canShowRightHandMargin = false;
     private int rightHandMarginColumn = NO_MARGIN;
@@ -80,6 +80,7 @@ public class PTextArea extends JComponent implements PLineListener, Scrollable,
         
         initStyleApplicators();
         lines.addLineListener(this);
+        this.findAll = new PFindAll(this);
         revalidateLineWrappings();
         
         setAutoscrolls(true);
@@ -165,7 +166,8 @@ public class PTextArea extends JComponent implements PLineListener, Scrollable,
     }
     
     private void initStyleApplicators() {
-        styleApplicators = new ArrayList<StyleApplicator>();
+        // Tabs are always dealt with last.
+        styleApplicators = new StyleApplicatorChain(new TabStyleApplicator(this));
         addStyleApplicator(new UnprintableCharacterStyleApplicator(this));
         addStyleApplicator(new HyperlinkStyleApplicator(this));
         if (textStyler instanceof PAbstractLanguageStyler) {
@@ -178,7 +180,7 @@ public class PTextArea extends JComponent implements PLineListener, Scrollable,
     }
     
     public void addStyleApplicatorFirst(StyleApplicator styleApplicator) {
-        styleApplicators.add(0, styleApplicator);
+        styleApplicators.addFirst(styleApplicator);
     }
     
     // Selection methods.
@@ -628,6 +630,21 @@ public class PTextArea extends JComponent implements PLineListener, Scrollable,
         }
     }
     
+    /**
+     * Adds many highlights at once, which is much cheaper than adding them one at a time.
+     */
+    public void addHighlights(Collection<? extends PHighlight> newHighlights) {
+        getLock().getWriteLock();
+        try {
+            highlights.addAll(newHighlights);
+            if (newHighlights.size() > 0) {
+                repaint();
+            }
+        } finally {
+            getLock().relinquishWriteLock();
+        }
+    }
+    
     public List<PHighlight> getNamedHighlights(String highlighterName) {
         return getNamedHighlightsOverlapping(highlighterName, 0, getTextBuffer().length() + 1);
     }
@@ -667,11 +684,16 @@ public class PTextArea extends JComponent implements PLineListener, Scrollable,
     public void removeHighlights(String highlighterName, int beginOffset, int endOffset) {
         getLock().getWriteLock();
         try {
-            List<PHighlight> removeList = highlights.getNamedHighlightsOverlapping(highlighterName, beginOffset, endOffset);
+            List<PHighlight> removeList;
+            if (beginOffset <= 0 && endOffset > getTextBuffer().length()) {
+                removeList = highlights.removeAllOfType(highlighterName);
+            } else {
+                removeList = highlights.getNamedHighlightsOverlapping(highlighterName, beginOffset, endOffset);
+                highlights.removeAll(removeList);
+            }
             IdentityHashMap<PAnchor, Object> deadAnchors = new IdentityHashMap<PAnchor, Object>();
             for (PHighlight highlight : removeList) {
                 highlight.collectAnchors(deadAnchors);
-                highlights.remove(highlight);
             }
             getTextBuffer().getAnchorSet().removeAll(deadAnchors);
             if (removeList.size() == 1) {
@@ -684,6 +706,31 @@ public class PTextArea extends JComponent implements PLineListener, Scrollable,
         }
     }
     
+    /**
+     * Replaces the highlights matching "highlighterName" that start in [beginOffset, endOffset) with "replacements", which must also start in that range.
+     */
+    void replaceHighlights(String highlighterName, int beginOffset, int endOffset, List<PHighlight> replacements) {
+        getLock().getWriteLock();
+        try {
+            List<PHighlight> removeList = new ArrayList<PHighlight>();
+            IdentityHashMap<PAnchor, Object> deadAnchors = new IdentityHashMap<PAnchor, Object>();
+            for (PHighlight highlight : highlights.getNamedHighlightsOverlapping(highlighterName, beginOffset, endOffset)) {
+                if (highlight.getStartIndex() >= beginOffset) {
+                    highlight.collectAnchors(deadAnchors);
+                    removeList.add(highlight);
+                }
+            }
+            highlights.removeAll(removeList);
+            getTextBuffer().getAnchorSet().removeAll(deadAnchors);
+            highlights.addAll(replacements);
+            if (removeList.size() + replacements.size() > 0) {
+                repaint();
+            }
+        } finally {
+            getLock().relinquishWriteLock();
+        }
+    }
+    
     public void removeHighlight(PHighlight highlight) {
         getLock().getWriteLock();
         try {
@@ -829,14 +876,9 @@ public class PTextArea extends JComponent implements PLineListener, Scrollable,
             // Let the styler have the first go.
             List<PLineSegment> segments = textStyler.getTextSegments(lineIndex);
             
-            // Then let the style applicators add their finishing touches.
+            // Then let the style applicators add their finishing touches, and deal with tabs.
             String line = getLineContents(lineIndex).toString();
-            for (StyleApplicator styleApplicator : styleApplicators) {
-                segments = applyStyleApplicator(styleApplicator, line, segments);
-            }
-            
-            // Finally, deal with tabs.
-            segments = applyStyleApplicator(tabStyleApplicator, line, segments);
+            segments = styleApplicators.apply(line, segments);
             synchronized (segmentCache) {
                 segmentCache.put(lineIndex, segments);
             }
@@ -866,18 +908,6 @@ public class PTextArea extends JComponent implements PLineListener, Scrollable,
         }
     }
     
-    private List<PLineSegment> applyStyleApplicator(StyleApplicator styleApplicator, String line, List<PLineSegment> inputSegments) {
-        List<PLineSegment> result = new ArrayList<PLineSegment>();
-        for (PLineSegment segment : inputSegments) {
-            if (styleApplicator.canApplyStylingTo(segment.getStyle())) {
-                result.addAll(styleApplicator.applyStylingTo(line, segment));
-            } else {
-                result.add(segment);
-            }
-        }
-        return result;
-    }
-    
     private void addTabbedSegments(PLineSegment segment, ArrayList<PLineSegment> target) {
         while (true) {
             String text = segment.getViewText();
@@ -1454,45 +1484,33 @@ public class PTextArea extends JComponent implements PLineListener, Scrollable,
      * The given BirdView (which can be null) will be updated to correspond to the new matches.
      */
     public int findAllMatches(String regularExpression, BirdView birdView) {
-        getLock().getWriteLock();
-        try {
-            return findAllMatchesWithWriteLockAlreadyHeld(regularExpression, birdView);
-        } finally {
-            getLock().relinquishWriteLock();
-        }
+        findAll.setPattern(regularExpression, birdView, null);
+        findAll.updateNow();
+        return getFindMatchCount();
     }
     
-    private int findAllMatchesWithWriteLockAlreadyHeld(String regularExpression, BirdView birdView) {
-        removeHighlights(PFind.MatchHighlight.HIGHLIGHTER_NAME);
-        if (birdView != null) {
-            birdView.clearMatchingLines();
-        }
-        
-        // Anything to search for?
-        if (regularExpression == null || regularExpression.length() == 0) {
-            return 0;
-        }
-        
-        // Find all the matches.
-        if (birdView != null) {
-            birdView.setValueIsAdjusting(true);
-        }
-        try {
-            int matchCount = 0;
-            Matcher matcher = PatternUtilities.smartCaseCompile(regularExpression).matcher(getTextBuffer());
-            while (matcher.find()) {
-                if (birdView != null) {
-                    birdView.addMatchingLine(getLineOfOffset(matcher.end()));
-                }
-                addHighlight(new PFind.MatchHighlight(this, matcher.start(), matcher.end()));
-                ++matchCount;
-            }
-            return matchCount;
-        } finally {
-            if (birdView != null) {
-                birdView.setValueIsAdjusting(false);
-            }
-        }
+    /**
+     * Like findAllMatches, but searches a snapshot of the text on a background thread, starting with the visible region, and returns immediately.
+     * A bad regular expression still throws PatternSyntaxException straight away.
+     * The given listener (which can be null) is run on the event dispatch thread whenever a batch of matches arrives.
+     */
+    public void findAllMatchesInBackground(String regularExpression, BirdView birdView, Runnable matchesChangedListener) {
+        findAll.setPattern(regularExpression, birdView, matchesChangedListener);
+        findAll.updateInBackground();
+    }
+    
+    /**
+     * Re-matches the lines edited since the matches were last brought up to date, on a background thread.
+     */
+    public void updateFindMatchesInBackground() {
+        findAll.updateInBackground();
+    }
+    
+    /**
+     * Brings the matches up to date before returning, abandoning any background search.
+     */
+    public void updateFindMatches() {
+        findAll.updateNow();
     }
     
     public void findNext() {
@@ -11,8 +11,17 @@ import e.util.*;
 public class PTextAreaSpellingChecker implements PTextListener, MenuItemProvider {
     private static final String HIGHLIGHTER_NAME = "PTextAreaSpellingChecker";
     
+    private static final Scheduler SCHEDULER = new Scheduler();
+    
     private PTextArea component;
     
+    // The state of this text area's whole-buffer check, confined to the EDT like the rest of the scheduler.
+    // backgroundOffset is where the check of the rest of the buffer has got to; it's shifted by edits like an anchor would be.
+    private boolean visibleTextChecked = true;
+    private int backgroundOffset = 0;
+    // Incremented by every edit, so a check of a snapshot of the text knows whether its offsets are still good.
+    private int editCount = 0;
+    
     public PTextAreaSpellingChecker(PTextArea component) {
         this.component = component;
         initPopUpMenu();
@@ -127,17 +136,31 @@ public class PTextAreaSpellingChecker implements PTextListener, MenuItemProvider
     
     /** Notification that some text has been inserted into the PText. */
     public void textInserted(PTextEvent event) {
+        noteEdit(event);
         checkSpelling(event);
     }
     
     /** Notification that some text has been removed from the PText. */
     public void textRemoved(PTextEvent event) {
+        noteEdit(event);
         checkSpelling(event);
     }
     
     /** Notification that all of the text held within the PText object has been completely replaced. */
     public void textCompletelyReplaced(PTextEvent event) {
-        checkSpelling(event);
+        noteEdit(event);
+        // This is typically a file being opened or reverted, which is no reason to check all of it on the EDT.
+        checkSpelling();
+    }
+    
+    private void noteEdit(PTextEvent event) {
+        ++editCount;
+        if (event.isInsert() && event.getOffset() < backgroundOffset) {
+            backgroundOffset += event.getLength();
+        } else if (event.isRemove() && event.getOffset() < backgroundOffset) {
+            backgroundOffset = Math.max(event.getOffset(), backgroundOffset - event.getLength());
+        }
+        SCHEDULER.noteEdit();
     }
     
     /**
@@ -147,37 +170,233 @@ public class PTextAreaSpellingChecker implements PTextListener, MenuItemProvider
     private void checkSpelling(PTextEvent e) {
         final PTextBuffer buffer = e.getTextBuffer();
         final int offset = e.getOffset();
-        final int documentLength = buffer.length();
+        int fromIndex = startOfWordBefore(buffer, Math.max(0, offset - 1));
+        // Find a plausible place to finish after the end of the range affected by this event.
+        int toIndex = e.isRemove() ? offset : offset + e.getLength() + 1;
+        toIndex = endOfWordAfter(buffer, Math.max(Math.min(toIndex, buffer.length()), fromIndex));
+        //System.err.println("offset: " + offset + " fromIndex: " + fromIndex + " toIndex: " + toIndex + " length: " + buffer.length());
+        // The SpellingChecker's word cache means we only go to the back end for words it hasn't seen before.
+        applyMisspellings(fromIndex, toIndex, findMisspellings(buffer, fromIndex, toIndex, component.getFileType()));
+    }
+    
+    // Finds a plausible place to start checking at or before 'index'.
+    private static int startOfWordBefore(CharSequence text, int index) {
+        while (index > 0 && Character.isWhitespace(text.charAt(index - 1)) == false) {
+            --index;
+        }
+        return index;
+    }
+    
+    // Finds a plausible place to finish checking at or after 'index'.
+    private static int endOfWordAfter(CharSequence text, int index) {
+        while (index < text.length() && Character.isWhitespace(text.charAt(index)) == false) {
+            ++index;
+        }
+        return index;
+    }
+    
+    /**
+     * Checks the spelling of all the text.
+     * The visible part is checked first, and the rest when the user isn't typing, a chunk at a time, on a thread shared by all text areas.
+     */
+    public void checkSpelling() {
+        visibleTextChecked = false;
+        backgroundOffset = 0;
+        SCHEDULER.add(this);
+    }
+    
+    private void applyMisspellings(int fromIndex, int toIndex, List<Range> misspellings) {
+        removeExistingHighlightsForRange(fromIndex, toIndex);
+        // We add all the highlights at the end, because adding thousands one at a time is slow.
+        List<PHighlight> newHighlights = new ArrayList<PHighlight>(misspellings.size());
+        for (Range misspelling : misspellings) {
+            newHighlights.add(new UnderlineHighlight(component, misspelling.getStart(), misspelling.getEnd()));
+        }
+        component.addHighlights(newHighlights);
+    }
+    
+    private boolean isInFocusedWindow() {
+        Window window = SwingUtilities.getWindowAncestor(component);
+        return window != null && window.isFocused();
+    }
+    
+    // Returns the range of offsets currently on the screen, or null if the text area isn't showing.
+    private Range getVisibleRange() {
+        if (component.isShowing() == false) {
+            return null;
+        }
+        Rectangle visible = component.getVisibleRect();
+        int fromIndex = component.getTextIndex(component.getNearestCoordinates(new Point(0, visible.y)));
+        int toIndex = component.getTextIndex(component.getNearestCoordinates(new Point(visible.x + visible.width, visible.y + visible.height)));
+        return new Range(fromIndex, toIndex);
+    }
+    
+    /**
+     * Returns the next piece of this text area's whole-buffer check, or null if there's nothing left of the given kind.
+     */
+    private Chunk nextChunk(boolean visibleText) {
+        PTextBuffer buffer = component.getTextBuffer();
+        int fromIndex;
+        int toIndex;
+        if (visibleText) {
+            Range range = (visibleTextChecked == false) ? getVisibleRange() : null;
+            if (range == null) {
+                return null;
+            }
+            visibleTextChecked = true;
+            fromIndex = range.getStart();
+            toIndex = range.getEnd();
+        } else {
+            if (backgroundOffset >= buffer.length()) {
+                return null;
+            }
+            fromIndex = backgroundOffset;
+            toIndex = Math.min(fromIndex + Chunk.SIZE, buffer.length());
+        }
+        fromIndex = startOfWordBefore(buffer, fromIndex);
+        toIndex = endOfWordAfter(buffer, toIndex);
+        if (visibleText == false) {
+            backgroundOffset = toIndex;
+        }
+        return new Chunk(this, visibleText, fromIndex, toIndex);
+    }
+    
+    /**
+     * A snapshot of part of a text area's text, to be checked off the EDT.
+     */
+    private static class Chunk {
+        // Large enough to amortize the hand-offs, small enough that newly visible text doesn't wait long behind some other buffer.
+        private static final int SIZE = 16 * 1024;
+        
+        private final PTextAreaSpellingChecker checker;
+        private final boolean isVisibleText;
+        private final int fromIndex;
+        private final int toIndex;
+        private final int editCount;
+        private final String text;
+        private final FileType fileType;
         
-        // Find a plausible place to start before the offset.
-        int fromIndex = Math.max(0, offset - 1);
-        while (fromIndex > 0 && Character.isWhitespace(buffer.charAt(fromIndex - 1)) == false) {
-            fromIndex--;
+        private Chunk(PTextAreaSpellingChecker checker, boolean isVisibleText, int fromIndex, int toIndex) {
+            this.checker = checker;
+            this.isVisibleText = isVisibleText;
+            this.fromIndex = fromIndex;
+            this.toIndex = toIndex;
+            this.editCount = checker.editCount;
+            this.text = checker.component.getTextBuffer().subSequence(fromIndex, toIndex).toString();
+            this.fileType = checker.component.getFileType();
         }
         
-        // Find a plausible place to finish after the end of the range affected by this event.
-        int toIndex = e.isRemove() ? offset : offset + e.getLength() + 1;
-        toIndex = Math.min(toIndex, documentLength);  // Not past the end.
-        toIndex = Math.max(toIndex, fromIndex);  // Not before the start.
-        while (toIndex < documentLength && Character.isWhitespace(buffer.charAt(toIndex)) == false) {
-            toIndex++;
+        private List<Range> check() {
+            List<Range> result = findMisspellings(text, 0, text.length(), fileType);
+            for (int i = 0; i < result.size(); ++i) {
+                Range range = result.get(i);
+                result.set(i, new Range(fromIndex + range.getStart(), fromIndex + range.getEnd()));
+            }
+            return result;
         }
         
-        //System.err.println("offset: " + offset + " fromIndex: " + fromIndex + " toIndex: " + toIndex + " length: " + documentLength);
-        checkSpelling(buffer, fromIndex, toIndex);
+        // Called back on the EDT with the result of check.
+        private void finish(List<Range> misspellings) {
+            if (checker.editCount == editCount) {
+                checker.applyMisspellings(fromIndex, toIndex, misspellings);
+            } else if (isVisibleText) {
+                // The text moved under us, so our offsets are no good. Try again.
+                checker.visibleTextChecked = false;
+            } else {
+                checker.backgroundOffset = Math.min(checker.backgroundOffset, fromIndex);
+            }
+        }
     }
     
     /**
-     * Checks the spelling of all the text. Runs in a new thread, because
-     * it can take a second or more for a large file.
+     * Checks the spelling of whole buffers, for every text area, one chunk at a time and never more than one chunk at once.
+     * Visible text in the focused window goes first, then visible text elsewhere, and then the rest of each buffer once the user has stopped typing for a moment.
+     * All the bookkeeping happens on the EDT; only the checking of each chunk happens on the WorkScheduler.
      */
-    public void checkSpelling() {
-        new Thread(new Runnable() {
-            public void run() {
-                PTextBuffer buffer = component.getTextBuffer();
-                checkSpelling(buffer, 0, buffer.length());
+    private static class Scheduler {
+        private static final int IDLE_DELAY_MS = 500;
+        
+        private final LinkedHashSet<PTextAreaSpellingChecker> pending = new LinkedHashSet<PTextAreaSpellingChecker>();
+        private final javax.swing.Timer idleTimer;
+        private boolean isBusy = false;
+        private long lastEditTimeMs = 0;
+        
+        private Scheduler() {
+            idleTimer = new javax.swing.Timer(IDLE_DELAY_MS, new ActionListener() {
+                public void actionPerformed(ActionEvent e) {
+                    scheduleNext();
+                }
+            });
+            idleTimer.setRepeats(false);
+        }
+        
+        private void add(PTextAreaSpellingChecker checker) {
+            pending.add(checker);
+            scheduleNext();
+        }
+        
+        private void noteEdit() {
+            lastEditTimeMs = System.currentTimeMillis();
+        }
+        
+        private void scheduleNext() {
+            if (isBusy) {
+                return;
+            }
+            final Chunk chunk = nextChunk();
+            if (chunk == null) {
+                if (pending.isEmpty() == false) {
+                    idleTimer.restart();
+                }
+                return;
+            }
+            isBusy = true;
+            WorkScheduler.submit(WorkScheduler.Priority.BACKGROUND, "Spelling Checker", new Runnable() {
+                public void run() {
+                    List<Range> misspellings = Collections.emptyList();
+                    try {
+                        misspellings = chunk.check();
+                    } finally {
+                        final List<Range> result = misspellings;
+                        EventQueue.invokeLater(new Runnable() {
+                            public void run() {
+                                isBusy = false;
+                                chunk.finish(result);
+                                scheduleNext();
+                            }
+                        });
+                    }
+                }
+            });
+        }
+        
+        // Returns null if there's nothing to do, or nothing to do until the user stops typing.
+        private Chunk nextChunk() {
+            List<PTextAreaSpellingChecker> checkers = new ArrayList<PTextAreaSpellingChecker>(pending);
+            // Checkers in the focused window go first.
+            Collections.sort(checkers, new Comparator<PTextAreaSpellingChecker>() {
+                public int compare(PTextAreaSpellingChecker lhs, PTextAreaSpellingChecker rhs) {
+                    return Boolean.valueOf(rhs.isInFocusedWindow()).compareTo(lhs.isInFocusedWindow());
+                }
+            });
+            for (PTextAreaSpellingChecker checker : checkers) {
+                Chunk chunk = checker.nextChunk(true);
+                if (chunk != null) {
+                    return chunk;
+                }
+            }
+            if (System.currentTimeMillis() - lastEditTimeMs < IDLE_DELAY_MS) {
+                return null;
             }
-        }, "Spell-Checker Thread").start();
+            for (PTextAreaSpellingChecker checker : checkers) {
+                Chunk chunk = checker.nextChunk(false);
+                if (chunk != null) {
+                    return chunk;
+                }
+                pending.remove(checker);
+            }
+            return null;
+        }
     }
     
     /** Ensures that there are no spelling-related highlights in the given range. */
@@ -222,17 +441,21 @@ public class PTextAreaSpellingChecker implements PTextListener, MenuItemProvider
      * constitute words in comments. This could cause trouble for Ada and VHDL source, but
      * I'll worry about them when I have reason to.
      */
-    private final boolean isWordCharacter(char c) {
+    private static boolean isWordCharacter(char c) {
         return Character.isLetter(c) || c == '\'';
     }
     
-    private void checkSpelling(PTextBuffer buffer, int fromIndex, int toIndex) {
+    /**
+     * Returns the ranges of the misspelled words in the given range of 'buffer'.
+     * Safe to call off the EDT, as long as 'buffer' isn't changing underneath us.
+     */
+    private static List<Range> findMisspellings(CharSequence buffer, int fromIndex, int toIndex, FileType fileType) {
         int checkCount = 0;
         int misspellingCount = 0;
         
         SpellingChecker spellingChecker = SpellingChecker.getSharedSpellingCheckerInstance();
         
-        removeExistingHighlightsForRange(fromIndex, toIndex);
+        List<Range> result = new ArrayList<Range>();
         
         // Breaks the given range up into words, where a changeOfCase or the presence_of_underscores constitutes a word boundary.
         int start = fromIndex;
@@ -309,14 +532,15 @@ public class PTextAreaSpellingChecker implements PTextListener, MenuItemProvider
             
             //System.err.println(">>" + word + " " + wordLength);
             checkCount++;
-            if (spellingChecker.isMisspelledWord(word, component.getFileType())) {
+            if (spellingChecker.isMisspelledWord(word, fileType)) {
                 misspellingCount++;
                 //System.err.println("Misspelled word \"" + word + "\"");
-                component.addHighlight(new UnderlineHighlight(component, start, finish));
+                result.add(new Range(start, finish));
             }
             
             start = finish;
         }
+        return result;
     }
     
     /**
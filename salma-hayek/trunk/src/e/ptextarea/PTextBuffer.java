@@ -4,6 +4,7 @@ import e.util.*;
 import java.io.*;
 import java.nio.*;
 import java.nio.charset.*;
+import java.security.*;
 import java.util.*;
 import javax.swing.event.ChangeEvent;
 import javax.swing.event.ChangeListener;
@@ -142,13 +143,18 @@ public class PTextBuffer implements CharSequence {
     
     /**
      * Replaces the contents of this buffer with the entire contents of 'file'.
+     * Returns the md5 digest of the bytes read, in the same form as FileUtilities.md5.
      */
-    public void readFromFile(File file) {
+    public String readFromFile(File file) {
         getLock().getWriteLock();
         try {
             // Read all the bytes in.
             final ByteBuffer byteBuffer = ByteBufferUtilities.readFile(file);
             
+            // Digest the bytes we already have, so callers needn't read the file again.
+            final MessageDigest digester = newMd5Digester();
+            digester.update(byteBuffer.duplicate());
+            
             // Decode the raw bytes into characters.
             final ByteBufferDecoder decoder = new ByteBufferDecoder(byteBuffer, byteBuffer.capacity());
             final String encoding = decoder.getEncodingName();
@@ -162,6 +168,7 @@ public class PTextBuffer implements CharSequence {
             // Use the characters and the inferred encoding.
             putProperty(CHARSET_PROPERTY, encoding);
             setText(chars);
+            return FileUtilities.byteArrayToHexString(digester.digest());
         } catch (IOException ex) {
             throw new RuntimeException(ex);
         } finally {
@@ -179,17 +186,21 @@ public class PTextBuffer implements CharSequence {
     /**
      * Writes the contents of this buffer into the given file, replacing
      * whatever's already there.
+     * Returns the md5 digest of the bytes written, in the same form as FileUtilities.md5.
      */
-    public void writeToFile(File file) {
+    public String writeToFile(File file) {
         FileOutputStream openFile = null;
         try {
             openFile = new FileOutputStream(file);
+            // Digest the bytes as they go past, so callers needn't read the file back.
+            final DigestOutputStream digestingStream = new DigestOutputStream(openFile, newMd5Digester());
             String charsetName = (String) getProperty(CHARSET_PROPERTY);
             // The CharsetEncoder created here will silently replace characters which cannot
             // be encoded with question marks.
             // This will currently happen if, for example, you have a file "recognized" as ISO-8859-1
             // into which you paste a UTF-8 character which isn't Latin1.
-            writeToStream(new OutputStreamWriter(openFile, charsetName));
+            writeToStream(new OutputStreamWriter(digestingStream, charsetName));
+            return FileUtilities.byteArrayToHexString(digestingStream.getMessageDigest().digest());
         } catch (IOException ex) {
             throw new RuntimeException(ex);
         } finally {
@@ -197,6 +208,15 @@ public class PTextBuffer implements CharSequence {
         }
     }
     
+    private static MessageDigest newMd5Digester() {
+        try {
+            return MessageDigest.getInstance("MD5");
+        } catch (NoSuchAlgorithmException ex) {
+            // Every Java implementation is required to support MD5.
+            throw new RuntimeException(ex);
+        }
+    }
+    
     /**
      * Switch charset encoding if the encoding works.
      */
@@ -19,6 +19,11 @@ public class PreprocessorStyleApplicator extends RegularExpressionStyleApplicato
         this.isObjectiveC = isObjectiveC;
     }
     
+    @Override
+    protected String getRequiredCharacters() {
+        return "#";
+    }
+    
     @Override
     public boolean isAcceptableMatch(CharSequence line, Matcher matcher) {
         // FIXME:
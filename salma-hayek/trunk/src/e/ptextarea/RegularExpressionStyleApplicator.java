@@ -24,18 +24,23 @@ public class RegularExpressionStyleApplicator implements StyleApplicator {
     }
     
     public List<PLineSegment> applyStylingTo(String line, PLineSegment segment) {
-        ArrayList<PLineSegment> result = new ArrayList<PLineSegment>();
-        Matcher matcher = pattern.matcher(segment.getCharSequence());
+        ArrayList<PLineSegment> result = null;
+        CharSequence text = segment.getCharSequence();
+        Matcher matcher = pattern.matcher(text);
         int normalStart = 0;
         int offset = segment.getOffset();
         while (matcher.find()) {
-            if (isAcceptableMatch(line, matcher)) {
+            if (isAcceptableMatch(line, text, matcher)) {
                 // We need exactly one group, but we accept more in case the user has used extra groups without making them non-capturing.
                 if (matcher.groupCount() < 1) {
                     Log.warn("RegularExpressionStyleApplicator for \"" + pattern + "\" disabled because it has no capturing group.");
                 }
-                final int matchStart = matcher.start(1);
-                final int matchEnd = matcher.end(1);
+                final int group = getStyledGroup(matcher);
+                final int matchStart = matcher.start(group);
+                final int matchEnd = matcher.end(group);
+                if (result == null) {
+                    result = new ArrayList<PLineSegment>();
+                }
                 if (matchStart > normalStart) {
                     result.add(segment.subSegment(normalStart, matchStart));
                 }
@@ -43,12 +48,31 @@ public class RegularExpressionStyleApplicator implements StyleApplicator {
                 normalStart = matchEnd;
             }
         }
+        if (result == null) {
+            // Nothing to style, which is by far the most common case, so don't copy anything.
+            return (segment.getModelTextLength() > 0) ? Collections.singletonList(segment) : Collections.<PLineSegment>emptyList();
+        }
         if (segment.getModelTextLength() > normalStart) {
             result.add(segment.subSegment(normalStart));
         }
         return result;
     }
     
+    /**
+     * Returns characters at least one of which must appear in a line for this applicator's pattern to match anything in it, or null if there's no such set.
+     * StyleApplicatorChain uses this to skip applicators that can't match a line without running their matchers.
+     */
+    protected String getRequiredCharacters() {
+        return null;
+    }
+    
+    /**
+     * Returns the group whose range should be styled; group 1 unless overridden.
+     */
+    protected int getStyledGroup(Matcher matcher) {
+        return 1;
+    }
+    
     protected PLineSegment makeNewSegment(PTextArea textArea, Matcher matcher, int start, int end, PStyle style) {
         PTextSegment result = new PTextSegment(textArea, start, end, style);
         if (style == PStyle.HYPERLINK) {
@@ -68,6 +92,14 @@ public class RegularExpressionStyleApplicator implements StyleApplicator {
         return true;
     }
     
+    /**
+     * Like isAcceptableMatch(line, matcher), but also given the text the matcher is matching.
+     * Override this instead if you can use the match's offsets into 'text' to avoid calling Matcher.group.
+     */
+    protected boolean isAcceptableMatch(CharSequence line, CharSequence text, Matcher matcher) {
+        return isAcceptableMatch(line, matcher);
+    }
+    
     public boolean canApplyStylingTo(PStyle style) {
         return (style == PStyle.NORMAL);
     }
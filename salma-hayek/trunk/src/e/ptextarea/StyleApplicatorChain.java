@@ -0,0 +1,105 @@
+package e.ptextarea;
+
+import java.util.*;
+
+/**
+ * Applies a text area's style applicators to a line in one pass.
+ * 
+ * Each of the styler's segments is pushed through every applicator in turn, depth-first, so we build a single list of segments rather than a new one per applicator.
+ * That gives the same result as applying each applicator to the whole line in turn, because an applicator only ever looks at one segment at a time.
+ * 
+ * Before that, one scan of the line finds out which ASCII characters it contains, and any applicator whose pattern needs a character that isn't there is skipped.
+ * Most lines contain no tabs, no control characters, no URLs and no bug numbers, so most lines only see the applicators that can actually change them.
+ */
+final class StyleApplicatorChain {
+    private final ArrayList<StyleApplicator> applicators = new ArrayList<StyleApplicator>();
+    private final StyleApplicator lastApplicator;
+    
+    /**
+     * 'lastApplicator' always runs after all the others, however they're added.
+     */
+    StyleApplicatorChain(StyleApplicator lastApplicator) {
+        this.lastApplicator = lastApplicator;
+    }
+    
+    void add(StyleApplicator styleApplicator) {
+        applicators.add(styleApplicator);
+    }
+    
+    void addFirst(StyleApplicator styleApplicator) {
+        applicators.add(0, styleApplicator);
+    }
+    
+    List<PLineSegment> apply(String line, List<PLineSegment> segments) {
+        // Bits 0-63 of the line's ASCII characters in 'low', and 64-127 in 'high'.
+        long low = 0;
+        long high = 0;
+        for (int i = 0; i < line.length(); ++i) {
+            char ch = line.charAt(i);
+            if (ch < 64) {
+                low |= 1L << ch;
+            } else if (ch < 128) {
+                high |= 1L << (ch - 64);
+            }
+        }
+        
+        StyleApplicator[] live = new StyleApplicator[applicators.size() + 1];
+        int liveCount = 0;
+        for (StyleApplicator styleApplicator : applicators) {
+            if (couldMatch(styleApplicator, low, high)) {
+                live[liveCount++] = styleApplicator;
+            }
+        }
+        if (couldMatch(lastApplicator, low, high)) {
+            live[liveCount++] = lastApplicator;
+        }
+        if (liveCount == 0) {
+            return segments;
+        }
+        
+        ArrayList<PLineSegment> result = new ArrayList<PLineSegment>(segments.size());
+        for (PLineSegment segment : segments) {
+            apply(live, liveCount, 0, line, segment, result);
+        }
+        return result;
+    }
+    
+    private static void apply(StyleApplicator[] applicators, int applicatorCount, int index, String line, PLineSegment segment, List<PLineSegment> result) {
+        for (; index < applicatorCount; ++index) {
+            StyleApplicator styleApplicator = applicators[index];
+            if (styleApplicator.canApplyStylingTo(segment.getStyle())) {
+                for (PLineSegment newSegment : styleApplicator.applyStylingTo(line, segment)) {
+                    apply(applicators, applicatorCount, index + 1, line, newSegment, result);
+                }
+                return;
+            }
+        }
+        result.add(segment);
+    }
+    
+    private static boolean couldMatch(StyleApplicator styleApplicator, long low, long high) {
+        if (styleApplicator instanceof RegularExpressionStyleApplicator == false) {
+            return true;
+        }
+        String requiredCharacters = ((RegularExpressionStyleApplicator) styleApplicator).getRequiredCharacters();
+        if (requiredCharacters == null) {
+            return true;
+        }
+        for (int i = 0; i < requiredCharacters.length(); ++i) {
+            char ch = requiredCharacters.charAt(i);
+            if (ch < 64) {
+                if ((low & (1L << ch)) != 0) {
+                    return true;
+                }
+            } else if (ch < 128) {
+                if ((high & (1L << (ch - 64))) != 0) {
+                    return true;
+                }
+            } else {
+                // We don't keep track of non-ASCII characters, so we can't rule this out.
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -17,6 +17,11 @@ public class TabStyleApplicator extends RegularExpressionStyleApplicator {
         return new PTabSegment(textArea, start, end);
     }
     
+    @Override
+    protected String getRequiredCharacters() {
+        return "\t";
+    }
+    
     @Override
     public boolean canApplyStylingTo(PStyle style) {
         return true;
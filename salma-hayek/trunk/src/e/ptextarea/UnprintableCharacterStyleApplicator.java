@@ -7,11 +7,28 @@ import java.util.regex.*;
  */
 public class UnprintableCharacterStyleApplicator extends RegularExpressionStyleApplicator {
     private static final Pattern UNPRINTABLE_CHARACTER_PATTERN = Pattern.compile("([\\u0000-\\u0008\\u000a-\\u001f\\u007f]+)");
+    private static final String UNPRINTABLE_CHARACTERS = makeUnprintableCharacters();
     
     public UnprintableCharacterStyleApplicator(PTextArea textArea) {
         super(textArea, UNPRINTABLE_CHARACTER_PATTERN, PStyle.UNPRINTABLE);
     }
     
+    private static String makeUnprintableCharacters() {
+        StringBuilder result = new StringBuilder();
+        for (char ch = 0; ch < ' '; ++ch) {
+            if (ch != '\t') {
+                result.append(ch);
+            }
+        }
+        result.append('\u007f');
+        return result.toString();
+    }
+    
+    @Override
+    protected String getRequiredCharacters() {
+        return UNPRINTABLE_CHARACTERS;
+    }
+    
     @Override
     protected PTextSegment makeNewSegment(PTextArea textArea, Matcher matcher, int start, int end, PStyle style) {
         return new UnprintableCharacterTextSegment(textArea, start, end, style);
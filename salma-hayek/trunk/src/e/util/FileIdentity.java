@@ -0,0 +1,59 @@
+package e.util;
+
+import java.io.*;
+import org.jessies.os.*;
+
+/**
+ * What stat(2) says about which file a path refers to and when it last changed: device, inode, size, and the modification and status change times to the nanosecond.
+ * If a path's FileIdentity is unchanged, its content almost certainly is too, so callers can avoid reading the file.
+ * Anything that rewrites the file (an editor saving via rename, a version control checkout, a build) changes at least one of these.
+ * Merely touching a file changes its identity without changing its content, so callers that care should fall back to comparing a digest such as FileUtilities.md5.
+ */
+public final class FileIdentity {
+    private final long device;
+    private final long inode;
+    private final long size;
+    private final long modificationTimeNs;
+    private final long statusChangeTimeNs;
+    
+    private FileIdentity(Stat stat) {
+        this.device = stat.st_dev();
+        this.inode = stat.st_ino();
+        this.size = stat.st_size();
+        this.modificationTimeNs = stat.st_mtime() * 1000000000L + stat.st_mtime_nsec();
+        this.statusChangeTimeNs = stat.st_ctime() * 1000000000L + stat.st_ctime_nsec();
+    }
+    
+    /**
+     * Returns the identity of the file at 'file', following symbolic links, or null if it can't be stat(2)ed.
+     */
+    public static FileIdentity fromFile(File file) {
+        Stat stat = new Stat();
+        if (Posix.stat(file.toString(), stat) != 0) {
+            return null;
+        }
+        return new FileIdentity(stat);
+    }
+    
+    @Override public boolean equals(Object o) {
+        if (o instanceof FileIdentity == false) {
+            return false;
+        }
+        FileIdentity other = (FileIdentity) o;
+        return device == other.device && inode == other.inode && size == other.size && modificationTimeNs == other.modificationTimeNs && statusChangeTimeNs == other.statusChangeTimeNs;
+    }
+    
+    @Override public int hashCode() {
+        long result = 17;
+        result = 31 * result + device;
+        result = 31 * result + inode;
+        result = 31 * result + size;
+        result = 31 * result + modificationTimeNs;
+        result = 31 * result + statusChangeTimeNs;
+        return (int) (result ^ (result >>> 32));
+    }
+    
+    @Override public String toString() {
+        return "FileIdentity[device=" + device + ",inode=" + inode + ",size=" + size + ",modificationTimeNs=" + modificationTimeNs + ",statusChangeTimeNs=" + statusChangeTimeNs + "]";
+    }
+}
@@ -0,0 +1,232 @@
+package e.util;
+
+import java.awt.*;
+import java.io.*;
+import java.util.*;
+import java.util.List;
+import org.jessies.test.*;
+
+/**
+ * Knows which font families are installed, and which of them are fixed-width, without asking AWT every time.
+ *
+ * Enumerating fonts is slow when there are thousands installed, and measuring every family to find the fixed-width ones is slower still.
+ * So we remember the answers in a file, keyed on the modification times of the directories that change when fonts are installed or removed: fontconfig's caches on Linux, and the font directories themselves elsewhere.
+ * If there's no file, we ask AWT for the family names straight away; if the file is out of date, we use it anyway and bring it up to date in the background.
+ */
+public final class FontCatalog {
+    private static final String CACHE_VERSION = "font-catalog 1";
+    
+    private static final String[] FONT_STATE_DIRECTORIES = new String[] {
+        // fontconfig rewrites a cache file in one of these whenever the fonts it knows about change.
+        "/var/cache/fontconfig",
+        "~/.cache/fontconfig",
+        "~/.fontconfig",
+        // Mac OS.
+        "/Library/Fonts",
+        "/System/Library/Fonts",
+        "~/Library/Fonts",
+    };
+    
+    private static FontCatalog instance;
+    private static boolean isRefreshing = false;
+    
+    // In the order AWT gives them to us.
+    private final List<String> familyNames;
+    private final Set<String> families;
+    // Null if we haven't yet measured the families.
+    private final Set<String> fixedWidthFamilies;
+    
+    private FontCatalog(List<String> familyNames, Set<String> fixedWidthFamilies) {
+        this.familyNames = Collections.unmodifiableList(familyNames);
+        this.families = new HashSet<String>(familyNames);
+        this.fixedWidthFamilies = fixedWidthFamilies;
+    }
+    
+    /**
+     * Tests whether the given font family is installed.
+     * This is much cheaper than searching GraphicsEnvironment.getAllFonts.
+     */
+    public static boolean isFamilyAvailable(String family) {
+        return getInstance().families.contains(family);
+    }
+    
+    /**
+     * Returns the names of all the installed font families, as GraphicsEnvironment.getAvailableFontFamilyNames would.
+     */
+    public static List<String> getFamilyNames() {
+        return getInstance().familyNames;
+    }
+    
+    /**
+     * Returns the names of the installed fixed-width font families, in the same order as getFamilyNames.
+     * Until the background refresh has measured every family, this is empty; we don't want to measure thousands of fonts on the caller's thread.
+     */
+    public static List<String> getFixedWidthFamilyNames() {
+        FontCatalog catalog = getInstance();
+        ArrayList<String> result = new ArrayList<String>();
+        if (catalog.fixedWidthFamilies != null) {
+            for (String family : catalog.familyNames) {
+                if (catalog.fixedWidthFamilies.contains(family)) {
+                    result.add(family);
+                }
+            }
+        }
+        return result;
+    }
+    
+    private static synchronized FontCatalog getInstance() {
+        if (instance == null) {
+            String key = getFontStateKey();
+            instance = readCache(key);
+            if (instance == null || instance.fixedWidthFamilies == null) {
+                // We either have no cache or a stale one. A stale cache is better than nothing, but we need to know the families now if there's no cache at all.
+                if (instance == null) {
+                    instance = new FontCatalog(Arrays.asList(GraphicsEnvironment.getLocalGraphicsEnvironment().getAvailableFontFamilyNames()), null);
+                }
+                refreshInBackground();
+            }
+        }
+        return instance;
+    }
+    
+    /**
+     * Re-enumerates and re-measures the installed fonts on a background thread, and rewrites the cache.
+     */
+    public static synchronized void refreshInBackground() {
+        if (isRefreshing) {
+            return;
+        }
+        isRefreshing = true;
+        WorkScheduler.submit(WorkScheduler.Priority.BACKGROUND, "Font Catalog", new Runnable() {
+            public void run() {
+                try {
+                    refresh();
+                } finally {
+                    synchronized (FontCatalog.class) {
+                        isRefreshing = false;
+                    }
+                }
+            }
+        });
+    }
+    
+    private static void refresh() {
+        // Take the key first, so that any change while we're enumerating will be noticed next time.
+        String key = getFontStateKey();
+        long startTimeNs = System.nanoTime();
+        List<String> familyNames = Arrays.asList(GraphicsEnvironment.getLocalGraphicsEnvironment().getAvailableFontFamilyNames());
+        Set<String> fixedWidthFamilies = new HashSet<String>();
+        for (String family : familyNames) {
+            if (GuiUtilities.isFontFixedWidth(new Font(family, Font.PLAIN, 12))) {
+                fixedWidthFamilies.add(family);
+            }
+        }
+        FontCatalog catalog = new FontCatalog(familyNames, fixedWidthFamilies);
+        synchronized (FontCatalog.class) {
+            instance = catalog;
+        }
+        File file = getCacheFile();
+        file.getParentFile().mkdirs();
+        String failure = StringUtilities.writeFile(file, catalog.toLines(key));
+        if (failure != null) {
+            Log.warn("Couldn't write font catalog to \"" + file + "\" (" + failure + ").");
+        }
+        Log.warn("Catalogued " + familyNames.size() + " font families (" + fixedWidthFamilies.size() + " fixed-width) in " + TimeUtilities.nsToString(System.nanoTime() - startTimeNs) + ".");
+    }
+    
+    /**
+     * Returns the file we keep the catalog in, alongside invoke-java.rb's cache of JVM versions.
+     */
+    private static File getCacheFile() {
+        String cacheDirectory = System.getenv("XDG_CACHE_HOME");
+        if (cacheDirectory == null || cacheDirectory.length() == 0) {
+            cacheDirectory = FileUtilities.getUserHomeDirectory() + File.separator + ".cache";
+        }
+        return new File(new File(cacheDirectory, "org.jessies"), "font-catalog");
+    }
+    
+    /**
+     * Returns a string that changes whenever the set of installed fonts is likely to have changed.
+     */
+    private static String getFontStateKey() {
+        List<String> directories = new ArrayList<String>(Arrays.asList(FONT_STATE_DIRECTORIES));
+        String windowsDirectory = System.getenv("WINDIR");
+        if (windowsDirectory != null) {
+            directories.add(windowsDirectory + File.separator + "Fonts");
+        }
+        StringBuilder result = new StringBuilder();
+        // Different JREs come with different fonts.
+        result.append(System.getProperty("java.home"));
+        for (String directory : directories) {
+            File file = FileUtilities.fileFromString(directory);
+            if (file.isDirectory()) {
+                result.append(File.pathSeparator).append(directory).append('=').append(file.lastModified());
+            }
+        }
+        return result.toString();
+    }
+    
+    /**
+     * Returns the cached catalog, with fixedWidthFamilies null if the cache doesn't match 'key', or null if there's no usable cache.
+     */
+    private static FontCatalog readCache(String key) {
+        File file = getCacheFile();
+        if (file.exists() == false) {
+            return null;
+        }
+        try {
+            return fromLines(StringUtilities.readLinesFromFile(file), key);
+        } catch (Exception ex) {
+            Log.warn("Problem reading font catalog from \"" + file + "\".", ex);
+            return null;
+        }
+    }
+    
+    // The cache is a version line, a key line, and then one line per family: "M" for fixed-width ("monospaced") or "P" for proportional, a tab, and the family name.
+    private List<String> toLines(String key) {
+        ArrayList<String> result = new ArrayList<String>();
+        result.add(CACHE_VERSION);
+        result.add(key);
+        for (String family : familyNames) {
+            result.add((fixedWidthFamilies.contains(family) ? "M\t" : "P\t") + family);
+        }
+        return result;
+    }
+    
+    private static FontCatalog fromLines(String[] lines, String key) {
+        if (lines.length < 2 || lines[0].equals(CACHE_VERSION) == false) {
+            return null;
+        }
+        boolean isCurrent = lines[1].equals(key);
+        ArrayList<String> familyNames = new ArrayList<String>();
+        Set<String> fixedWidthFamilies = new HashSet<String>();
+        for (int i = 2; i < lines.length; ++i) {
+            String line = lines[i];
+            if (line.length() < 2 || line.charAt(1) != '\t') {
+                return null;
+            }
+            String family = line.substring(2);
+            familyNames.add(family);
+            if (line.charAt(0) == 'M') {
+                fixedWidthFamilies.add(family);
+            }
+        }
+        return new FontCatalog(familyNames, isCurrent ? fixedWidthFamilies : null);
+    }
+    
+    @Test private static void testCacheRoundTrip() {
+        Set<String> fixedWidthFamilies = new HashSet<String>(Arrays.asList("Monaco"));
+        FontCatalog catalog = new FontCatalog(Arrays.asList("Helvetica", "Monaco", "Times New Roman"), fixedWidthFamilies);
+        String[] lines = catalog.toLines("key").toArray(new String[0]);
+        
+        FontCatalog current = fromLines(lines, "key");
+        Assert.equals(current.familyNames, Arrays.asList("Helvetica", "Monaco", "Times New Roman"));
+        Assert.equals(current.fixedWidthFamilies, fixedWidthFamilies);
+        
+        FontCatalog stale = fromLines(lines, "other key");
+        Assert.equals(stale.familyNames, Arrays.asList("Helvetica", "Monaco", "Times New Roman"));
+        Assert.equals(stale.fixedWidthFamilies, null);
+        
+        Assert.equals(fromLines(new String[] { "font-catalog 0", "key" }, "key"), null);
+    }
+}
@@ -208,7 +208,7 @@ public class GuiUtilities {
     private static String monospacedFontName;
     
     private static String findMonospacedFontName() {
-        // Although taking the best available from the ordered list "Monaco", "Lucida Sans Typewriter", "Lucida Console", "Monospaced" would cater for all cases, getAllFonts is expensive.
+        // Although taking the best available from the ordered list "Monaco", "Lucida Sans Typewriter", "Lucida Console", "Monospaced" would cater for all cases, that costs a font catalog lookup per candidate.
         if (GuiUtilities.isMacOs()) {
             // Starting with Mac OS 10.6 the preferred monospaced font is Menlo.
             // If it is available, we are either on 10.6 or it has been installed
@@ -244,13 +244,8 @@ public class GuiUtilities {
     }
     
     private static boolean isFontFamilyAvailable(String fontFamily) {
-        Font[] fonts = GraphicsEnvironment.getLocalGraphicsEnvironment().getAllFonts();
-        for (Font font : fonts) {
-            if (font.getFamily().equals(fontFamily)) {
-                return true;
-            }
-        }
-        return false;
+        // GraphicsEnvironment.getAllFonts is expensive when there are thousands of fonts installed, so ask the cached catalog.
+        return FontCatalog.isFamilyAvailable(fontFamily);
     }
     
     /**
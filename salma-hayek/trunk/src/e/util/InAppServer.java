@@ -1,5 +1,6 @@
 package e.util;
 
+import e.debug.*;
 import java.io.*;
 import java.lang.reflect.*;
 import java.net.*;
@@ -27,6 +28,9 @@ public final class InAppServer {
     private Class<?> exportedInterface;
     private Object handler;
     
+    // Every server also offers profiling commands, for when the application is too busy to use its debug menu.
+    private final SamplingProfiler.Commands profilerCommands = new SamplingProfiler.Commands();
+    
     /**
      * 'handler' can be of any type that implements 'exportedInterface', but
      * only methods declared by the interface (and its superinterfaces) will be
@@ -66,11 +70,13 @@ public final class InAppServer {
         String commandName = split[0];
         
         try {
-            Method[] methods = exportedInterface.getMethods();
-            for (Method method : methods) {
-                if (method.getName().equals(commandName) && method.getReturnType() == void.class) {
-                    return invokeMethod(line, out, method, split);
-                }
+            Method method = findCommand(exportedInterface, commandName);
+            if (method != null) {
+                return invokeMethod(line, out, handler, method, split);
+            }
+            method = findCommand(SamplingProfiler.Commands.class, commandName);
+            if (method != null) {
+                return invokeMethod(line, out, profilerCommands, method, split);
             }
             throw new NoSuchMethodException();
         } catch (NoSuchMethodException nsmex) {
@@ -85,7 +91,17 @@ public final class InAppServer {
         return false;
     }
     
-    private boolean invokeMethod(String line, PrintWriter out, Method method, String[] fields) throws IllegalAccessException, InvocationTargetException {
+    private static Method findCommand(Class<?> commandClass, String commandName) {
+        for (Method method : commandClass.getMethods()) {
+            // Object's methods (notify and wait, say) aren't commands.
+            if (method.getName().equals(commandName) && method.getReturnType() == void.class && method.getDeclaringClass() != Object.class) {
+                return method;
+            }
+        }
+        return null;
+    }
+    
+    private boolean invokeMethod(String line, PrintWriter out, Object target, Method method, String[] fields) throws IllegalAccessException, InvocationTargetException {
         ArrayList<Object> methodArguments = new ArrayList<Object>();
         
         Class<?>[] parameterTypes = method.getParameterTypes();
@@ -105,7 +121,7 @@ public final class InAppServer {
             }
         }
         
-        method.invoke(handler, methodArguments.toArray());
+        method.invoke(target, methodArguments.toArray());
         return true;
     }
     
@@ -4,6 +4,7 @@ import e.forms.*;
 import e.gui.*;
 import java.awt.*;
 import java.awt.event.*;
+import java.io.*;
 import java.util.*;
 import java.util.List;
 import java.util.regex.*;
@@ -54,6 +55,11 @@ public abstract class Preferences extends PreferenceGetter {
     
     private final ArrayList<Listener> listeners = new ArrayList<Listener>();
     
+    // What we last read from or wrote to disk, so we can tell our own writes from other instances', and decode only what another instance changed.
+    private String dataOnDisk;
+    private Map<String, String> settingsOnDisk = new HashMap<String, String>();
+    private FileAlterationMonitor fileAlterationMonitor;
+    
     // Non-null if the preferences dialog is currently showing.
     private FormBuilder form;
     
@@ -278,32 +284,60 @@ public abstract class Preferences extends PreferenceGetter {
             if (FileUtilities.exists(filename) == false) {
                 return;
             }
-            String data = StringUtilities.readFile(getPreferencesFilename());
-            if (data.startsWith("<?xml ")) {
-                processXmlString(data);
-            } else {
-                processResourceLines(data.split("\n"));
-            }
+            String data = StringUtilities.readFile(filename);
+            applySettings(data, parseSettings(data));
         } catch (Exception ex) {
-            Log.warn("Problem reading preferences from \"" + getPreferencesFilename() + "\"", ex);
+            Log.warn("Problem reading preferences from \"" + filename + "\"", ex);
+        } finally {
+            watchForChanges(filename);
+        }
+    }
+    
+    // Notices when another running instance saves its preferences, and picks up the changes.
+    private void watchForChanges(String filename) {
+        if (fileAlterationMonitor != null) {
+            return;
         }
+        fileAlterationMonitor = new FileAlterationMonitor(filename);
+        fileAlterationMonitor.addPathname(filename);
+        fileAlterationMonitor.addListener(new FileAlterationMonitor.Listener() {
+            public void fileTouched(String pathname) {
+                EventQueue.invokeLater(new Runnable() {
+                    public void run() {
+                        reloadFromDisk();
+                    }
+                });
+            }
+        });
     }
     
-    // Process the current XML style of preferences written by writeToDisk.
-    private void processXmlString(String data) throws Exception {
-        org.w3c.dom.Document document = XmlUtilities.readXmlFromString(data);
-        org.w3c.dom.Element root = document.getDocumentElement();
-        for (org.w3c.dom.Node node = root.getFirstChild(); node != null; node = node.getNextSibling()) {
-            if (node.getNodeType() == org.w3c.dom.Node.ELEMENT_NODE) {
-                String key = node.getAttributes().getNamedItem("key").getNodeValue();
-                String value = node.getTextContent();
-                decodePreference(key, value);
+    private void reloadFromDisk() {
+        String filename = getPreferencesFilename();
+        try {
+            String data = FileUtilities.exists(filename) ? StringUtilities.readFile(filename) : "";
+            if (data.equals(dataOnDisk)) {
+                // Most likely our own writeToDisk.
+                return;
             }
+            if (applySettings(data, (data.length() > 0) ? parseSettings(data) : new LinkedHashMap<String, String>())) {
+                firePreferencesChanged();
+            }
+        } catch (Exception ex) {
+            Log.warn("Problem reloading preferences from \"" + filename + "\"", ex);
+        }
+    }
+    
+    private LinkedHashMap<String, String> parseSettings(String data) {
+        if (data.startsWith("<?xml ")) {
+            return PreferencesXml.read(data);
+        } else {
+            return parseResourceLines(data.split("\n"));
         }
     }
     
-    // Process the legacy X11 resources style of preferences (used in old versions of Terminator).
-    private void processResourceLines(String[] lines) {
+    // Parse the legacy X11 resources style of preferences (used in old versions of Terminator).
+    private LinkedHashMap<String, String> parseResourceLines(String[] lines) {
+        LinkedHashMap<String, String> result = new LinkedHashMap<String, String>();
         for (String line : lines) {
             line = line.trim();
             if (line.length() == 0 || line.startsWith("#")) {
@@ -311,29 +345,50 @@ public abstract class Preferences extends PreferenceGetter {
             }
             Matcher matcher = RESOURCE_PATTERN.matcher(line);
             if (matcher.find()) {
-                String key = matcher.group(1);
-                String valueString = matcher.group(2);
-                decodePreference(key, valueString);
+                result.put(matcher.group(1), matcher.group(2));
+            }
+        }
+        return result;
+    }
+    
+    // Decodes only the settings that differ from what we last saw on disk, and reverts any that have been removed to their defaults.
+    // Returns true if anything changed.
+    private boolean applySettings(String data, Map<String, String> settings) {
+        boolean changed = false;
+        for (Map.Entry<String, String> entry : settings.entrySet()) {
+            String key = entry.getKey();
+            String valueString = entry.getValue();
+            if (valueString.equals(settingsOnDisk.get(key)) == false) {
+                changed |= decodePreference(key, valueString);
+            }
+        }
+        for (String key : settingsOnDisk.keySet()) {
+            if (settings.containsKey(key) == false && defaults.containsKey(key)) {
+                preferences.put(key, defaults.get(key));
+                changed = true;
             }
         }
+        dataOnDisk = data;
+        settingsOnDisk = settings;
+        return changed;
     }
     
-    private void decodePreference(String key, String valueString) {
+    private boolean decodePreference(String key, String valueString) {
         PreferencesHelper helper = helperForKey(key);
         if (helper != null) {
             preferences.put(key, helper.decode(valueString));
+            return true;
         } else {
             Log.warn("No PreferencesHelper for key \"" + key + "\" with encoded value \"" + valueString + "\"");
+            return false;
         }
     }
     
     public boolean writeToDisk() {
         String filename = getPreferencesFilename();
         try {
-            org.w3c.dom.Document document = XmlUtilities.makeEmptyDocument();
-            org.w3c.dom.Element root = document.createElement("preferences");
-            document.appendChild(root);
-            
+            PreferencesXml.Writer writer = new PreferencesXml.Writer();
+            LinkedHashMap<String, String> settings = new LinkedHashMap<String, String>();
             for (KeyAndTab keyAndTab : keysInUiOrder) {
                 final String key = keyAndTab.key;
                 if (key == null) {
@@ -342,17 +397,20 @@ public abstract class Preferences extends PreferenceGetter {
                 // Only write out non-default settings.
                 // That way we can change defaults for things the user doesn't care about without having them using fossilized values.
                 if (preferences.get(key).equals(defaults.get(key)) == false) {
-                    String description = descriptions.get(key);
-                    if (description != null) {
-                        root.appendChild(document.createComment(description));
-                    }
-                    org.w3c.dom.Element settingElement = document.createElement("setting");
-                    settingElement.setAttribute("key", key);
-                    settingElement.setTextContent(helperForKey(key).encode(key));
-                    root.appendChild(settingElement);
+                    String valueString = helperForKey(key).encode(key);
+                    writer.addSetting(descriptions.get(key), key, valueString);
+                    settings.put(key, valueString);
                 }
             }
-            XmlUtilities.writeXmlToDisk(filename, document);
+            String data = writer.toString();
+            // Record what we're writing first, so our own change notification is recognized as such.
+            dataOnDisk = data;
+            settingsOnDisk = settings;
+            File file = FileUtilities.fileFromString(filename);
+            if (StringUtilities.writeAtomicallyTo(file, data) == false) {
+                Log.warn("\"" + file + "\" content should have been:\n" + data);
+                return false;
+            }
             return true;
         } catch (Exception ex) {
             Log.warn("Problem writing preferences to \"" + filename + "\"", ex);
@@ -488,12 +546,19 @@ public abstract class Preferences extends PreferenceGetter {
         private JComboBox makeFontNameComboBox(String key) {
             JComboBox fontNameComboBox = new JComboBox();
             // FIXME: filter out unsuitable fonts. "Zapf Dingbats", for example.
-            // FIXME: pull monospaced fonts to the top of the list?
             // FIXME: if the current setting is a monospaced font, only allow other monospaced fonts?
             // FIXME: Windows uses a hard-coded whitelist of suitable monospaced fonts (http://blogs.msdn.com/oldnewthing/archive/2007/05/16/2659903.aspx).
-            for (String name : GraphicsEnvironment.getLocalGraphicsEnvironment().getAvailableFontFamilyNames()) {
+            // Monospaced fonts go at the top of the list, once the font catalog has classified them.
+            List<String> fixedWidthFamilyNames = FontCatalog.getFixedWidthFamilyNames();
+            for (String name : fixedWidthFamilyNames) {
                 fontNameComboBox.addItem(name);
             }
+            HashSet<String> fixedWidthFamilies = new HashSet<String>(fixedWidthFamilyNames);
+            for (String name : FontCatalog.getFamilyNames()) {
+                if (fixedWidthFamilies.contains(name) == false) {
+                    fontNameComboBox.addItem(name);
+                }
+            }
             fontNameComboBox.setSelectedItem(getFont(key).getFamily());
             return fontNameComboBox;
         }
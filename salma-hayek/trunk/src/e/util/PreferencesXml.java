@@ -0,0 +1,384 @@
+package e.util;
+
+import java.util.*;
+import org.jessies.test.*;
+
+/**
+ * Reads and writes the flat XML format used by Preferences without touching JAXP or the DOM.
+ * Loading those classes was a noticeable slice of time-to-first-window, and all we ever have is a root element containing a few dozen "setting" elements.
+ *
+ * The output is byte-for-byte what the JDK's indenting serializer produced when Preferences went via XmlUtilities: no line break after the XML declaration, four-space indentation, and a trailing line separator.
+ * The input side accepts anything that output could have been hand-edited into: comments, processing instructions, character and entity references, and CDATA sections.
+ */
+public final class PreferencesXml {
+    private static final String LINE_SEPARATOR = System.getProperty("line.separator");
+    private static final String XML_DECLARATION = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>";
+    
+    private final String data;
+    private int offset;
+    
+    private PreferencesXml(String data) {
+        this.data = data;
+        this.offset = 0;
+    }
+    
+    /**
+     * Returns the key/value pairs from the "setting" elements of 'data', in file order.
+     * Throws an IllegalArgumentException if 'data' isn't well-formed enough for us to be sure what it means.
+     */
+    public static LinkedHashMap<String, String> read(String data) {
+        return new PreferencesXml(data).readDocument();
+    }
+    
+    /**
+     * Accumulates settings, and produces the XML for them.
+     */
+    public static class Writer {
+        private final StringBuilder body = new StringBuilder();
+        
+        /**
+         * Adds a setting, preceded by a comment if 'description' is non-null.
+         */
+        public void addSetting(String description, String key, String value) {
+            if (description != null) {
+                body.append(LINE_SEPARATOR).append("    <!--").append(description).append("-->");
+            }
+            body.append(LINE_SEPARATOR).append("    <setting key=\"");
+            appendEscaped(body, key, true);
+            if (value.length() == 0) {
+                body.append("\"/>");
+            } else {
+                body.append("\">");
+                appendEscaped(body, value, false);
+                body.append("</setting>");
+            }
+        }
+        
+        @Override public String toString() {
+            if (body.length() == 0) {
+                return XML_DECLARATION + "<preferences/>" + LINE_SEPARATOR;
+            }
+            return XML_DECLARATION + "<preferences>" + body + LINE_SEPARATOR + "</preferences>" + LINE_SEPARATOR;
+        }
+    }
+    
+    // Escapes as the JDK's serializer does.
+    private static void appendEscaped(StringBuilder out, String s, boolean isAttribute) {
+        for (int i = 0; i < s.length(); ++i) {
+            char ch = s.charAt(i);
+            if (ch == '&') {
+                out.append("&amp;");
+            } else if (ch == '<') {
+                out.append("&lt;");
+            } else if (ch == '>') {
+                out.append("&gt;");
+            } else if (ch == '\r') {
+                out.append("&#13;");
+            } else if (isAttribute && ch == '"') {
+                out.append("&quot;");
+            } else if (isAttribute && ch == '\n') {
+                out.append("&#10;");
+            } else if (isAttribute && ch == '\t') {
+                out.append("&#9;");
+            } else if (ch == '\n') {
+                out.append(LINE_SEPARATOR);
+            } else {
+                out.append(ch);
+            }
+        }
+    }
+    
+    private LinkedHashMap<String, String> readDocument() {
+        LinkedHashMap<String, String> result = new LinkedHashMap<String, String>();
+        if (data.startsWith("\uFEFF")) {
+            ++offset;
+        }
+        skipMisc();
+        if (data.startsWith("<!DOCTYPE", offset)) {
+            skipPast(">");
+            skipMisc();
+        }
+        String rootName = readStartTag(null);
+        if (isEmptyElement()) {
+            return result;
+        }
+        while (true) {
+            skipMisc();
+            if (data.startsWith("</", offset)) {
+                readEndTag(rootName);
+                break;
+            } else if (offset == data.length()) {
+                throw error("missing </" + rootName + ">");
+            } else if (data.startsWith("<", offset)) {
+                HashMap<String, String> attributes = new HashMap<String, String>();
+                String name = readStartTag(attributes);
+                String key = attributes.get("key");
+                if (key == null) {
+                    throw error("<" + name + "> without a key");
+                }
+                result.put(key, isEmptyElement() ? "" : readContent(name));
+            } else {
+                // Like the DOM-based code this replaced, we ignore stray text between settings.
+                readText();
+            }
+        }
+        skipMisc();
+        if (offset != data.length()) {
+            throw error("content after the root element");
+        }
+        return result;
+    }
+    
+    // Skips whitespace, comments, and processing instructions (including the XML declaration).
+    private void skipMisc() {
+        while (true) {
+            skipWhitespace();
+            if (data.startsWith("<!--", offset)) {
+                skipPast("-->");
+            } else if (data.startsWith("<?", offset)) {
+                skipPast("?>");
+            } else {
+                return;
+            }
+        }
+    }
+    
+    private void skipWhitespace() {
+        while (offset < data.length() && isWhitespace(data.charAt(offset))) {
+            ++offset;
+        }
+    }
+    
+    private static boolean isWhitespace(char ch) {
+        return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+    }
+    
+    private void skipPast(String terminator) {
+        int end = data.indexOf(terminator, offset);
+        if (end == -1) {
+            throw error("missing \"" + terminator + "\"");
+        }
+        offset = end + terminator.length();
+    }
+    
+    // Reads "<name attr='value' ...", leaving us before the "/>" or ">".
+    private String readStartTag(Map<String, String> attributes) {
+        expect("<");
+        String name = readName();
+        while (true) {
+            skipWhitespace();
+            if (data.startsWith("/>", offset) || data.startsWith(">", offset)) {
+                return name;
+            }
+            String attributeName = readName();
+            skipWhitespace();
+            expect("=");
+            skipWhitespace();
+            if (offset == data.length()) {
+                throw error("missing attribute value");
+            }
+            char quote = data.charAt(offset);
+            if (quote != '"' && quote != '\'') {
+                throw error("unquoted attribute value");
+            }
+            ++offset;
+            int end = data.indexOf(quote, offset);
+            if (end == -1) {
+                throw error("unterminated attribute value");
+            }
+            String value = decode(data.substring(offset, end), true);
+            offset = end + 1;
+            if (attributes != null) {
+                attributes.put(attributeName, value);
+            }
+        }
+    }
+    
+    // Consumes the end of a start tag, returning true if it was "/>".
+    private boolean isEmptyElement() {
+        if (data.startsWith("/>", offset)) {
+            offset += 2;
+            return true;
+        }
+        expect(">");
+        return false;
+    }
+    
+    private void readEndTag(String name) {
+        expect("</");
+        if (readName().equals(name) == false) {
+            throw error("mismatched end tag; expected </" + name + ">");
+        }
+        skipWhitespace();
+        expect(">");
+    }
+    
+    // Reads the text content of an element up to and including its end tag, as Node.getTextContent would (ignoring comments).
+    private String readContent(String name) {
+        StringBuilder result = new StringBuilder();
+        while (true) {
+            if (data.startsWith("</", offset)) {
+                readEndTag(name);
+                return result.toString();
+            } else if (data.startsWith("<!--", offset)) {
+                skipPast("-->");
+            } else if (data.startsWith("<?", offset)) {
+                skipPast("?>");
+            } else if (data.startsWith("<![CDATA[", offset)) {
+                int start = offset + "<![CDATA[".length();
+                skipPast("]]>");
+                result.append(normalizeNewlines(data.substring(start, offset - "]]>".length())));
+            } else if (data.startsWith("<", offset)) {
+                throw error("unexpected element inside <" + name + ">");
+            } else if (offset == data.length()) {
+                throw error("missing </" + name + ">");
+            } else {
+                result.append(readText());
+            }
+        }
+    }
+    
+    private String readText() {
+        int end = data.indexOf('<', offset);
+        if (end == -1) {
+            end = data.length();
+        }
+        String text = decode(data.substring(offset, end), false);
+        offset = end;
+        return text;
+    }
+    
+    private String readName() {
+        int start = offset;
+        while (offset < data.length()) {
+            char ch = data.charAt(offset);
+            if (isWhitespace(ch) || ch == '/' || ch == '>' || ch == '=' || ch == '<') {
+                break;
+            }
+            ++offset;
+        }
+        if (offset == start) {
+            throw error("missing name");
+        }
+        return data.substring(start, offset);
+    }
+    
+    private void expect(String s) {
+        if (data.startsWith(s, offset) == false) {
+            throw error("expected \"" + s + "\"");
+        }
+        offset += s.length();
+    }
+    
+    private static String normalizeNewlines(String s) {
+        return (s.indexOf('\r') == -1) ? s : s.replace("\r\n", "\n").replace('\r', '\n');
+    }
+    
+    // Expands references and normalizes line ends (and, in attributes, all whitespace) as an XML parser would.
+    private String decode(String s, boolean isAttribute) {
+        s = normalizeNewlines(s);
+        if (isAttribute) {
+            s = s.replace('\n', ' ').replace('\t', ' ');
+        }
+        if (s.indexOf('&') == -1) {
+            return s;
+        }
+        StringBuilder result = new StringBuilder(s.length());
+        for (int i = 0; i < s.length(); ++i) {
+            char ch = s.charAt(i);
+            if (ch != '&') {
+                result.append(ch);
+                continue;
+            }
+            int semicolon = s.indexOf(';', i);
+            if (semicolon == -1) {
+                throw error("unterminated reference");
+            }
+            String reference = s.substring(i + 1, semicolon);
+            if (reference.equals("amp")) {
+                result.append('&');
+            } else if (reference.equals("lt")) {
+                result.append('<');
+            } else if (reference.equals("gt")) {
+                result.append('>');
+            } else if (reference.equals("quot")) {
+                result.append('"');
+            } else if (reference.equals("apos")) {
+                result.append('\'');
+            } else if (reference.startsWith("#")) {
+                try {
+                    boolean isHex = reference.startsWith("#x");
+                    int codePoint = Integer.parseInt(reference.substring(isHex ? 2 : 1), isHex ? 16 : 10);
+                    result.appendCodePoint(codePoint);
+                } catch (IllegalArgumentException ex) {
+                    throw error("bad character reference \"&" + reference + ";\"");
+                }
+            } else {
+                throw error("unknown entity \"&" + reference + ";\"");
+            }
+            i = semicolon;
+        }
+        return result.toString();
+    }
+    
+    private IllegalArgumentException error(String message) {
+        return new IllegalArgumentException(message + " at offset " + offset);
+    }
+    
+    @Test private static void testWrite() {
+        Assert.equals(new Writer().toString(), XML_DECLARATION + "<preferences/>" + LINE_SEPARATOR);
+        
+        Writer writer = new Writer();
+        writer.addSetting("Font", "font", "Monospaced-PLAIN-12");
+        writer.addSetting(null, "empty", "");
+        writer.addSetting(null, "escaped", "a < b && c > \"d\"");
+        String expected = XML_DECLARATION + "<preferences>" + LINE_SEPARATOR +
+            "    <!--Font-->" + LINE_SEPARATOR +
+            "    <setting key=\"font\">Monospaced-PLAIN-12</setting>" + LINE_SEPARATOR +
+            "    <setting key=\"empty\"/>" + LINE_SEPARATOR +
+            "    <setting key=\"escaped\">a &lt; b &amp;&amp; c &gt; \"d\"</setting>" + LINE_SEPARATOR +
+            "</preferences>" + LINE_SEPARATOR;
+        Assert.equals(writer.toString(), expected);
+    }
+    
+    @Test private static void testRoundTrip() {
+        Writer writer = new Writer();
+        writer.addSetting("Font", "font", "Monospaced-PLAIN-12");
+        writer.addSetting(null, "empty", "");
+        writer.addSetting("Things", "escaped", "a < b && c > \"d\"\nline two");
+        LinkedHashMap<String, String> settings = read(writer.toString());
+        Assert.equals(new ArrayList<String>(settings.keySet()), Arrays.asList("font", "empty", "escaped"));
+        Assert.equals(settings.get("font"), "Monospaced-PLAIN-12");
+        Assert.equals(settings.get("empty"), "");
+        Assert.equals(settings.get("escaped"), "a < b && c > \"d\"\nline two");
+    }
+    
+    @Test private static void testRead() {
+        String data = "<?xml version=\"1.0\"?>\r\n<!-- hand-edited -->\n<preferences>\n  <setting key='a'>x&#65;&#x42;<![CDATA[<&>]]><!-- ignored --></setting>\n  <setting key=\"b\" ></setting >\n</preferences>\n";
+        LinkedHashMap<String, String> settings = read(data);
+        Assert.equals(settings.get("a"), "xAB<&>");
+        Assert.equals(settings.get("b"), "");
+        
+        Assert.equals(read("<preferences/>").size(), 0);
+    }
+    
+    @Test private static void testReadErrors() {
+        String[] bad = new String[] {
+            "",
+            "<preferences>",
+            "<preferences><setting>x</setting></preferences>",
+            "<preferences><setting key=\"a\">x</preferences>",
+            "<preferences><setting key=\"a\">&nbsp;</setting></preferences>",
+            "<preferences><setting key=\"a\"><b/></setting></preferences>",
+            "<preferences/><preferences/>",
+        };
+        for (String data : bad) {
+            try {
+                read(data);
+                Assert.failure("expected IllegalArgumentException for \"" + data + "\"");
+            } catch (IllegalArgumentException ex) {
+                // Expected.
+            }
+        }
+    }
+}
@@ -3,6 +3,7 @@ package e.util;
 import java.io.*;
 import java.lang.reflect.*;
 import java.util.*;
+import java.util.concurrent.*;
 import java.util.regex.*;
 import org.jessies.os.*;
 
@@ -102,7 +103,7 @@ public class ProcessUtilities {
             if (processListener != null) {
                 processListener.processStarted(p);
             }
-            Thread inputWriterThread = new Thread(new Runnable() {
+            Future<?> inputWriter = WorkScheduler.submit(WorkScheduler.Priority.BULK_IO, "Process Input", new Runnable() {
                 public void run() {
                     try {
                         BufferedWriter out = new BufferedWriter(new OutputStreamWriter(p.getOutputStream(), "UTF-8"));
@@ -113,17 +114,15 @@ public class ProcessUtilities {
                         feedExceptionToLineListener(errorLineListener, ex);
                     }
                 }
-            }, "Process Input: " + shellQuotedFormOf(command));
-            inputWriterThread.start();
-            Thread errorReaderThread = new Thread(new Runnable() {
+            });
+            Future<?> errorReader = WorkScheduler.submit(WorkScheduler.Priority.BULK_IO, "Process Back-Quote", new Runnable() {
                 public void run() {
                     readLinesFromStream(errorLineListener, p.getErrorStream());
                 }
-            }, "Process Back-Quote: " + shellQuotedFormOf(command));
-            errorReaderThread.start();
+            });
             readLinesFromStream(outputLineListener, p.getInputStream());
-            inputWriterThread.join();
-            errorReaderThread.join();
+            inputWriter.get();
+            errorReader.get();
             status = p.waitFor();
         } catch (Exception ex) {
             feedExceptionToLineListener(errorLineListener, ex);
@@ -176,7 +175,7 @@ public class ProcessUtilities {
                 listener.processStarted(p);
             }
             result = p;
-            new Thread("Process Spawn: " + quotedCommand) {
+            WorkScheduler.submit(WorkScheduler.Priority.BULK_IO, "Process Spawn", new Runnable() {
                 public void run() {
                     try {
                         p.getOutputStream().close();
@@ -190,7 +189,7 @@ public class ProcessUtilities {
                         Log.warn("Problem waiting for command to finish: " + quotedCommand, ex);
                     }
                 }
-            }.start();
+            });
         } catch (Exception ex) {
             Log.warn("Failed to spawn command: " + quotedCommand, ex);
         }
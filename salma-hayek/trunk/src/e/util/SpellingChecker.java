@@ -14,16 +14,16 @@ public class SpellingChecker {
     
     private static final Stopwatch stopwatch = Stopwatch.get("SpellingChecker");
     
-    private static WordCache wordCache = new WordCache();
-    
     /**
-     * Caches whether or not the last MAX_ENTRIES words were spelled correctly or incorrectly.
+     * Caches whether or not the MAX_ENTRIES most recently used words were spelled correctly or incorrectly.
+     * The answers depend on the back end's dictionary, so each SpellingChecker has its own.
+     * Whole-buffer checks of large files see tens of thousands of distinct words, and re-checking after an edit should find almost all of them here.
      */
     private static class WordCache extends LinkedHashMap<String, Boolean> {
-        private static final int MAX_ENTRIES = 4096;
+        private static final int MAX_ENTRIES = 65536;
         
         public WordCache() {
-            super(MAX_ENTRIES);
+            super(1024, 0.75f, true);
         }
         
         @Override protected boolean removeEldestEntry(Map.Entry<String, Boolean> eldest) {
@@ -31,6 +31,8 @@ public class SpellingChecker {
         }
     }
     
+    private final WordCache wordCache = new WordCache();
+    
     private Process ispell;
     private PrintWriter out;
     private BufferedReader in;
@@ -1,21 +1,66 @@
 package e.util;
 
+import java.io.*;
+import java.nio.channels.*;
 import java.util.*;
 import java.util.concurrent.*;
 import java.util.regex.*;
+import org.jessies.test.*;
 
 /**
  * A duplicate-free list of strings, optionally persisted to disk.
  * Strings at low-numbered indexes are older than those at high-numbered indexes.
  * FIXME: we should put some bound on the amount of history we're prepared to keep.
- * 
+ *
+ * On disk, the history is a journal: each line records an addition, or (if it starts with REMOVAL_MARKER) a removal.
+ * A journal without removals is just the history, oldest first, which is the format we used to write.
+ * Changes are appended, so several processes (Evergreen and Terminator, say) can share a file; each picks up the others' changes whenever it writes its own.
+ * Once the journal has grown to several times the size of the history, whoever notices rewrites it as a plain list.
+ * A rewritten journal starts with a unique header line, so the other processes know to read it again from the start.
+ *
  * @author Phil Norman
  */
 public class StringHistory {
     private static final ExecutorService executor = ThreadUtilities.newSingleThreadExecutor("StringHistory Writer");
     
-    private String filename;
-    private ArrayList<String> history;
+    // Held while reading or writing any journal, so no two histories in this VM try to lock the same file at once (which would be an OverlappingFileLockException).
+    // We never hold this and then wait for a history's monitor for long, and never hold a history's monitor while doing I/O, so the EDT doesn't wait for the disk or for another process.
+    private static final Object journalLock = new Object();
+    
+    // A character that can't usefully start a string someone would want to remember.
+    private static final char REMOVAL_MARKER = '\u007f';
+    
+    // We compact the journal when it has more than this many lines per remembered string (plus a little slack, so tiny histories aren't rewritten all the time).
+    private static final int MAX_JOURNAL_LINES_PER_STRING = 3;
+    private static final int JOURNAL_SLACK = 64;
+    
+    private final String filename;
+    
+    // The strings, oldest first, with null wherever a string has been removed since we last packed the list.
+    private ArrayList<String> history = new ArrayList<String>();
+    // Maps each string to its index in 'history'.
+    private HashMap<String, Integer> indexes = new HashMap<String, Integer>();
+    private int removedCount = 0;
+    // Incremented on every change, so getStringsMatching knows when its cache is stale.
+    private int modificationCount = 0;
+    
+    // Journal lines we've yet to write, whether the journal should be emptied first, and whether a write is scheduled to do so.
+    private ArrayList<String> unwrittenLines = new ArrayList<String>();
+    private boolean isTruncationPending = false;
+    private boolean isWriteScheduled = false;
+    // Incremented by clear, so a write that was in progress at the time knows to discard what it read and wrote.
+    private int clearCount = 0;
+    
+    // Guarded by journalLock: how much of the file we've read, and how many lines that was.
+    private long journalLength = 0;
+    private int journalLineCount = 0;
+    // Guarded by journalLock: the header line of the journal we've read, or null if it didn't have one.
+    private String journalHeader = null;
+    
+    // The most recent getStringsMatching query, so that typing one more character of a literal search needn't look at the whole history.
+    private String lastRegularExpression;
+    private int lastModificationCount;
+    private List<String> lastMatches;
     
     /**
      * Creates a new empty history that will not be written to disk.
@@ -29,41 +74,48 @@ public class StringHistory {
      */
     public StringHistory(String filename) {
         this.filename = filename;
-        this.history = new ArrayList<String>();
         readHistoryFile();
     }
     
-    public int size() {
-        return history.size();
+    public synchronized int size() {
+        return history.size() - removedCount;
     }
     
     public int getLatestHistoryIndex() {
         return size() - 1;
     }
     
-    public String get(int index) {
+    public synchronized String get(int index) {
+        packHistory();
         return history.get(index);
     }
     
-    public void add(String string) {
+    public synchronized void add(String string) {
         if (string.length() == 0) {
             return;
         }
         // Avoid duplicates by removing any old entry first.
-        history.remove(string);
-        history.add(string);
-        writeHistoryFile();
+        applyRemove(string);
+        applyAdd(string);
+        writeJournalLine(string);
     }
     
-    public void remove(String string) {
-        history.remove(string);
-        writeHistoryFile();
+    public synchronized void remove(String string) {
+        if (applyRemove(string)) {
+            writeJournalLine(REMOVAL_MARKER + string);
+        }
     }
     
-    public void clear() {
+    public synchronized void clear() {
         history = new ArrayList<String>();
+        indexes = new HashMap<String, Integer>();
+        removedCount = 0;
+        ++modificationCount;
+        ++clearCount;
+        unwrittenLines.clear();
         if (filename != null) {
-            FileUtilities.fileFromString(filename).delete();
+            isTruncationPending = true;
+            scheduleWrite();
         }
     }
     
@@ -72,44 +124,413 @@ public class StringHistory {
      * The strings are returned oldest first.
      * It's easy for a caller to sort the result, but it wouldn't be easy for the caller to infer the chronological ordering.
      */
-    public List<String> getStringsMatching(String regularExpression) {
+    public synchronized List<String> getStringsMatching(String regularExpression) {
+        List<String> candidates;
+        if (lastMatches != null && lastModificationCount == modificationCount && regularExpression.equals(lastRegularExpression)) {
+            return new ArrayList<String>(lastMatches);
+        } else if (lastMatches != null && lastModificationCount == modificationCount && isRefinementOf(regularExpression, lastRegularExpression)) {
+            candidates = lastMatches;
+        } else {
+            packHistory();
+            candidates = history;
+        }
         Pattern pattern = PatternUtilities.smartCaseCompile(regularExpression);
         ArrayList<String> result = new ArrayList<String>();
-        for (String candidate : history) {
+        for (String candidate : candidates) {
             Matcher matcher = pattern.matcher(candidate);
             if (matcher.find()) {
                 result.add(candidate);
             }
         }
-        return result;
+        lastRegularExpression = regularExpression;
+        lastModificationCount = modificationCount;
+        lastMatches = result;
+        return new ArrayList<String>(result);
+    }
+    
+    /**
+     * Tests whether everything matching 'regularExpression' is sure to match 'previous' too.
+     * We only recognize the common case of someone typing a literal string one character at a time.
+     * Smart case doesn't spoil this: adding characters can only make the search case-sensitive, not insensitive.
+     */
+    private static boolean isRefinementOf(String regularExpression, String previous) {
+        return previous != null && regularExpression.startsWith(previous) && isLiteral(regularExpression);
+    }
+    
+    private static boolean isLiteral(String regularExpression) {
+        for (int i = 0; i < regularExpression.length(); ++i) {
+            if ("\\^$.|?*+()[]{}".indexOf(regularExpression.charAt(i)) != -1) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    private void applyAdd(String string) {
+        indexes.put(string, history.size());
+        history.add(string);
+        ++modificationCount;
+    }
+    
+    private boolean applyRemove(String string) {
+        Integer index = indexes.remove(string);
+        if (index == null) {
+            return false;
+        }
+        history.set(index, null);
+        ++removedCount;
+        ++modificationCount;
+        return true;
+    }
+    
+    private void applyJournalLine(String line) {
+        if (isHeader(line)) {
+            return;
+        } else if (line.length() > 0 && line.charAt(0) == REMOVAL_MARKER) {
+            applyRemove(line.substring(1));
+        } else if (line.length() > 0) {
+            applyRemove(line);
+            applyAdd(line);
+        }
+    }
+    
+    /**
+     * Squeezes out the holes left by removals, so that indexes mean what our callers expect.
+     */
+    private void packHistory() {
+        if (removedCount == 0) {
+            return;
+        }
+        ArrayList<String> packed = new ArrayList<String>(history.size() - removedCount);
+        indexes.clear();
+        for (String string : history) {
+            if (string != null) {
+                indexes.put(string, packed.size());
+                packed.add(string);
+            }
+        }
+        history = packed;
+        removedCount = 0;
     }
     
+    /**
+     * Reads the history on disk when we're created.
+     * We don't take the file lock, because we're probably on the EDT and another process might hold it for a while.
+     * A partial line (or a journal half way through being compacted) is harmless: the next write reads the file again, under the lock, and notices.
+     */
     private void readHistoryFile() {
+        if (filename == null) {
+            return;
+        }
+        File file = FileUtilities.fileFromString(filename);
+        if (file.exists() == false) {
+            return;
+        }
+        // Nobody else can see us yet, so we needn't take journalLock to touch the journal fields.
         try {
-            if (filename != null && FileUtilities.exists(filename)) {
-                for (String line : StringUtilities.readLinesFromFile(filename)) {
-                    history.add(line);
-                }
+            RandomAccessFile journal = new RandomAccessFile(file, "r");
+            try {
+                mergeJournalChanges(readJournalFrom(journal), Collections.<String>emptyList(), clearCount);
+            } finally {
+                journal.close();
             }
         } catch (Exception ex) {
             Log.warn("Error reading history from file \"" + filename + "\".", ex);
         }
     }
     
-    private void writeHistoryFile() {
+    private void writeJournalLine(String line) {
         if (filename == null) {
             return;
         }
-        
-        // Make sure that we don't write to disk off the EDT.
-        // FIXME: this relies on the calling code not calling us too frequently; a timer might be a better idea.
+        unwrittenLines.add(line);
+        scheduleWrite();
+    }
+    
+    // Callers must hold our monitor.
+    private void scheduleWrite() {
+        if (isWriteScheduled) {
+            // The scheduled write will take this change with it.
+            return;
+        }
+        isWriteScheduled = true;
+        // Make sure that we don't write to disk on the EDT.
         executor.execute(new Runnable() {
             public void run() {
-                String error = StringUtilities.writeFile(FileUtilities.fileFromString(filename), history);
-                if (error != null) {
-                    Log.warn("Failed to write history to file \"" + filename + "\" (" + error + ").");
+                boolean succeeded = false;
+                try {
+                    synchronizeWithJournal();
+                    succeeded = true;
+                } catch (Exception ex) {
+                    Log.warn("Failed to write history to file \"" + filename + "\".", ex);
+                } finally {
+                    synchronized (StringHistory.this) {
+                        isWriteScheduled = false;
+                        // Pick up anything that changed while we were writing.
+                        // After a failure, we leave it for the next change to retry, rather than spinning on a full disk.
+                        if (succeeded && (unwrittenLines.isEmpty() == false || isTruncationPending)) {
+                            scheduleWrite();
+                        }
+                    }
                 }
             }
         });
     }
+    
+    /**
+     * Reads any changes other processes have appended to the journal since we last looked, then appends our own.
+     * We hold an exclusive lock on the file throughout, so nobody can append between our reading and our writing.
+     * Our monitor is only held while we update the in-memory history, never during I/O.
+     */
+    void synchronizeWithJournal() throws IOException {
+        synchronized (journalLock) {
+            List<String> pendingLines;
+            boolean truncate;
+            int expectedClearCount;
+            synchronized (this) {
+                pendingLines = unwrittenLines;
+                unwrittenLines = new ArrayList<String>();
+                truncate = isTruncationPending;
+                isTruncationPending = false;
+                expectedClearCount = clearCount;
+            }
+            boolean succeeded = false;
+            try {
+                synchronizeWithJournal(pendingLines, truncate, expectedClearCount);
+                succeeded = true;
+            } finally {
+                if (succeeded == false) {
+                    synchronized (this) {
+                        // Put our changes back for next time, unless they've since been cleared away.
+                        if (clearCount == expectedClearCount) {
+                            unwrittenLines.addAll(0, pendingLines);
+                            isTruncationPending |= truncate;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    // Callers must hold journalLock.
+    private void synchronizeWithJournal(List<String> pendingLines, boolean truncate, int expectedClearCount) throws IOException {
+        if (truncate) {
+            journalLength = 0;
+            journalLineCount = 0;
+            journalHeader = null;
+        }
+        File file = FileUtilities.fileFromString(filename);
+        if (file.exists() == false && pendingLines.isEmpty()) {
+            return;
+        }
+        RandomAccessFile journal = new RandomAccessFile(file, "rw");
+        try {
+            FileLock lock = journal.getChannel().lock();
+            try {
+                if (truncate) {
+                    journal.setLength(0);
+                }
+                JournalChanges changes = readJournalFrom(journal);
+                List<String> compactedHistory = null;
+                synchronized (this) {
+                    if (mergeJournalChanges(changes, pendingLines, expectedClearCount) == false) {
+                        // We were cleared while reading; our pending lines went with everything else, and the next write will empty the journal.
+                        return;
+                    }
+                    // An emptied journal gets a new header like a compacted one, or a process that has read further into the old journal than there now is would resume mid-line and never notice the clear.
+                    if (truncate || journalLineCount + pendingLines.size() > MAX_JOURNAL_LINES_PER_STRING * size() + JOURNAL_SLACK) {
+                        packHistory();
+                        compactedHistory = new ArrayList<String>(history);
+                    }
+                }
+                if (compactedHistory != null) {
+                    compactJournal(journal, compactedHistory);
+                } else if (pendingLines.isEmpty() == false) {
+                    appendToJournal(journal, pendingLines);
+                }
+            } finally {
+                lock.release();
+            }
+        } finally {
+            journal.close();
+        }
+    }
+    
+    /**
+     * What readJournalFrom found: whether the journal was rewritten since we last read it, and any lines added since.
+     */
+    private static class JournalChanges {
+        boolean isRestart = false;
+        ArrayList<String> lines = new ArrayList<String>();
+    }
+    
+    /**
+     * Applies what we read from the journal to the in-memory history, and then our own changes on top.
+     * Returns false, having done nothing, if we've been cleared since 'expectedClearCount'.
+     * Callers must hold our monitor.
+     */
+    private boolean mergeJournalChanges(JournalChanges changes, List<String> pendingLines, int expectedClearCount) {
+        if (clearCount != expectedClearCount) {
+            return false;
+        }
+        if (changes.isRestart) {
+            // Someone compacted the journal. Their copy includes everything we'd read, so start again.
+            history = new ArrayList<String>();
+            indexes = new HashMap<String, Integer>();
+            removedCount = 0;
+            ++modificationCount;
+        }
+        for (String line : changes.lines) {
+            applyJournalLine(line);
+        }
+        // Anything we've changed since we last wrote goes on top of what others have done meanwhile.
+        // Our unwritten lines are already reflected in our in-memory history, but may have been undone by the above.
+        for (String line : pendingLines) {
+            applyJournalLine(line);
+        }
+        for (String line : unwrittenLines) {
+            applyJournalLine(line);
+        }
+        return true;
+    }
+    
+    private static boolean isHeader(String line) {
+        return line.length() >= 2 && line.charAt(0) == REMOVAL_MARKER && line.charAt(1) == REMOVAL_MARKER;
+    }
+    
+    private static String readHeader(RandomAccessFile journal) throws IOException {
+        journal.seek(0);
+        String firstLine = journal.readLine();
+        // readLine treats bytes as ISO-8859-1, but the header is ASCII, and anything else isn't a header.
+        return (firstLine != null && isHeader(firstLine)) ? firstLine : null;
+    }
+    
+    // Callers must hold journalLock (or be the constructor).
+    private JournalChanges readJournalFrom(RandomAccessFile journal) throws IOException {
+        JournalChanges changes = new JournalChanges();
+        long length = journal.length();
+        String header = readHeader(journal);
+        if (length < journalLength || (header == null ? journalHeader != null : header.equals(journalHeader) == false)) {
+            changes.isRestart = true;
+            journalLength = 0;
+            journalLineCount = 0;
+        }
+        journalHeader = header;
+        if (length == journalLength) {
+            return changes;
+        }
+        byte[] bytes = new byte[(int) (length - journalLength)];
+        journal.seek(journalLength);
+        journal.readFully(bytes);
+        // Only consume complete lines. The lock means a partial line can only be left by a crash.
+        int end = bytes.length;
+        while (end > 0 && bytes[end - 1] != '\n') {
+            --end;
+        }
+        String text = new String(bytes, 0, end, "UTF-8");
+        int lineStart = 0;
+        for (int newline = text.indexOf('\n'); newline != -1; newline = text.indexOf('\n', lineStart)) {
+            changes.lines.add(text.substring(lineStart, newline));
+            ++journalLineCount;
+            lineStart = newline + 1;
+        }
+        journalLength += end;
+        return changes;
+    }
+    
+    // Callers must hold journalLock.
+    private void appendToJournal(RandomAccessFile journal, List<String> lines) throws IOException {
+        StringBuilder text = new StringBuilder();
+        for (String line : lines) {
+            text.append(line).append('\n');
+        }
+        byte[] bytes = text.toString().getBytes("UTF-8");
+        journal.seek(journalLength);
+        journal.write(bytes);
+        journalLength += bytes.length;
+        journalLineCount += lines.size();
+    }
+    
+    // Callers must hold journalLock.
+    private void compactJournal(RandomAccessFile journal, List<String> strings) throws IOException {
+        journalHeader = "" + REMOVAL_MARKER + REMOVAL_MARKER + UUID.randomUUID();
+        StringBuilder text = new StringBuilder();
+        text.append(journalHeader).append('\n');
+        for (String string : strings) {
+            text.append(string).append('\n');
+        }
+        byte[] bytes = text.toString().getBytes("UTF-8");
+        journal.setLength(0);
+        journal.seek(0);
+        journal.write(bytes);
+        journalLength = bytes.length;
+        journalLineCount = strings.size();
+    }
+    
+    @Test private static void testAddAndRemove() {
+        StringHistory history = new StringHistory();
+        history.add("a");
+        history.add("b");
+        history.add("c");
+        history.add("a");
+        history.add("");
+        Assert.equals(history.size(), 3);
+        Assert.equals(history.get(0), "b");
+        Assert.equals(history.get(2), "a");
+        history.remove("c");
+        history.remove("nonexistent");
+        Assert.equals(history.size(), 2);
+        Assert.equals(history.get(0), "b");
+        Assert.equals(history.get(1), "a");
+    }
+    
+    @Test private static void testGetStringsMatching() {
+        StringHistory history = new StringHistory();
+        history.add("hello");
+        history.add("help");
+        history.add("world");
+        Assert.equals(history.getStringsMatching("hel"), Arrays.asList("hello", "help"));
+        Assert.equals(history.getStringsMatching("hell"), Arrays.asList("hello"));
+        Assert.equals(history.getStringsMatching("hell|wor"), Arrays.asList("hello", "world"));
+        history.add("hellish");
+        Assert.equals(history.getStringsMatching("hell"), Arrays.asList("hello", "hellish"));
+        Assert.equals(history.getStringsMatching("HELL"), Arrays.<String>asList());
+    }
+    
+    @Test private static void testSharedJournal() throws IOException {
+        File file = FileUtilities.createTemporaryFile("StringHistory", ".txt", "history file", "old\n");
+        StringHistory first = new StringHistory(file.toString());
+        StringHistory second = new StringHistory(file.toString());
+        first.add("one");
+        first.synchronizeWithJournal();
+        second.add("two");
+        second.remove("old");
+        second.synchronizeWithJournal();
+        first.synchronizeWithJournal();
+        Assert.equals(first.size(), 2);
+        Assert.equals(first.get(0), "one");
+        Assert.equals(first.get(1), "two");
+        Assert.equals(new StringHistory(file.toString()).getStringsMatching(""), Arrays.asList("one", "two"));
+        
+        // Churn until the journal gets compacted, and check the other process copes.
+        for (int i = 0; i < 200; ++i) {
+            first.add(i % 2 == 0 ? "one" : "two");
+            first.synchronizeWithJournal();
+        }
+        Assert.equals(StringUtilities.readLinesFromFile(file).length < 200, true);
+        second.add("three");
+        second.synchronizeWithJournal();
+        Assert.equals(second.getStringsMatching(""), Arrays.asList("one", "two", "three"));
+    }
+    
+    @Test private static void testClearIsSeenByOthers() throws IOException {
+        File file = FileUtilities.createTemporaryFile("StringHistory", ".txt", "history file", "old\n");
+        StringHistory first = new StringHistory(file.toString());
+        StringHistory second = new StringHistory(file.toString());
+        second.clear();
+        second.add("a string longer than the original journal");
+        second.synchronizeWithJournal();
+        first.synchronizeWithJournal();
+        Assert.equals(first.getStringsMatching(""), Arrays.asList("a string longer than the original journal"));
+    }
 }
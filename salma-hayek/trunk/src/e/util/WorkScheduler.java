@@ -0,0 +1,267 @@
+package e.util;
+
+import java.util.*;
+import java.util.concurrent.*;
+import java.util.concurrent.atomic.*;
+
+/**
+ * A process-wide scheduler for background work, so that the various parts of an application share a bounded set of worker threads instead of each creating its own pool.
+ *
+ * Work is submitted with a priority class:
+ *
+ *   INTERACTIVE work is something the user is waiting for right now;
+ *   BACKGROUND work is CPU-bound work the user will want eventually;
+ *   BULK_IO work spends most of its time blocked (on a pipe, a pty, or a child process).
+ *
+ * INTERACTIVE and BACKGROUND work share one pool with a thread per processor, with INTERACTIVE work always dequeued first.
+ * BULK_IO work runs on an elastic pool because blocking tasks would otherwise starve the bounded pool; its threads are reused and reaped when idle.
+ *
+ * Use a Batch when you need to wait for a group of tasks, and a SerialExecutor when tasks must run one at a time in submission order.
+ * Each task's run time is recorded in a Stopwatch named after the task, so "Show Stopwatches" in the debug menu reports where the time went.
+ */
+public final class WorkScheduler {
+    public enum Priority {
+        INTERACTIVE, BACKGROUND, BULK_IO
+    }
+    
+    private static final AtomicLong nextSequenceNumber = new AtomicLong(0);
+    
+    private static final ThreadPoolExecutor computeExecutor;
+    private static final ThreadPoolExecutor blockingExecutor;
+    static {
+        final int processorCount = Runtime.getRuntime().availableProcessors();
+        computeExecutor = new ThreadPoolExecutor(processorCount, processorCount, 30, TimeUnit.SECONDS, new PriorityBlockingQueue<Runnable>(), new WorkerThreadFactory("Work Scheduler"));
+        computeExecutor.allowCoreThreadTimeOut(true);
+        blockingExecutor = new ThreadPoolExecutor(0, Integer.MAX_VALUE, 30, TimeUnit.SECONDS, new SynchronousQueue<Runnable>(), new WorkerThreadFactory("Work Scheduler I/O"));
+    }
+    
+    private WorkScheduler() {
+    }
+    
+    /**
+     * Schedules 'callable' to run with the given priority.
+     * 'name' is used to name the worker thread while the task runs and to label its timing statistics, so it should be a constant rather than include per-task details.
+     */
+    public static <T> Future<T> submit(Priority priority, String name, Callable<T> callable) {
+        Task<T> task = new Task<T>(priority, name, callable);
+        schedule(task);
+        return task;
+    }
+    
+    /**
+     * Schedules 'runnable' to run with the given priority.
+     * Any exception it throws is logged.
+     */
+    public static Future<?> submit(Priority priority, String name, Runnable runnable) {
+        Task<Object> task = new Task<Object>(priority, name, Executors.callable(runnable));
+        schedule(task);
+        return task;
+    }
+    
+    private static void schedule(Task<?> task) {
+        if (task.priority == Priority.BULK_IO) {
+            blockingExecutor.execute(task);
+        } else {
+            computeExecutor.execute(task);
+        }
+    }
+    
+    public static Batch newBatch(Priority priority, String name) {
+        return new Batch(priority, name);
+    }
+    
+    public static SerialExecutor newSerialExecutor(Priority priority, String name) {
+        return new SerialExecutor(priority, name);
+    }
+    
+    private static class Task<T> extends FutureTask<T> implements Comparable<Task<?>> {
+        private final Priority priority;
+        private final String name;
+        private final long sequenceNumber;
+        private final Stopwatch stopwatch;
+        private final AtomicBoolean started = new AtomicBoolean(false);
+        
+        private Task(Priority priority, String name, Callable<T> callable) {
+            super(callable);
+            this.priority = priority;
+            this.name = name;
+            this.sequenceNumber = nextSequenceNumber.getAndIncrement();
+            this.stopwatch = Stopwatch.get("WorkScheduler: " + name);
+        }
+        
+        @Override
+        public void run() {
+            // A Batch may have run us on the waiting thread already, or we may have been cancelled, in which case there's nothing to do or record.
+            if (isCancelled() || started.compareAndSet(false, true) == false) {
+                return;
+            }
+            Thread currentThread = Thread.currentThread();
+            String oldName = currentThread.getName();
+            currentThread.setName(oldName + " (" + name + ")");
+            Stopwatch.Timer timer = stopwatch.start();
+            try {
+                super.run();
+            } finally {
+                timer.stop();
+                currentThread.setName(oldName);
+            }
+        }
+        
+        @Override
+        protected void done() {
+            if (isCancelled()) {
+                return;
+            }
+            try {
+                get();
+            } catch (ExecutionException ex) {
+                Log.warn("Task \"" + name + "\" failed.", ex.getCause());
+            } catch (InterruptedException ex) {
+                // Can't happen: we're done.
+            }
+        }
+        
+        public int compareTo(Task<?> other) {
+            int result = priority.compareTo(other.priority);
+            if (result == 0) {
+                result = (sequenceNumber < other.sequenceNumber) ? -1 : ((sequenceNumber == other.sequenceNumber) ? 0 : 1);
+            }
+            return result;
+        }
+    }
+    
+    /**
+     * A group of tasks that can be waited for and cancelled together.
+     * Tasks should poll isCancelled if they might run for a long time.
+     */
+    public static class Batch {
+        private final Priority priority;
+        private final String name;
+        private final ArrayList<Task<?>> tasks = new ArrayList<Task<?>>();
+        private volatile boolean cancelled = false;
+        
+        private Batch(Priority priority, String name) {
+            this.priority = priority;
+            this.name = name;
+        }
+        
+        public void execute(Runnable runnable) {
+            Task<Object> task = new Task<Object>(priority, name, Executors.callable(runnable));
+            synchronized (tasks) {
+                tasks.add(task);
+            }
+            schedule(task);
+        }
+        
+        public boolean isCancelled() {
+            return cancelled;
+        }
+        
+        /**
+         * Cancels all tasks that haven't yet started, and asks any that have to stop.
+         */
+        public void cancel() {
+            cancelled = true;
+            for (Task<?> task : snapshot()) {
+                task.cancel(false);
+            }
+        }
+        
+        /**
+         * Waits for all the tasks in this batch to finish.
+         * Rather than block while tasks sit in the queue, the calling thread runs them itself.
+         * That means it's safe to wait for a batch from a worker thread without risking deadlock when the pool is small.
+         */
+        public void awaitCompletion() throws InterruptedException {
+            List<Task<?>> snapshot = snapshot();
+            for (Task<?> task : snapshot) {
+                task.run();
+            }
+            for (Task<?> task : snapshot) {
+                try {
+                    task.get();
+                } catch (CancellationException ex) {
+                    // Fine; we're still finished.
+                } catch (ExecutionException ex) {
+                    // Already logged by Task.done.
+                }
+            }
+        }
+        
+        private List<Task<?>> snapshot() {
+            synchronized (tasks) {
+                return new ArrayList<Task<?>>(tasks);
+            }
+        }
+    }
+    
+    /**
+     * Runs tasks one at a time, in submission order, on the shared pools.
+     * This replaces the idiom of a single-thread executor per component without dedicating a thread to each.
+     */
+    public static class SerialExecutor implements Executor {
+        private final Priority priority;
+        private final String name;
+        private final LinkedList<Runnable> pending = new LinkedList<Runnable>();
+        private Runnable active;
+        private Future<?> activeFuture;
+        private boolean shutDown = false;
+        
+        private SerialExecutor(Priority priority, String name) {
+            this.priority = priority;
+            this.name = name;
+        }
+        
+        public synchronized void execute(final Runnable runnable) {
+            if (shutDown) {
+                return;
+            }
+            pending.add(new Runnable() {
+                public void run() {
+                    try {
+                        runnable.run();
+                    } finally {
+                        scheduleNext();
+                    }
+                }
+            });
+            if (active == null) {
+                scheduleNext();
+            }
+        }
+        
+        private synchronized void scheduleNext() {
+            active = shutDown ? null : pending.poll();
+            activeFuture = (active != null) ? submit(priority, name, active) : null;
+        }
+        
+        /**
+         * Discards any tasks that haven't started, interrupts any that has, and ignores any submitted later.
+         */
+        public synchronized void shutdownNow() {
+            shutDown = true;
+            pending.clear();
+            if (activeFuture != null) {
+                activeFuture.cancel(true);
+            }
+        }
+    }
+    
+    private static class WorkerThreadFactory implements ThreadFactory {
+        private final AtomicInteger threadNumber = new AtomicInteger(1);
+        private final String namePrefix;
+        
+        WorkerThreadFactory(String poolName) {
+            this.namePrefix = poolName + "-thread-";
+        }
+        
+        public Thread newThread(Runnable r) {
+            Thread thread = new Thread(r, namePrefix + threadNumber.getAndIncrement());
+            // Idle workers shouldn't keep the VM alive.
+            thread.setDaemon(true);
+            // Avoid inheriting the high priority of the event dispatch thread.
+            thread.setPriority(Thread.NORM_PRIORITY);
+            return thread;
+        }
+    }
+}
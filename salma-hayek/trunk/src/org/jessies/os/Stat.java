@@ -20,6 +20,8 @@ public class Stat {
     private long /*time_t*/ st_ctime;
     private long /*blksize_t*/ st_blksize;
     private long /*blkcnt_t*/ st_blocks;
+    private long /*long*/ st_mtime_nsec;
+    private long /*long*/ st_ctime_nsec;
     
     /** Device ID of device containing file. */
     public long st_dev() { return st_dev; }
@@ -60,6 +62,12 @@ public class Stat {
     /** Time of last status change. */
     public long st_ctime() { return st_ctime; }
     
+    /** Nanoseconds part of the time of last data modification, or 0 if the file system doesn't record it. */
+    public long st_mtime_nsec() { return st_mtime_nsec; }
+    
+    /** Nanoseconds part of the time of last status change, or 0 if the file system doesn't record it. */
+    public long st_ctime_nsec() { return st_ctime_nsec; }
+    
     /**
      * A file system-specific preferred I/O block size for this object.
      * In some file system types, this may vary from file to file.
@@ -87,7 +95,7 @@ public class Stat {
     public Stat() {
     }
     
-    private void set(long st_dev, long st_ino, int st_mode, long st_nlink, int st_uid, int st_gid, long st_rdev, long st_size, long st_atime, long st_mtime, long st_ctime, long st_blksize, long st_blocks) {
+    private void set(long st_dev, long st_ino, int st_mode, long st_nlink, int st_uid, int st_gid, long st_rdev, long st_size, long st_atime, long st_mtime, long st_ctime, long st_blksize, long st_blocks, long st_mtime_nsec, long st_ctime_nsec) {
         this.st_dev = st_dev;
         this.st_ino = st_ino;
         this.st_mode = st_mode;
@@ -101,5 +109,7 @@ public class Stat {
         this.st_ctime = st_ctime;
         this.st_blksize = st_blksize;
         this.st_blocks = st_blocks;
+        this.st_mtime_nsec = st_mtime_nsec;
+        this.st_ctime_nsec = st_ctime_nsec;
     }
 }
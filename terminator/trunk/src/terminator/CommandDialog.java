@@ -10,7 +10,6 @@ import java.util.List;
 import java.util.regex.*;
 import javax.swing.*;
 import org.jdesktop.swingworker.SwingWorker;
-import terminator.view.*;
 
 /**
  * Asks the user for a command to run.
@@ -121,7 +120,10 @@ public class CommandDialog {
         }
     }
     
-    public JTerminalPane askForCommandToRun() {
+    /**
+     * Returns the command the user asked to run, or null if they cancelled.
+     */
+    public String askForCommandToRun() {
         while (form.show("Run")) {
             String command = commandField.getText().trim();
             if (command.length() == 0) {
@@ -130,7 +132,7 @@ public class CommandDialog {
             synchronized (history) {
                 history.add(command);
             }
-            return JTerminalPane.newCommandWithName(command, null, null);
+            return command;
         }
         return null;
     }
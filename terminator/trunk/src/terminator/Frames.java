@@ -3,8 +3,11 @@ package terminator;
 import com.apple.eawt.*;
 import e.util.*;
 import java.awt.*;
+import java.awt.event.*;
 import java.util.*;
+import java.util.List;
 import javax.swing.*;
+import terminator.view.*;
 
 /**
  * Ensures that, on Mac OS, we always have our menu bar visible, even
@@ -12,11 +15,24 @@ import javax.swing.*;
  * a copy of the menu bar attached. When no other window has the focus,
  * but the application is focused, this hidden window gets the focus,
  * and its menu is used for the screen menu bar.
+ * 
+ * Also keeps a spare TerminatorFrame, constructed in idle time, so that
+ * a new window only needs its terminals attached before it's shown.
  */
 public class Frames implements Iterable<TerminatorFrame> {
+    // Wait this long after a window opens before making its replacement, so we don't slow down the new window's start-up.
+    private static final int SPARE_FRAME_DELAY_MS = 2000;
+    
+    // Set -Dorg.jessies.terminator.spareFrame=false to compare time to first paint without a spare.
+    private static final boolean USE_SPARE_FRAME = Boolean.parseBoolean(System.getProperty("org.jessies.terminator.spareFrame", "true"));
+    
     private ArrayList<TerminatorFrame> list = new ArrayList<TerminatorFrame>();
     private JFrame hiddenFrame; // Mac OS X only.
     
+    // Only touched on the EDT.
+    private TerminatorFrame spareFrame;
+    private javax.swing.Timer spareFrameTimer;
+    
     private static final Action[] DOCK_MENU_ACTIONS = new Action[] {
         new TerminatorMenuBar.NewShellAction(),
         new TerminatorMenuBar.NewCommandAction(),
@@ -73,11 +89,74 @@ public class Frames implements Iterable<TerminatorFrame> {
     
     public void removeFrame(TerminatorFrame frame) {
         list.remove(frame);
+        if (list.isEmpty()) {
+            // A displayable spare would stop the VM from exiting when the last real window closes.
+            discardSpareFrame();
+        }
         if (GuiUtilities.isMacOs()) {
             frameStateChanged();
         }
     }
     
+    /**
+     * Shows a new window containing 'terminals', using the spare frame if there is one.
+     * 'requestStartNs' is the System.nanoTime at which the user asked for the window.
+     * Must be called on the EDT.
+     */
+    public TerminatorFrame openFrame(List<JTerminalPane> terminals, long requestStartNs) {
+        TerminatorFrame frame = spareFrame;
+        spareFrame = null;
+        if (frame == null) {
+            frame = new TerminatorFrame();
+        }
+        frame.attachTerminals(terminals, requestStartNs);
+        prepareSpareFrameLater();
+        return frame;
+    }
+    
+    private void prepareSpareFrameLater() {
+        if (USE_SPARE_FRAME == false) {
+            return;
+        }
+        if (spareFrameTimer == null) {
+            spareFrameTimer = new javax.swing.Timer(SPARE_FRAME_DELAY_MS, new ActionListener() {
+                public void actionPerformed(ActionEvent e) {
+                    prepareSpareFrame();
+                }
+            });
+            spareFrameTimer.setRepeats(false);
+        }
+        // If the user's opening several windows in a row, wait until they've finished.
+        spareFrameTimer.restart();
+    }
+    
+    private void prepareSpareFrame() {
+        if (spareFrame != null || list.isEmpty()) {
+            return;
+        }
+        spareFrame = new TerminatorFrame();
+    }
+    
+    private void discardSpareFrame() {
+        if (spareFrameTimer != null) {
+            spareFrameTimer.stop();
+        }
+        if (spareFrame != null) {
+            spareFrame.dispose();
+            spareFrame = null;
+        }
+    }
+    
+    /**
+     * Replaces any spare frame, which was built with the old preferences.
+     */
+    public void optionsDidChange() {
+        if (spareFrame != null) {
+            discardSpareFrame();
+            prepareSpareFrameLater();
+        }
+    }
+    
     public void frameStateChanged() {
         if (GuiUtilities.isMacOs()) {
             for (TerminatorFrame frame : list) {
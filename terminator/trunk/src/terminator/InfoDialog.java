@@ -17,6 +17,7 @@ public class InfoDialog {
     private JTextField processes;
     private JTextField logFilename;
     private JTextField ptyFilename;
+    private JTextField outputProcessing;
     private JCheckBox suspendLogging;
     private JTerminalPane terminal;
     
@@ -31,6 +32,7 @@ public class InfoDialog {
         this.processes = new UneditableTextField();
         this.logFilename = new UneditableTextField();
         this.ptyFilename = new UneditableTextField();
+        this.outputProcessing = new UneditableTextField();
         this.suspendLogging = makeSuspendLoggingCheckBox();
     }
     
@@ -62,6 +64,7 @@ public class InfoDialog {
         formPanel.addRow("Dimensions:", dimensions);
         formPanel.addRow("Pseudo-Terminal:", ptyFilename);
         formPanel.addRow("Processes:", processes);
+        formPanel.addRow("Output Processing:", outputProcessing);
         formPanel.addRow("Log Filename:", logFilename);
         if (GuiUtilities.isMacOs() || GuiUtilities.isWindows()) {
             JButton showInFinderButton = new JButton(GuiUtilities.isMacOs() ? "Show in Finder" : "Show in Explorer");
@@ -94,6 +97,7 @@ public class InfoDialog {
             ptyFilename.setText("(no pseudo-terminal allocated)");
             processes.setText("");
         }
+        outputProcessing.setText(terminal.getControl().describeOutputProcessingTime());
         
         final TerminalLogWriter terminalLogWriter = terminal.getControl().getTerminalLogWriter();
         logFilename.setText(terminalLogWriter.getInfo());
@@ -60,7 +60,8 @@ public class Terminator {
             @Override
             public void handleReOpenApplication(ApplicationEvent e) {
                 if (frames.isEmpty()) {
-                    openFrame(JTerminalPane.newShell());
+                    long requestStartNs = System.nanoTime();
+                    openFrame(JTerminalPane.newShell(), requestStartNs);
                 }
                 e.setHandled(true);
             }
@@ -182,8 +183,19 @@ public class Terminator {
         return frames;
     }
     
+    /**
+     * Opens a window for a terminal that already exists, such as a detached tab.
+     */
     public void openFrame(JTerminalPane terminalPane) {
-        new TerminatorFrame(Collections.singletonList(terminalPane));
+        openFrame(terminalPane, System.nanoTime());
+    }
+    
+    /**
+     * Opens a window for a new terminal.
+     * 'requestStartNs' is the System.nanoTime at which the user asked for it, taken before the terminal was created, so that its time to first paint includes creating the terminal.
+     */
+    public void openFrame(JTerminalPane terminalPane, long requestStartNs) {
+        frames.openFrame(Collections.singletonList(terminalPane), requestStartNs);
     }
     
     /**
@@ -215,6 +227,7 @@ public class Terminator {
         for (int i = 0; i < frames.size(); ++i) {
             frames.get(i).optionsDidChange();
         }
+        frames.optionsDidChange();
     }
     
     public static void main(final String[] argumentArray) {
@@ -20,10 +20,36 @@ public class TerminatorFrame extends JFrame implements TerminalPaneHost {
     
     private final Color originalBackground = getBackground();
     
-    public TerminatorFrame(List<JTerminalPane> initialTerminalPanes) {
+    /**
+     * Creates a hidden frame with no terminals; Frames.openFrame attaches them, possibly much later if this is its spare.
+     * Everything that doesn't depend on the terminals is done here, including creating the native peer, so attachTerminals has little left to do.
+     */
+    TerminatorFrame() {
         super("Terminator");
-        terminals = new ArrayList<JTerminalPane>(initialTerminalPanes);
+        terminals = new ArrayList<JTerminalPane>();
         initFrame();
+    }
+    
+    /**
+     * Puts the given terminals in this frame, shows it, and starts them.
+     * 'requestStartNs' is the System.nanoTime at which the user asked for the window, so we can report how long they waited.
+     */
+    void attachTerminals(List<JTerminalPane> initialTerminalPanes, long requestStartNs) {
+        terminals.addAll(initialTerminalPanes);
+        Terminator.getSharedInstance().getFrames().addFrame(this);
+        initTerminals();
+        for (JTerminalPane terminal : terminals) {
+            terminal.optionsDidChange();
+        }
+        terminals.get(0).getTerminalView().reportTimeToFirstPaint(requestStartNs);
+        
+        pack();
+        setVisible(true);
+        
+        if (GuiUtilities.isMacOs()) {
+            WindowMenu.getSharedInstance().addWindow(this);
+        }
+        
         initFocus();
         for (JTerminalPane terminal : terminals) {
             terminal.start(this);
@@ -46,7 +72,10 @@ public class TerminatorFrame extends JFrame implements TerminalPaneHost {
                 title.append(pane.getTerminalName());
             }
         }
-        setTitle(title.toString());
+        // Setting even an unchanged title makes the peer update the window manager's property.
+        if (title.toString().equals(getTitle()) == false) {
+            setTitle(title.toString());
+        }
     }
     
     private void initFrame() {
@@ -54,7 +83,6 @@ public class TerminatorFrame extends JFrame implements TerminalPaneHost {
         
         JFrameUtilities.setFrameIcon(this);
         
-        Terminator.getSharedInstance().getFrames().addFrame(this);
         addWindowListener(new WindowAdapter() {
             @Override
             public void windowOpened(WindowEvent event) {
@@ -87,15 +115,10 @@ public class TerminatorFrame extends JFrame implements TerminalPaneHost {
             });
         }
         
-        initTerminals();
-        optionsDidChange();
-        
-        pack();
-        setVisible(true);
-        
-        if (GuiUtilities.isMacOs()) {
-            WindowMenu.getSharedInstance().addWindow(this);
-        }
+        updateBackground();
+        updateMenuBar();
+        // Creating the native peer is a large part of the cost of a new window, and doesn't need to wait until we're shown.
+        addNotify();
     }
     
     private void initTerminals() {
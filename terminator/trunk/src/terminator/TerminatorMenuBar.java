@@ -275,11 +275,12 @@ public class TerminatorMenuBar extends EMenuBar {
         }
         
         public void actionPerformed(ActionEvent e) {
-            Terminator.getSharedInstance().openFrame(JTerminalPane.newShell());
+            long requestStartNs = System.nanoTime();
+            Terminator.getSharedInstance().openFrame(JTerminalPane.newShell(), requestStartNs);
         }
     }
     
-    private static void addTab(JTerminalPane terminalPane) {
+    private static void addTab(JTerminalPane terminalPane, long requestStartNs) {
         TerminatorFrame frame = getFocusedTerminatorFrame();
         
         // On Mac OS, if the user hits C-T multiple times in quick succession while we've got no window up, we end up here with no focused frame.
@@ -295,7 +296,7 @@ public class TerminatorMenuBar extends EMenuBar {
             frame.addTab(terminalPane);
         } else {
             // There's no existing frame, so interpret "New Shell Tab..." as "New Shell...".
-            Terminator.getSharedInstance().openFrame(terminalPane);
+            Terminator.getSharedInstance().openFrame(terminalPane, requestStartNs);
         }
     }
     
@@ -306,7 +307,8 @@ public class TerminatorMenuBar extends EMenuBar {
         }
         
         public void actionPerformed(ActionEvent e) {
-            addTab(JTerminalPane.newShell());
+            long requestStartNs = System.nanoTime();
+            addTab(JTerminalPane.newShell(), requestStartNs);
         }
     }
     
@@ -317,11 +319,12 @@ public class TerminatorMenuBar extends EMenuBar {
         
         @Override
         protected void performPaneAction(JTerminalPane terminalPane) {
+            long requestStartNs = System.nanoTime();
             JTerminalPane newPane = terminalPane.newShellHere();
             if (newPane == null) {
                 return;
             }
-            Terminator.getSharedInstance().openFrame(newPane);
+            Terminator.getSharedInstance().openFrame(newPane, requestStartNs);
         }
     }
     
@@ -332,11 +335,12 @@ public class TerminatorMenuBar extends EMenuBar {
         
         @Override
         protected void performPaneAction(JTerminalPane terminalPane) {
+            long requestStartNs = System.nanoTime();
             JTerminalPane newPane = terminalPane.newShellHere();
             if (newPane == null) {
                 return;
             }
-            addTab(newPane);
+            addTab(newPane, requestStartNs);
         }
     }
     
@@ -351,13 +355,15 @@ public class TerminatorMenuBar extends EMenuBar {
         }
         
         public static void newCommand() {
-            final JTerminalPane terminalPane = new CommandDialog().askForCommandToRun();
-            if (terminalPane != null) {
+            final String command = new CommandDialog().askForCommandToRun();
+            if (command != null) {
+                // The user's request starts when they dismiss the dialog.
+                final long requestStartNs = System.nanoTime();
                 // We need to invokeLater to avoid a race condition where (I think) the VK_ENTER hasn't finished processing and gets dispatched again to the new terminal.
                 // Chris Reece saw this on Mac OS if he did shift-command T, tab, return with no other windows open.
                 EventQueue.invokeLater(new Runnable() {
                     public void run() {
-                        Terminator.getSharedInstance().openFrame(terminalPane);
+                        Terminator.getSharedInstance().openFrame(JTerminalPane.newCommandWithName(command, null, null), requestStartNs);
                     }
                 });
             }
@@ -373,9 +379,9 @@ public class TerminatorMenuBar extends EMenuBar {
         public void actionPerformed(ActionEvent e) {
             TerminatorFrame frame = getFocusedTerminatorFrame();
             if (frame != null) {
-                JTerminalPane terminalPane = new CommandDialog().askForCommandToRun();
-                if (terminalPane != null) {
-                    frame.addTab(terminalPane);
+                String command = new CommandDialog().askForCommandToRun();
+                if (command != null) {
+                    frame.addTab(JTerminalPane.newCommandWithName(command, null, null));
                 }
             } else {
                 // There's no existing frame, so interpret "New Command Tab..." as "New Command...".
@@ -49,7 +49,8 @@ public class TerminatorOpener implements Runnable {
     
     public TerminatorFrame createUi() {
         try {
-            this.window = new TerminatorFrame(getInitialTerminals());
+            long requestStartNs = System.nanoTime();
+            this.window = Terminator.getSharedInstance().getFrames().openFrame(getInitialTerminals(), requestStartNs);
             return window;
         } catch (UsageError ex) {
             err.println(ex.getMessage());
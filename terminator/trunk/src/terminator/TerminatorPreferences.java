@@ -19,6 +19,7 @@ public class TerminatorPreferences extends Preferences {
     public static final String ALPHA = "alpha";
     public static final String ALWAYS_SHOW_TABS = "alwaysShowTabs";
     public static final String ANTI_ALIAS = "antiAlias";
+    public static final String BACKGROUND_UPDATES_PER_SECOND = "backgroundUpdatesPerSecond";
     public static final String BLINK_CURSOR = "cursorBlink";
     public static final String BLOCK_CURSOR = "blockCursor";
     public static final String FANCY_BELL = "fancyBell";
@@ -66,6 +67,7 @@ public class TerminatorPreferences extends Preferences {
         addPreference("Behavior", HIDE_MOUSE_WHEN_TYPING, Boolean.TRUE, "Hide mouse when typing");
         addPreference("Behavior", VISUAL_BELL, Boolean.TRUE, "Visual bell (as opposed to no bell)");
         addPreference("Behavior", USE_ALT_AS_META, Boolean.FALSE, "Use alt key as meta key (for Emacs)");
+        addPreference("Behavior", BACKGROUND_UPDATES_PER_SECOND, Integer.valueOf(10), "Updates per second for tabs without the focus");
         
         addPreference("Appearance", ANTI_ALIAS, Boolean.TRUE, "Anti-alias text");
         addPreference("Appearance", BLINK_CURSOR, Boolean.TRUE, "Blink cursor");
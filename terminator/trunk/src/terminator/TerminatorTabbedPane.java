@@ -165,9 +165,13 @@ public class TerminatorTabbedPane extends TabbedPane {
     }
     
     private static class TerminatorTabComponent extends JPanel implements ChangeListener {
+        // Output can arrive thousands of times a second; there's no point turning the spinner faster than it turns by itself.
+        private static final long SPINNER_FRAME_INTERVAL_NS = 50 * 1000000L;
+        
         private final JTerminalPane terminalPane;
         private final JLabel label;
         private final JAsynchronousProgressIndicator outputSpinner;
+        private volatile long lastSpinnerFrameNs = System.nanoTime() - SPINNER_FRAME_INTERVAL_NS;
         
         private TerminatorTabComponent(JTerminalPane terminalPane) {
             // FIXME: would BoxLayout make more sense?
@@ -237,7 +241,12 @@ public class TerminatorTabbedPane extends TabbedPane {
         }
 
         public void stateChanged(ChangeEvent e) {
+            long now = System.nanoTime();
+            if (now - lastSpinnerFrameNs < SPINNER_FRAME_INTERVAL_NS) {
+                return;
+            }
             if (!terminalPane.isShowing()) {
+                lastSpinnerFrameNs = now;
                 outputSpinner.setPainted(true);
                 outputSpinner.animateOneFrame();
             }
@@ -1,6 +1,7 @@
 package terminator.model;
 
 import java.awt.*;
+import java.awt.event.*;
 import java.util.*;
 import javax.swing.*;
 import e.util.*;
@@ -33,6 +34,13 @@ public class TerminalModel {
     // Fields used for saving and restoring the 'real' screen while the alternate buffer is in use.
     private TextLine[] savedScreen;
     
+    // Shells that set the title in every prompt, and tools that report progress in it, can change it many times a second.
+    // We pass on only the latest title, at most once per batch of output and once per WINDOW_TITLE_INTERVAL_MS.
+    private static final int WINDOW_TITLE_INTERVAL_MS = 50;
+    private String pendingWindowTitle;
+    private long lastWindowTitleChangeNs = System.nanoTime() - WINDOW_TITLE_INTERVAL_MS * 1000000L;
+    private javax.swing.Timer windowTitleTimer;
+    
     public TerminalModel(TerminalView view, int width, int height) {
         this.view = view;
         setSize(width, height);
@@ -324,6 +332,7 @@ public class TerminalModel {
             view.scrollOnTtyOutput(wereAtBottom);
         }
         view.setCursorPosition(cursorPosition);
+        flushWindowTitle();
     }
     
     public void setStyle(Style style) {
@@ -640,7 +649,39 @@ public class TerminalModel {
     }
     
     public void setWindowTitle(String newWindowTitle) {
+        pendingWindowTitle = newWindowTitle;
+    }
+    
+    private void flushWindowTitle() {
+        if (pendingWindowTitle == null) {
+            return;
+        }
         JTerminalPane terminalPane = (JTerminalPane) SwingUtilities.getAncestorOfClass(JTerminalPane.class, view);
+        if (terminalPane == null || pendingWindowTitle.equals(terminalPane.getTerminalName())) {
+            // Re-setting the same title would still relayout the tabs and bother the window manager.
+            pendingWindowTitle = null;
+            return;
+        }
+        long delayMs = (lastWindowTitleChangeNs + WINDOW_TITLE_INTERVAL_MS * 1000000L - System.nanoTime()) / 1000000L;
+        if (delayMs > 0) {
+            // Too soon; try again later, by which time there may well be a newer title.
+            if (windowTitleTimer == null) {
+                windowTitleTimer = new javax.swing.Timer(0, new ActionListener() {
+                    public void actionPerformed(ActionEvent e) {
+                        flushWindowTitle();
+                    }
+                });
+                windowTitleTimer.setRepeats(false);
+            }
+            if (windowTitleTimer.isRunning() == false) {
+                windowTitleTimer.setInitialDelay((int) delayMs);
+                windowTitleTimer.start();
+            }
+            return;
+        }
+        lastWindowTitleChangeNs = System.nanoTime();
+        String newWindowTitle = pendingWindowTitle;
+        pendingWindowTitle = null;
         terminalPane.setTerminalName(newWindowTitle);
     }
 }
@@ -5,7 +5,6 @@ import java.awt.*;
 import java.io.*;
 import java.util.*;
 import java.util.List;
-import java.util.concurrent.*;
 import javax.swing.event.*;
 import terminator.*;
 import terminator.model.*;
@@ -45,7 +44,7 @@ public class TerminalControl {
     private InputStreamReader in;
     private OutputStream out;
     
-    private ExecutorService writerExecutor;
+    private WorkScheduler.SerialExecutor writerExecutor;
     private Thread readerThread;
     
     private int characterSet;
@@ -61,8 +60,8 @@ public class TerminalControl {
     
     // Buffer of TerminalActions to perform.
     private ArrayList<TerminalAction> terminalActions = new ArrayList<TerminalAction>();
-    // Semaphore to prevent us from overrunning the EDT.
-    private Semaphore flowControl = new Semaphore(30);
+    // Shares the EDT fairly with other terminals, giving precedence to whichever one has the focus.
+    private final TerminalOutputScheduler.Channel outputChannel = new TerminalOutputScheduler.Channel(this);
     
     public TerminalControl(JTerminalPane pane, TerminalModel model) {
         reset();
@@ -95,7 +94,8 @@ public class TerminalControl {
         Log.warn("Created " + ptyProcess + " and logging to " + terminalLogWriter.getInfo());
         this.in = new InputStreamReader(ptyProcess.getInputStream(), CHARSET_NAME);
         this.out = ptyProcess.getOutputStream();
-        writerExecutor = ThreadUtilities.newSingleThreadExecutor(makeThreadName("Writer"));
+        // Writes block if the child isn't reading, so they go on the scheduler's blocking pool rather than a dedicated thread per tab.
+        writerExecutor = WorkScheduler.newSerialExecutor(WorkScheduler.Priority.BULK_IO, "Terminal Writer");
     }
     
     public static ArrayList<String> getDefaultShell() {
@@ -234,7 +234,7 @@ public class TerminalControl {
         processIsRunning = false;
 
         // The readerThread will have shut itself down by now.
-        // We need to handle the writer ExecutorService ourselves.
+        // We need to handle the writer executor ourselves.
         if (writerExecutor != null) {
             writerExecutor.shutdownNow();
         }
@@ -325,30 +325,33 @@ public class TerminalControl {
             return;
         }
         
-        final TerminalAction[] actions = terminalActions.toArray(new TerminalAction[terminalActions.size()]);
-        terminalActions.clear();
-        
-        boolean didAcquire = false;
         try {
-            flowControl.acquire();
-            didAcquire = true;
-            EventQueue.invokeLater(new Runnable() {
-                public void run() {
-                    try {
-                        model.processActions(actions);
-                    } catch (Throwable th) {
-                        Log.warn("Couldn't process terminal actions for " + ptyProcess, th);
-                    } finally {
-                        flowControl.release();
-                    }
-                }
-            });
+            outputChannel.enqueue(terminalActions);
         } catch (Throwable th) {
             Log.warn("Couldn't flush terminal actions for " + ptyProcess, th);
-            if (didAcquire) {
-                flowControl.release();
-            }
         }
+        terminalActions.clear();
+    }
+    
+    /** Must be called in the AWT dispatcher thread. */
+    void processActions(TerminalAction[] actions) {
+        try {
+            model.processActions(actions);
+        } catch (Throwable th) {
+            Log.warn("Couldn't process terminal actions for " + ptyProcess, th);
+        }
+    }
+    
+    TerminalOutputScheduler.Channel getOutputChannel() {
+        return outputChannel;
+    }
+    
+    /**
+     * Describes how much of the AWT dispatcher thread's time this terminal's output has taken, so a runaway terminal can be identified.
+     * Must be called in the AWT dispatcher thread.
+     */
+    public String describeOutputProcessingTime() {
+        return outputChannel.describeProcessingTime();
     }
     
     /**
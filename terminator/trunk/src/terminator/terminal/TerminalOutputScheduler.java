@@ -0,0 +1,200 @@
+package terminator.terminal;
+
+import e.util.*;
+import java.awt.*;
+import java.awt.event.*;
+import java.beans.*;
+import java.util.*;
+import java.util.List;
+import javax.swing.*;
+import terminator.*;
+import terminator.view.*;
+
+/**
+ * Decides when each terminal's output is applied to its model on the EDT, so a tab flooding output can't starve the tab the user is typing in.
+ *
+ * Every TerminalControl's reader thread hands its parsed output to a Channel here rather than posting it to the EDT itself.
+ * One dispatcher on the EDT applies the focused terminal's output first, whenever there is any, so keystroke echo isn't queued behind other tabs.
+ * Other terminals' output is coalesced and applied at most TerminatorPreferences.BACKGROUND_UPDATES_PER_SECOND times a second, and only while the dispatcher is within its time budget.
+ * Readers don't wait for the EDT, so background ptys keep draining and their children don't block; only a terminal whose backlog becomes enormous has its reader wait.
+ *
+ * The EDT time spent on each terminal is recorded, so the Info dialog can show which tab is costing us.
+ */
+final class TerminalOutputScheduler {
+    // How long one dispatch may spend on background terminals before letting the EDT get on with other events.
+    private static final long BACKGROUND_BUDGET_NS = 20 * 1000000L;
+    
+    // A reader that gets this far ahead of the EDT waits for it, so a runaway terminal can't exhaust the heap.
+    private static final int MAX_PENDING_ACTIONS = 100000;
+    
+    // Guarded by TerminalOutputScheduler.class: the channels with pending output, oldest first.
+    private static final LinkedHashSet<Channel> readyChannels = new LinkedHashSet<Channel>();
+    private static boolean isDispatchQueued = false;
+    private static boolean isTimerArmed = false;
+    private static Channel focusedChannel;
+    
+    // Only touched on the EDT.
+    private static final javax.swing.Timer backgroundTimer = new javax.swing.Timer(0, new ActionListener() {
+        public void actionPerformed(ActionEvent e) {
+            dispatch();
+        }
+    });
+    static {
+        backgroundTimer.setRepeats(false);
+        // When the user switches tabs, the newly-focused tab's next output (and any backlog) should appear straight away.
+        KeyboardFocusManager.getCurrentKeyboardFocusManager().addPropertyChangeListener("permanentFocusOwner", new PropertyChangeListener() {
+            public void propertyChange(PropertyChangeEvent e) {
+                Channel focused = findFocusedChannel();
+                synchronized (TerminalOutputScheduler.class) {
+                    focusedChannel = focused;
+                    if (readyChannels.isEmpty() == false) {
+                        queueDispatch();
+                    }
+                }
+            }
+        });
+    }
+    
+    private TerminalOutputScheduler() {
+    }
+    
+    /**
+     * One terminal's queue of output waiting for the EDT, and the cost of applying it.
+     */
+    static final class Channel {
+        private final TerminalControl control;
+        
+        // Guarded by TerminalOutputScheduler.class.
+        private ArrayList<TerminalAction> pendingActions = new ArrayList<TerminalAction>();
+        
+        // Only touched on the EDT.
+        private long lastDispatchNs;
+        private long processingTimeNs;
+        private long dispatchCount;
+        private long actionCount;
+        
+        Channel(TerminalControl control) {
+            this.control = control;
+            // So that a new terminal's first output is due straight away.
+            this.lastDispatchNs = System.nanoTime() - 1000000000L;
+        }
+        
+        /**
+         * Queues 'actions' to be performed on the EDT, in order after any already queued.
+         * Must not be called with a lock the EDT might need, because it can wait.
+         */
+        void enqueue(List<TerminalAction> actions) throws InterruptedException {
+            synchronized (TerminalOutputScheduler.class) {
+                pendingActions.addAll(actions);
+                readyChannels.add(this);
+                if (this == focusedChannel || isTimerArmed == false) {
+                    queueDispatch();
+                }
+                if (EventQueue.isDispatchThread() == false) {
+                    while (pendingActions.size() > MAX_PENDING_ACTIONS) {
+                        TerminalOutputScheduler.class.wait();
+                    }
+                }
+            }
+        }
+        
+        /**
+         * Describes how much EDT time this terminal's output has cost, for the Info dialog.
+         * Must be called on the EDT.
+         */
+        String describeProcessingTime() {
+            return TimeUtilities.nsToString(processingTimeNs) + " for " + actionCount + " actions in " + dispatchCount + " updates";
+        }
+        
+        private void dispatch() {
+            ArrayList<TerminalAction> actions;
+            synchronized (TerminalOutputScheduler.class) {
+                actions = pendingActions;
+                pendingActions = new ArrayList<TerminalAction>();
+                readyChannels.remove(this);
+                // Wake any reader waiting for its backlog to shrink.
+                TerminalOutputScheduler.class.notifyAll();
+            }
+            if (actions.isEmpty()) {
+                return;
+            }
+            long startNs = System.nanoTime();
+            control.processActions(actions.toArray(new TerminalAction[actions.size()]));
+            lastDispatchNs = System.nanoTime();
+            processingTimeNs += lastDispatchNs - startNs;
+            actionCount += actions.size();
+            ++dispatchCount;
+        }
+    }
+    
+    // Callers must hold the class lock.
+    private static void queueDispatch() {
+        if (isDispatchQueued) {
+            return;
+        }
+        isDispatchQueued = true;
+        EventQueue.invokeLater(new Runnable() {
+            public void run() {
+                dispatch();
+            }
+        });
+    }
+    
+    private static void dispatch() {
+        backgroundTimer.stop();
+        Channel focused = findFocusedChannel();
+        ArrayList<Channel> backgroundChannels;
+        synchronized (TerminalOutputScheduler.class) {
+            isDispatchQueued = false;
+            isTimerArmed = false;
+            focusedChannel = focused;
+            backgroundChannels = new ArrayList<Channel>(readyChannels);
+        }
+        
+        if (focused != null) {
+            focused.dispatch();
+            backgroundChannels.remove(focused);
+        }
+        
+        final long now = System.nanoTime();
+        final long intervalNs = 1000000000L / Math.max(1, Terminator.getPreferences().getInt(TerminatorPreferences.BACKGROUND_UPDATES_PER_SECOND));
+        final long budgetEndNs = now + BACKGROUND_BUDGET_NS;
+        boolean isOverBudget = false;
+        boolean isBehind = false;
+        long nextDueNs = Long.MAX_VALUE;
+        for (Channel channel : backgroundChannels) {
+            long dueNs = channel.lastDispatchNs + intervalNs;
+            if (dueNs - now > 0) {
+                nextDueNs = Math.min(nextDueNs, dueNs);
+            } else if (isOverBudget) {
+                isBehind = true;
+            } else {
+                channel.dispatch();
+                isOverBudget = (System.nanoTime() - budgetEndNs > 0);
+            }
+        }
+        
+        synchronized (TerminalOutputScheduler.class) {
+            if (isBehind) {
+                // Let any input events that arrived meanwhile go first, then carry on.
+                queueDispatch();
+            } else if (nextDueNs != Long.MAX_VALUE && isDispatchQueued == false) {
+                isTimerArmed = true;
+                backgroundTimer.setInitialDelay((int) Math.max(1, (nextDueNs - now) / 1000000L));
+                backgroundTimer.restart();
+            }
+        }
+    }
+    
+    private static Channel findFocusedChannel() {
+        Component focusOwner = KeyboardFocusManager.getCurrentKeyboardFocusManager().getPermanentFocusOwner();
+        if (focusOwner == null) {
+            return null;
+        }
+        JTerminalPane pane = (JTerminalPane) SwingUtilities.getAncestorOfClass(JTerminalPane.class, focusOwner);
+        if (pane == null || pane.getControl() == null) {
+            return null;
+        }
+        return pane.getControl().getOutputChannel();
+    }
+}
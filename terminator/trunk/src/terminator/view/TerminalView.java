@@ -45,6 +45,9 @@ public class TerminalView extends JComponent implements FocusListener, Scrollabl
     // Init line index to 0 so we never need to check if it's a valid line index, but don't have a valid char offset.
     private Location mouseLocation = new Location(0, -1);
     
+    // The System.nanoTime at which our window was requested, until we've been painted; 0 if we're not waiting to report that.
+    private long windowRequestNs = 0;
+    
     public TerminalView() {
         TerminatorPreferences preferences = Terminator.getPreferences();
         // The background is no longer set in optionsDidChange
@@ -786,6 +789,17 @@ public class TerminalView extends JComponent implements FocusListener, Scrollabl
         } finally {
             timer.stop();
         }
+        if (windowRequestNs != 0) {
+            Log.warn("Time to first paint: " + TimeUtilities.nsToString(System.nanoTime() - windowRequestNs) + ".");
+            windowRequestNs = 0;
+        }
+    }
+    
+    /**
+     * Logs how long after 'requestStartNs' we're first painted, so the cost of opening a new window can be measured.
+     */
+    public void reportTimeToFirstPaint(long requestStartNs) {
+        this.windowRequestNs = requestStartNs;
     }
     
     /**
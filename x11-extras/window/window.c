@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <regex.h>
 #include <signal.h>
 #include <errno.h>
 
@@ -13,12 +15,15 @@
 #include <X11/Xutil.h>
 #include <X11/Xatom.h>
 
+#include <xcb/xcb.h>
+
 typedef struct ReasonDesc ReasonDesc;
 struct ReasonDesc {
     char    *name;
     int    nargs;
     void    (*fn)(char**);
     char    *usage;
+    Bool    usesXcb;    /* If so, we don't open an Xlib connection. */
 };
 
 Display *dpy;
@@ -41,15 +46,6 @@ wind(char *p) {
     exit(EXIT_FAILURE);
 }
 
-static int
-listwindows(Window w, Window **ws) {
-    unsigned    nkids;
-    Window    dumb;
-
-    XQueryTree(dpy, w, &dumb, &dumb, ws, &nkids);
-    return nkids;
-}
-
 static void    
 RaiseWindow(char **argv) {
     XRaiseWindow(dpy, wind(*argv));
@@ -146,36 +142,432 @@ ResizeWindow(char **argv) {
        XResizeWindow(dpy, wind(argv[0]), atoi(argv[1]), atoi(argv[2]));
 }
 
+/*
+ *    The options that look at every window use XCB rather than Xlib, so
+ *    they can send all the requests for one level of the tree before
+ *    waiting for any of the replies. That's a handful of round trips
+ *    in total, rather than several per window.
+ */
+
+typedef struct WindowInfo WindowInfo;
+struct WindowInfo {
+    xcb_window_t    id;
+    int    depth;    /* 1 for children of the root, 2 for grandchildren. */
+    int    viewable;
+    int    override_redirect;
+    int    managed;    /* Has WM_STATE, so it's a window manager's client. */
+    int    x, y;    /* Relative to the root. */
+    unsigned    width, height;
+    long    desktop;    /* _NET_WM_DESKTOP, or -1. */
+    char    *wm_name;
+    char    *name;    /* _NET_WM_NAME if there is one, else WM_NAME. */
+    char    *class;    /* "instance.class" from WM_CLASS. */
+};
+
+enum {
+    A_WM_STATE, A_NET_WM_NAME, A_NET_WM_DESKTOP, A_NET_ACTIVE_WINDOW,
+    A_NET_CURRENT_DESKTOP, A_UTF8_STRING, A_COUNT
+};
+
+static char *atom_names[A_COUNT] = {
+    "WM_STATE", "_NET_WM_NAME", "_NET_WM_DESKTOP", "_NET_ACTIVE_WINDOW",
+    "_NET_CURRENT_DESKTOP", "UTF8_STRING"
+};
+
+static xcb_connection_t    *xc;
+static xcb_window_t    xroot;
+static xcb_atom_t    atoms[A_COUNT];
+
+static void
+connectXcb(void) {
+    int screen_number;
+    xcb_screen_iterator_t it;
+    xcb_intern_atom_cookie_t cookies[A_COUNT];
+    int i;
+
+    xc = xcb_connect(NULL, &screen_number);
+    if (xcb_connection_has_error(xc)) {
+        fprintf(stderr, "%s: can't open display.\n", argv0);
+        exit(EXIT_FAILURE);
+    }
+    it = xcb_setup_roots_iterator(xcb_get_setup(xc));
+    for (i = 0; i < screen_number; i++) {
+        xcb_screen_next(&it);
+    }
+    xroot = it.data->root;
+
+    for (i = 0; i < A_COUNT; i++) {
+        cookies[i] = xcb_intern_atom(xc, 0, strlen(atom_names[i]), atom_names[i]);
+    }
+    for (i = 0; i < A_COUNT; i++) {
+        xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(xc, cookies[i], NULL);
+        atoms[i] = reply ? reply->atom : XCB_ATOM_NONE;
+        free(reply);
+    }
+}
+
+static xcb_get_property_cookie_t
+requestProperty(xcb_window_t w, xcb_atom_t property) {
+    return xcb_get_property(xc, 0, w, property, XCB_GET_PROPERTY_TYPE_ANY, 0, 100);
+}
+
+/*
+ *    Returns a NUL-terminated copy of the property's value, or 0. Lists of
+ *    strings (such as WM_CLASS) have their separators replaced by '.'.
+ */
+static char *
+propertyString(xcb_get_property_cookie_t cookie) {
+    xcb_get_property_reply_t *reply;
+    char *result = 0;
+    int length;
+    int i;
+
+    reply = xcb_get_property_reply(xc, cookie, NULL);
+    if (reply == 0) {
+        return 0;
+    }
+    length = xcb_get_property_value_length(reply);
+    /* An empty property is an empty string, as it is to Xlib, not a missing one. */
+    if (reply->format == 8) {
+        result = malloc(length + 1);
+        memcpy(result, xcb_get_property_value(reply), length);
+        /* Lose any trailing NUL, then turn the others into separators. */
+        if (length > 0 && result[length - 1] == '\0') {
+            --length;
+        }
+        for (i = 0; i < length; i++) {
+            if (result[i] == '\0') {
+                result[i] = '.';
+            }
+        }
+        result[length] = '\0';
+    }
+    free(reply);
+    return result;
+}
+
+static long
+propertyCardinal(xcb_get_property_cookie_t cookie, long fallback) {
+    xcb_get_property_reply_t *reply;
+    long result = fallback;
+
+    reply = xcb_get_property_reply(xc, cookie, NULL);
+    if (reply == 0) {
+        return fallback;
+    }
+    if (reply->format == 32 && xcb_get_property_value_length(reply) >= 4) {
+        result = *(uint32_t *) xcb_get_property_value(reply);
+    }
+    free(reply);
+    return result;
+}
+
+/*
+ *    Sends a QueryTree for each of the 'n' windows in 'parents', then
+ *    collects the replies, appending the children to 'kids'.
+ */
+static int
+queryTrees(xcb_window_t *parents, int n, xcb_window_t **kids, int **parent_indexes) {
+    xcb_query_tree_cookie_t *cookies;
+    int nkids = 0;
+    int i;
+
+    cookies = malloc(n * sizeof *cookies);
+    for (i = 0; i < n; i++) {
+        cookies[i] = xcb_query_tree(xc, parents[i]);
+    }
+    *kids = 0;
+    *parent_indexes = 0;
+    for (i = 0; i < n; i++) {
+        xcb_query_tree_reply_t *reply = xcb_query_tree_reply(xc, cookies[i], NULL);
+        int count;
+        int j;
+
+        if (reply == 0) {
+            continue;
+        }
+        count = xcb_query_tree_children_length(reply);
+        *kids = realloc(*kids, (nkids + count) * sizeof **kids);
+        *parent_indexes = realloc(*parent_indexes, (nkids + count) * sizeof **parent_indexes);
+        for (j = 0; j < count; j++) {
+            (*kids)[nkids] = xcb_query_tree_children(reply)[j];
+            (*parent_indexes)[nkids] = i;
+            ++nkids;
+        }
+        free(reply);
+    }
+    free(cookies);
+    return nkids;
+}
+
+/*
+ *    Fills in everything we know how to show about every child and
+ *    grandchild of the root. With a reparenting window manager, the
+ *    clients are the grandchildren; without one, they're the children.
+ */
+static int
+snapshot(WindowInfo **result) {
+    xcb_window_t *top;
+    xcb_window_t *second;
+    int *top_parents;
+    int *second_parents;
+    int ntop, nsecond, n;
+    xcb_window_t *ids;
+    WindowInfo *info;
+    xcb_get_window_attributes_cookie_t *attr_cookies;
+    xcb_get_geometry_cookie_t *geometry_cookies;
+    xcb_get_property_cookie_t *property_cookies;
+    int i;
+
+    ntop = queryTrees(&xroot, 1, &top, &top_parents);
+    nsecond = queryTrees(top, ntop, &second, &second_parents);
+
+    n = ntop + nsecond;
+    ids = malloc(n * sizeof *ids);
+    info = calloc(n, sizeof *info);
+    memcpy(ids, top, ntop * sizeof *ids);
+    memcpy(ids + ntop, second, nsecond * sizeof *ids);
+
+    /* Ask about everything at once... */
+    attr_cookies = malloc(n * sizeof *attr_cookies);
+    geometry_cookies = malloc(n * sizeof *geometry_cookies);
+    property_cookies = malloc(5 * n * sizeof *property_cookies);
+    for (i = 0; i < n; i++) {
+        attr_cookies[i] = xcb_get_window_attributes(xc, ids[i]);
+        geometry_cookies[i] = xcb_get_geometry(xc, ids[i]);
+        property_cookies[5*i + 0] = requestProperty(ids[i], atoms[A_WM_STATE]);
+        property_cookies[5*i + 1] = requestProperty(ids[i], XCB_ATOM_WM_NAME);
+        property_cookies[5*i + 2] = requestProperty(ids[i], atoms[A_NET_WM_NAME]);
+        property_cookies[5*i + 3] = requestProperty(ids[i], XCB_ATOM_WM_CLASS);
+        property_cookies[5*i + 4] = requestProperty(ids[i], atoms[A_NET_WM_DESKTOP]);
+    }
+
+    /* ...then collect the answers. */
+    for (i = 0; i < n; i++) {
+        WindowInfo *w = &info[i];
+        xcb_get_window_attributes_reply_t *attr;
+        xcb_get_geometry_reply_t *geometry;
+        xcb_get_property_reply_t *wm_state;
+
+        w->id = ids[i];
+        w->depth = (i < ntop) ? 1 : 2;
+        attr = xcb_get_window_attributes_reply(xc, attr_cookies[i], NULL);
+        if (attr) {
+            w->viewable = (attr->map_state == XCB_MAP_STATE_VIEWABLE);
+            w->override_redirect = attr->override_redirect;
+            free(attr);
+        }
+        geometry = xcb_get_geometry_reply(xc, geometry_cookies[i], NULL);
+        if (geometry) {
+            w->x = geometry->x;
+            w->y = geometry->y;
+            w->width = geometry->width;
+            w->height = geometry->height;
+            free(geometry);
+        }
+        wm_state = xcb_get_property_reply(xc, property_cookies[5*i + 0], NULL);
+        w->managed = (wm_state != 0 && wm_state->type != XCB_ATOM_NONE);
+        free(wm_state);
+        w->wm_name = propertyString(property_cookies[5*i + 1]);
+        w->name = propertyString(property_cookies[5*i + 2]);
+        if (w->name == 0 && w->wm_name != 0) {
+            w->name = strdup(w->wm_name);
+        }
+        w->class = propertyString(property_cookies[5*i + 3]);
+        w->desktop = propertyCardinal(property_cookies[5*i + 4], -1);
+    }
+
+    /* Grandchildren's positions are relative to their parents. */
+    for (i = 0; i < nsecond; i++) {
+        info[ntop + i].x += info[second_parents[i]].x;
+        info[ntop + i].y += info[second_parents[i]].y;
+    }
+
+    free(attr_cookies);
+    free(geometry_cookies);
+    free(property_cookies);
+    free(ids);
+    free(top);
+    free(top_parents);
+    free(second);
+    free(second_parents);
+    *result = info;
+    return n;
+}
+
+static void
+freeSnapshot(WindowInfo *info, int n) {
+    int i;
+
+    for (i = 0; i < n; i++) {
+        free(info[i].wm_name);
+        free(info[i].name);
+        free(info[i].class);
+    }
+    free(info);
+}
+
 static void    
 ListWindows(char **argv) {
-    Window* kids;
-    unsigned i;
-    unsigned nkids;
+    WindowInfo *info;
+    int n;
+    int i;
 
     (void) argv;
-    nkids = listwindows(DefaultRootWindow(dpy), &kids);
-
-    for (i = 0; i < nkids; i++) {
-        Window* kids2;
-        unsigned nkids2;
-	unsigned i2;
+    connectXcb();
+    n = snapshot(&info);
+    for (i = 0; i < n; i++) {
+        if (info[i].depth == 2 && info[i].override_redirect == 0 && info[i].viewable) {
+            printf("%#x\t%s\n", (unsigned) info[i].id, info[i].wm_name ? info[i].wm_name : "(none)");
+        }
+    }
+    freeSnapshot(info, n);
+}
 
-        nkids2 = listwindows(kids[i], &kids2);
+static void
+FindWindows(char **argv) {
+    char *field = argv[0];
+    regex_t re;
+    WindowInfo *info;
+    int n;
+    int i;
+
+    if (strcmp(field, "name") != 0 && strcmp(field, "class") != 0 && strcmp(field, "desktop") != 0) {
+        fprintf(stderr, "%s: can't match on '%s'; try name, class, or desktop\n", argv0, field);
+        exit(EXIT_FAILURE);
+    }
+    if (regcomp(&re, argv[1], REG_EXTENDED | REG_NOSUB) != 0) {
+        fprintf(stderr, "%s: bad regular expression '%s'\n", argv0, argv[1]);
+        exit(EXIT_FAILURE);
+    }
 
-        for (i2 = 0; i2 < nkids2; i2++) {
-            XWindowAttributes attr;
+    connectXcb();
+    n = snapshot(&info);
+    for (i = 0; i < n; i++) {
+        WindowInfo *w = &info[i];
+        char desktop[32];
+        char *value;
 
-            XGetWindowAttributes(dpy, kids2[i2], &attr);
-            if(attr.override_redirect == 0 && attr.map_state == IsViewable)
-                printwindowname(kids2[i2]);
+        if (w->managed == 0) {
+            continue;
         }
+        sprintf(desktop, "%ld", w->desktop);
+        if (strcmp(field, "name") == 0) {
+            value = w->name;
+        } else if (strcmp(field, "class") == 0) {
+            value = w->class;
+        } else {
+            value = desktop;
+        }
+        if (regexec(&re, value ? value : "", 0, 0, 0) == 0) {
+            printf("%#x\t%s\t%ux%u+%d+%d\t%s\t%s\n", (unsigned) w->id, desktop,
+                w->width, w->height, w->x, w->y,
+                w->class ? w->class : "(none)", w->name ? w->name : "(none)");
+        }
+    }
+    freeSnapshot(info, n);
+    regfree(&re);
+}
+
+static void
+selectEvents(xcb_window_t w, uint32_t mask) {
+    xcb_change_window_attributes(xc, w, XCB_CW_EVENT_MASK, &mask);
+}
 
-        if(kids2)
-            XFree(kids2);
+static void
+printEvent(char *what, xcb_window_t w) {
+    char *name = propertyString(requestProperty(w, atoms[A_NET_WM_NAME]));
+
+    if (name == 0) {
+        name = propertyString(requestProperty(w, XCB_ATOM_WM_NAME));
     }
+    printf("%s\t%#x\t%s\n", what, (unsigned) w, name ? name : "(none)");
+    fflush(stdout);
+    free(name);
+}
+
+/*
+ *    Rather than have scripts poll -list, this reports changes as they
+ *    happen, one line per change, until the display goes away.
+ */
+static void
+WatchWindows(char **argv) {
+    WindowInfo *info;
+    xcb_generic_event_t *ev;
+    int n;
+    int i;
 
-    if(kids)
-        XFree(kids);
+    (void) argv;
+    connectXcb();
+    selectEvents(xroot, XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE);
+    n = snapshot(&info);
+    for (i = 0; i < n; i++) {
+        /* Frames tell us about their clients; clients about their names. */
+        selectEvents(info[i].id, XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE);
+    }
+    freeSnapshot(info, n);
+    xcb_flush(xc);
+
+    while ((ev = xcb_wait_for_event(xc)) != 0) {
+        switch (ev->response_type & ~0x80) {
+        case XCB_CREATE_NOTIFY:
+            {
+                xcb_create_notify_event_t *e = (xcb_create_notify_event_t *) ev;
+                if (e->parent == xroot) {
+                    selectEvents(e->window, XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE);
+                }
+            }
+            break;
+        case XCB_REPARENT_NOTIFY:
+            {
+                xcb_reparent_notify_event_t *e = (xcb_reparent_notify_event_t *) ev;
+                selectEvents(e->window, XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE);
+            }
+            break;
+        case XCB_MAP_NOTIFY:
+            {
+                xcb_map_notify_event_t *e = (xcb_map_notify_event_t *) ev;
+                if (e->override_redirect == 0) {
+                    printEvent("mapped", e->window);
+                }
+            }
+            break;
+        case XCB_UNMAP_NOTIFY:
+            {
+                xcb_unmap_notify_event_t *e = (xcb_unmap_notify_event_t *) ev;
+                printf("unmapped\t%#x\n", (unsigned) e->window);
+                fflush(stdout);
+            }
+            break;
+        case XCB_DESTROY_NOTIFY:
+            {
+                xcb_destroy_notify_event_t *e = (xcb_destroy_notify_event_t *) ev;
+                printf("destroyed\t%#x\n", (unsigned) e->window);
+                fflush(stdout);
+            }
+            break;
+        case XCB_PROPERTY_NOTIFY:
+            {
+                xcb_property_notify_event_t *e = (xcb_property_notify_event_t *) ev;
+                if (e->window == xroot && e->atom == atoms[A_NET_ACTIVE_WINDOW]) {
+                    long active = propertyCardinal(requestProperty(xroot, e->atom), 0);
+                    if (active != 0) {
+                        printEvent("active", (xcb_window_t) active);
+                    }
+                } else if (e->window == xroot && e->atom == atoms[A_NET_CURRENT_DESKTOP]) {
+                    printf("desktop\t%ld\n", propertyCardinal(requestProperty(xroot, e->atom), -1));
+                    fflush(stdout);
+                } else if (e->atom == XCB_ATOM_WM_NAME || e->atom == atoms[A_NET_WM_NAME]) {
+                    if (e->state == XCB_PROPERTY_NEW_VALUE) {
+                        printEvent("named", e->window);
+                    }
+                }
+            }
+            break;
+        }
+        free(ev);
+        xcb_flush(xc);
+    }
 }
 
 static void
@@ -284,24 +676,26 @@ CirculateDown(char ** argv) {
 
 static ReasonDesc reasons[] = 
 {
-    { "-move",     3,     MoveWindow,        "<id> <x> <y>" },
-    { "-resize",     3,     ResizeWindow,        "<id> <x> <y>" },
-    { "-raise",         1,     RaiseWindow,        "<id>" },
-    { "-label",        2,    LabelWindow,        "<id> <text>" },
-    { "-lower",     1,     LowerWindow,        "<id>" },
-    { "-kill",         1,     KillWindow,        "<id>" },
-    { "-hide",         1,     HideWindow,        "<id>" },
-    { "-unhide",     1,     UnhideWindow,    "<id>" },
-    { "-where",     1,     WhereWindow,        "<id>" },
-    { "-list",         0,     ListWindows,        "" },
-    { "-getprop",    2,    GetProperty,        "<id> <name>" },
-    { "-setprop",    3,    SetProperty,        "<id> <name> <value>" },
-    { "-warppointer", 3,    WarpPointer,        "<id> <x> <y>" },
-    { "-getfocuswindow", 0,    GetFocusWindow,    "" },
-    { "-getsel",    0,    GetSelection,        "" },
-    { "-delsel",    0,    DeleteSelection,    "" },
-    { "-circup",    0,    CirculateUp,        "" },
-    { "-circdown",    0,    CirculateDown,        "" },
+    { "-move",     3,     MoveWindow,        "<id> <x> <y>", False },
+    { "-resize",     3,     ResizeWindow,        "<id> <x> <y>", False },
+    { "-raise",         1,     RaiseWindow,        "<id>", False },
+    { "-label",        2,    LabelWindow,        "<id> <text>", False },
+    { "-lower",     1,     LowerWindow,        "<id>", False },
+    { "-kill",         1,     KillWindow,        "<id>", False },
+    { "-hide",         1,     HideWindow,        "<id>", False },
+    { "-unhide",     1,     UnhideWindow,    "<id>", False },
+    { "-where",     1,     WhereWindow,        "<id>", False },
+    { "-list",         0,     ListWindows,        "", True },
+    { "-find",         2,     FindWindows,        "name|class|desktop <regex>", True },
+    { "-watch",        0,     WatchWindows,       "", True },
+    { "-getprop",    2,    GetProperty,        "<id> <name>", False },
+    { "-setprop",    3,    SetProperty,        "<id> <name> <value>", False },
+    { "-warppointer", 3,    WarpPointer,        "<id> <x> <y>", False },
+    { "-getfocuswindow", 0,    GetFocusWindow,    "", False },
+    { "-getsel",    0,    GetSelection,        "", False },
+    { "-delsel",    0,    DeleteSelection,    "", False },
+    { "-circup",    0,    CirculateUp,        "", False },
+    { "-circdown",    0,    CirculateDown,        "", False },
 };
 
 static int
@@ -327,14 +721,6 @@ main(int argc, char * argv[]) {
     
     argv0 = argv[0];
     
-    dpy = XOpenDisplay("");
-    if (dpy == 0) {
-        fprintf(stderr, "%s: can't open display.\n", argv0);
-        exit(EXIT_FAILURE);
-    }
-    
-    XSetErrorHandler(handler);
-    
     if (argc > 1) {
         for (p = reasons; p < reasons + sizeof reasons / sizeof reasons[0]; p++) {
             if (strcmp(p->name, argv[1]) == 0) {
@@ -343,6 +729,17 @@ main(int argc, char * argv[]) {
                         argv0, argv[1], p->nargs, p->nargs > 1 ? "s" : "");
                     exit(EXIT_FAILURE);
                 }
+                if (p->usesXcb) {
+                    p->fn(argv + 2);
+                    xcb_disconnect(xc);
+                    return EXIT_SUCCESS;
+                }
+                dpy = XOpenDisplay("");
+                if (dpy == 0) {
+                    fprintf(stderr, "%s: can't open display.\n", argv0);
+                    exit(EXIT_FAILURE);
+                }
+                XSetErrorHandler(handler);
                 p->fn(argv + 2);
                 XSync(dpy, True);
                 return EXIT_SUCCESS;